@@ -0,0 +1,112 @@
+#include "AssetPipeline.h"
+#include <chrono>
+#include <algorithm>
+
+AssetPipeline::AssetPipeline(unsigned int threadCount) : runningJobs(0), stopping(false)
+{
+    threadCount = max(threadCount, 1u);
+    for (unsigned int i = 0; i < threadCount; ++i)
+    {
+        workers.emplace_back(&AssetPipeline::workerLoop, this);
+    }
+}
+
+AssetPipeline::~AssetPipeline()
+{
+    {
+        lock_guard<mutex> lock(workerMutex);
+        stopping = true;
+        workerJobs.clear();
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers)
+    {
+        worker.join();
+    }
+}
+
+void AssetPipeline::runOnWorker(function<void()> job)
+{
+    {
+        lock_guard<mutex> lock(workerMutex);
+        if (stopping)
+        {
+            return;
+        }
+        workerJobs.push_back(move(job));
+    }
+    workAvailable.notify_one();
+}
+
+void AssetPipeline::runOnRenderThread(function<void()> job)
+{
+    lock_guard<mutex> lock(renderMutex);
+    renderJobs.push_back(move(job));
+}
+
+//Hver arbeidstråd venter på neste jobb i køen og kjører den utenfor låsen
+void AssetPipeline::workerLoop()
+{
+    while (true)
+    {
+        function<void()> job;
+        {
+            unique_lock<mutex> lock(workerMutex);
+            workAvailable.wait(lock, [this] { return stopping || !workerJobs.empty(); });
+            if (stopping)
+            {
+                return;
+            }
+            job = move(workerJobs.front());
+            workerJobs.pop_front();
+            ++runningJobs;
+        }
+
+        job();
+        --runningJobs;
+    }
+}
+
+size_t AssetPipeline::processRenderJobs(double budgetMilliseconds)
+{
+    auto startTime = chrono::steady_clock::now();
+    size_t processed = 0;
+
+    while (true)
+    {
+        function<void()> job;
+        {
+            lock_guard<mutex> lock(renderMutex);
+            if (renderJobs.empty())
+            {
+                break;
+            }
+            job = move(renderJobs.front());
+            renderJobs.pop_front();
+        }
+
+        job();
+        ++processed;
+
+        double elapsed = chrono::duration<double, milli>(chrono::steady_clock::now() - startTime).count();
+        if (elapsed >= budgetMilliseconds)
+        {
+            break;
+        }
+    }
+    return processed;
+}
+
+size_t AssetPipeline::pendingJobs() const
+{
+    size_t pending = runningJobs;
+    {
+        lock_guard<mutex> lock(workerMutex);
+        pending += workerJobs.size();
+    }
+    {
+        lock_guard<mutex> lock(renderMutex);
+        pending += renderJobs.size();
+    }
+    return pending;
+}
@@ -0,0 +1,54 @@
+#ifndef ASSETPIPELINE_H
+#define ASSETPIPELINE_H
+
+#include <functional>
+#include <deque>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+using namespace std;
+
+//Laster inn ressurser (punktskyer, teksturer osv.) i bakgrunnen mens vinduet allerede viser scenen.
+//Det tunge arbeidet (lese filer, redusere, triangulere, regne normaler) kjøres på arbeidstrådene.
+//Alt som bruker OpenGL må kjøres på tråden som eier konteksten, så disse jobbene legges i en egen kø
+//som render-løkken tømmer litt av hver frame, innenfor et tidsbudsjett.
+class AssetPipeline
+{
+public:
+    AssetPipeline(unsigned int threadCount = 2);
+    //Venter til jobbene som kjører er ferdige. Jobber som ikke er startet blir ikke kjørt.
+    ~AssetPipeline();
+
+    AssetPipeline(const AssetPipeline&) = delete;
+    AssetPipeline& operator=(const AssetPipeline&) = delete;
+
+    //Kjører jobben på en av arbeidstrådene. Jobben kan selv legge til nye jobber (neste steg).
+    void runOnWorker(function<void()> job);
+    //Kjører jobben på render-tråden neste gang processRenderJobs kalles. Kan kalles fra alle tråder.
+    void runOnRenderThread(function<void()> job);
+
+    //Kalles fra render-løkken hver frame. Kjører GL-jobber til budsjettet er brukt opp, men alltid minst én,
+    //slik at opplastingen kommer videre selv om én jobb tar lengre tid enn budsjettet. Returnerer antall jobber.
+    size_t processRenderJobs(double budgetMilliseconds);
+
+    //Antall jobber som ikke er ferdige, både på arbeidstrådene og på render-tråden
+    size_t pendingJobs() const;
+    bool isIdle() const { return pendingJobs() == 0; }
+
+private:
+    void workerLoop();
+
+    vector<thread> workers;
+    deque<function<void()>> workerJobs;
+    deque<function<void()>> renderJobs;
+    mutable mutex workerMutex;
+    mutable mutex renderMutex;
+    condition_variable workAvailable;
+    atomic<size_t> runningJobs;
+    bool stopping;
+};
+
+#endif
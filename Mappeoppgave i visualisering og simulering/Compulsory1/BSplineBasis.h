@@ -0,0 +1,107 @@
+#ifndef BSPLINEBASIS_H
+#define BSPLINEBASIS_H
+
+#include <vector>
+#include <algorithm>
+
+using namespace std;
+
+//Hjelpefunksjoner for B-spline basisfunksjoner med skjøtvektor knots og grad degree, der controlCount er antall
+//kontrollpunkter (knots.size() == controlCount + degree + 1). Bare degree + 1 basisfunksjoner er forskjellige fra
+//null for en parameterverdi, så i stedet for å regne ut alle (rekursivt) finnes intervallet parameteren ligger i,
+//og de degree + 1 verdiene regnes ut der.
+//Referanse Piegl og Tiller, "The NURBS Book" (1997), algoritme A2.1 og A2.2
+
+//Den høyeste graden basisFunctionsAt kan regne ut
+const int maxBasisDegree = 7;
+
+//Skjøtvektor med degree + 1 like skjøter i hver ende (flaten går gjennom hjørnene) og jevn avstand mellom de
+//indre skjøtene. Verdiene går fra 0 til controlCount - degree, som skjøtvektorene i main.cpp.
+inline vector<float> clampedUniformKnots(int controlCount, int degree)
+{
+    vector<float> knots(controlCount + degree + 1);
+    for (int i = 0; i < static_cast<int>(knots.size()); ++i)
+    {
+        knots[i] = static_cast<float>(min(max(i - degree, 0), controlCount - degree));
+    }
+    return knots;
+}
+
+//Intervallet [knots[span], knots[span + 1]) som t ligger i, med degree <= span < controlCount. Verdier utenfor
+//definisjonsområdet [knots[degree], knots[controlCount]] havner i det første eller siste intervallet.
+//Binærsøk, så det tar log(controlCount) steg.
+inline int findKnotSpan(const vector<float>& knots, int degree, int controlCount, float t)
+{
+    if (t >= knots[controlCount])
+    {
+        //Det siste intervallet med lengde, slik at t = slutten av området gir det siste kontrollpunktet
+        int span = controlCount - 1;
+        while (span > degree && knots[span] >= knots[span + 1])
+        {
+            --span;
+        }
+        return span;
+    }
+    if (t <= knots[degree])
+    {
+        int span = degree;
+        while (span < controlCount - 1 && knots[span + 1] <= knots[degree])
+        {
+            ++span;
+        }
+        return span;
+    }
+    //upper_bound gir den første skjøten som er større enn t, og intervallet starter skjøten før
+    auto first = knots.begin() + degree;
+    auto last = knots.begin() + controlCount + 1;
+    return static_cast<int>(upper_bound(first, last, t) - knots.begin()) - 1;
+}
+
+//Som findKnotSpan, men intervallet hint sjekkes først. Parametere som evalueres etter hverandre ligger som regel i
+//samme intervall, så binærsøket kan ofte hoppes over. hint er et tidligere svar, eller -1 hvis det ikke finnes. 
+inline int findKnotSpan(const vector<float>& knots, int degree, int controlCount, float t, int hint)
+{
+    if (hint >= degree && hint < controlCount && knots[hint] <= t && t < knots[hint + 1])
+    {
+        return hint;
+    }
+    return findKnotSpan(knots, degree, controlCount, t);
+}
+
+//De degree + 1 basisfunksjonene som ikke er null i intervallet span, N[span - degree + i](t) i values[i].
+//Regnes ut nedenfra (Cox-de Boor trekanten) med én gjennomgang per grad, så hver lavere grad regnes ut bare
+//én gang. values må ha plass til degree + 1 verdier. degree kan være høyst maxBasisDegree.
+template <class Real>
+void basisFunctionsAt(const vector<float>& knots, int span, int degree, Real t, Real* values)
+{
+    Real left[maxBasisDegree + 1], right[maxBasisDegree + 1];
+    values[0] = 1;
+    for (int j = 1; j <= degree; ++j)
+    {
+        left[j] = t - static_cast<Real>(knots[span + 1 - j]);
+        right[j] = static_cast<Real>(knots[span + j]) - t;
+        Real saved = 0;
+        for (int r = 0; r < j; ++r)
+        {
+            Real denominator = right[r + 1] + left[j - r];
+            Real temp = denominator != 0 ? values[r] / denominator : 0;
+            values[r] = saved + right[r + 1] * temp;
+            saved = left[j - r] * temp;
+        }
+        values[j] = saved;
+    }
+}
+
+//Gjennomsnittet av de degree skjøtene etter skjøt i (Greville-abscisse). Kontrollpunkter plassert her gir en
+//flate der parameteren er en lineær funksjon av posisjonen.
+inline float grevilleAbscissa(const vector<float>& knots, int degree, int i)
+{
+    float sum = 0.0f;
+    for (int k = 1; k <= degree; ++k)
+    {
+        sum += knots[i + k];
+    }
+    return degree > 0 ? sum / degree : knots[i];
+}
+
+#endif
@@ -1,318 +1,976 @@
 #include "BilinearSurface.h"
+#include "PointCloudLoader.h"
+#include "PointCloudCache.h"
+#include "LasReader.h"
+#include "GridReducer.h"
+#include "ParallelDelaunay.h"
+#include "GridDelaunay.h"
+#include "Parallel.h"
 #include <algorithm>
 #include <iostream>
 
 BilinearSurface::BilinearSurface() : VAO(0), VBO(0), EBO(0), VAONormals(0), VBONormals(0),
-VAOPoints(0), VBOPoints(0), VAOControlPoints(0), VBOControlPoints(0){}
+VAOPoints(0), VBOPoints(0), VBOPointNormals(0), VAOControlPoints(0), VBOControlPoints(0), pointNormalsEnabled(false),
+pointNormalNeighbourCount(16), quantizePoints(false),
+reductionAggregation(CellAggregation::First), pyramidLevelCount(1), triangulationThreads(1),
+normalWeighting(NormalWeighting::Area), requestedLevel(0), shownLevel(0),
+surfaceReady(false), editOrigin(0.0), vertexBufferCapacity(0), elementBufferCapacity(0), pointBufferCapacity(0),
+normalBufferCapacity(0), pointNormalBufferCapacity(0){}
 
 BilinearSurface::~BilinearSurface()
 {
     cleanup();
 }
 
-void BilinearSurface::loadFunctions(const string& filename, float reductionCellSize) 
+void BilinearSurface::loadFunctions(const string& filename, float reductionCellSize, bool streamingIngest) 
 {
-    points = loadsPointsFromTextfile(filename);
-    points = reducePoints(points, reductionCellSize);
+    if (loadCachedSurface({ filename }, reductionCellSize))
+    {
+        return;
+    }
+
+    //Bruker den binære cachen hvis filen er lest før og ikke har endret seg. LAS-filer leses direkte,
+    //alle andre filer leses som tekstfiler med x, y og z på hver linje.
+    PointCloud cloud;
+    if (PointCloudCache::load(filename, tileTransform(), cloud))
+    {
+        points = reducePoints(cloud, reductionCellSize);
+    }
+    else if (streamingIngest)
+    {
+        points = reducePointsStreaming(filename, reductionCellSize);
+    }
+    else
+    {
+        cloud = LasReader::isLasFile(filename) ? loadsPointsFromLasFile(filename) : loadsPointsFromTextfile(filename);
+        //En tom punktsky betyr at filen ikke kunne leses, og skal ikke lagres som en gyldig cache 
+        if (!cloud.empty())
+        {
+            PointCloudCache::save(filename, tileTransform(), cloud);
+        }
+        points = reducePoints(cloud, reductionCellSize);
+    }
 
-    triangles = delaunayTriangulation(points);
-    vertices = Normals(points, triangles);
+    buildPyramid(reductionCellSize);
+    buildSurface();
+    saveCachedSurface({ filename }, reductionCellSize);
+}
 
-    for (const auto& vertex : vertices) 
+//Leser flisene fra katalogen parallelt inn i én punktsky og bygger flaten av alle sammen 
+void BilinearSurface::loadTileFunctions(const TileCatalog& catalog, const vector<TileInfo>& tiles, float reductionCellSize)
+{
+    vector<string> filenames;
+    for (const TileInfo& tile : tiles)
+    {
+        filenames.push_back(tile.filename);
+    }
+    if (loadCachedSurface(filenames, reductionCellSize))
     {
-        glm::vec3 start = vertex.position;
-        glm::vec3 end = start + vertex.normal * 0.001f;
-        normalLines.push_back(start);
-        normalLines.push_back(end);
+        return;
     }
 
-    controlPoints = calculateControlPoints(points, triangles);
+    PointCloud cloud = catalog.loadTiles(tiles);
+    points = reducePoints(cloud, reductionCellSize);
+    buildPyramid(reductionCellSize);
+    buildSurface();
+    saveCachedSurface(filenames, reductionCellSize);
+}
 
-    setupPointBuffers();
-    setupBuffers();
-    setupNormalBuffers();
-    setupControlPointBuffers(); 
+//Samme steg som loadFunctions, men i bakgrunnen. Cachen, loadCloud, reduksjonen, trianguleringen, normalene og
+//kontrollpunktene kjøres på en arbeidstråd. Etter hvert steg legges opplastingen av bufferne i køen til
+//render-tråden, slik at punktene vises først, deretter flaten og til slutt kontrollpunktene. Kommer flaten fra
+//cachen lastes alle bufferne opp i én jobb. 
+//Objektet må leve til pipelinen er ferdig. 
+void BilinearSurface::loadFunctionsAsync(AssetPipeline& pipeline, function<SurfaceSource()> findSource, float reductionCellSize)
+{
+    pipeline.runOnWorker([this, &pipeline, findSource, reductionCellSize]()
+    {
+        SurfaceSource source = findSource();
+        if (readCachedSurface(source.filenames, reductionCellSize))
+        {
+            pipeline.runOnRenderThread([this]() { setupSurfaceBuffers(); });
+            return;
+        }
+
+        {
+            PointCloud cloud = source.loadCloud();
+            points = reducePoints(cloud, reductionCellSize);
+        }
+        buildPyramid(reductionCellSize);
+        quantizeReducedPoints();
+        computePointNormals();
+        pipeline.runOnRenderThread([this]() { setupPointBuffers(); });
+
+        triangulateSurface();
+        pipeline.runOnRenderThread([this]() { setupBuffers(); });
+        pipeline.runOnRenderThread([this]() { setupNormalBuffers(); });
+
+        fitControlPoints();
+        //Lagres før flaten markeres som klar, siden et bytte av nivå på render-tråden da kan endre den 
+        saveCachedSurface(source.filenames, reductionCellSize);
+        pipeline.runOnRenderThread([this]()
+        {
+            setupControlPointBuffers();
+            surfaceReady = true;
+        });
+    });
 }
 
-//Referanse https://www.geeksforgeeks.org/how-to-read-from-a-file-in-cpp/
-vector<glm::vec3> BilinearSurface::loadsPointsFromTextfile(const string& filename) 
+//Bygger nivået i et eget BilinearSurface-objekt på en arbeidstråd, mens det gamle nivået fortsatt vises.
+//Bufferne lastes opp og byttes inn i én jobb på render-tråden, så det vises aldri et halvferdig nivå.
+//Blir et annet nivå valgt før dette er ferdig, blir dette kastet. 
+bool BilinearSurface::selectPyramidLevel(AssetPipeline& pipeline, int level)
 {
-    ifstream inFile(filename);
-    vector<glm::vec3> points;
+    if (!surfaceReady || level < 0 || level >= pyramid.levelCount() || level == requestedLevel)
+    {
+        return false;
+    }
+    if (isEditing())
+    {
+        cout << "Kan ikke bytte nivå mens punktene endres. Kall finishEditing først." << endl;
+        return false;
+    }
+    requestedLevel = level;
+
+    shared_ptr<BilinearSurface> next = make_shared<BilinearSurface>();
+    next->quantizePoints = quantizePoints;
+    next->reductionAggregation = reductionAggregation;
+    next->triangulationThreads = triangulationThreads;
+    next->normalWeighting = normalWeighting;
+    next->pointNormalsEnabled = pointNormalsEnabled;
+    next->pointNormalNeighbourCount = pointNormalNeighbourCount;
+    next->surfaceFitSettings = surfaceFitSettings;
+
+    pipeline.runOnWorker([this, &pipeline, next, level]()
+    {
+        next->points = pyramid.levelPoints(level);
+        next->quantizeReducedPoints();
+        next->computePointNormals();
+        next->triangulateSurface();
+        next->fitControlPoints();
 
-    if (!inFile.is_open()) 
+        pipeline.runOnRenderThread([this, next, level]()
+        {
+            if (level != requestedLevel)
+            {
+                return;
+            }
+            //Endringene som er startet etter at nivået ble valgt beholdes, og det nye nivået kastes 
+            if (isEditing())
+            {
+                cout << "Nivå " << level << " ble ikke byttet inn fordi punktene endres" << endl;
+                requestedLevel = shownLevel;
+                return;
+            }
+            next->setupPointBuffers();
+            next->setupBuffers();
+            next->setupNormalBuffers();
+            next->setupControlPointBuffers();
+            swapSurface(*next);
+            shownLevel = level;
+            //De gamle bufferne ligger nå i next og slettes her, på tråden som eier GL-konteksten 
+            next->cleanup();
+            cout << "Byttet til nivå " << level << " (cellestørrelse " << pyramid.cellSize(level) << ")" << endl;
+        });
+    });
+    return true;
+}
+
+//Nivåene over nivå 0 lages bare hvis det er valgt mer enn ett nivå 
+void BilinearSurface::buildPyramid(float reductionCellSize)
+{
+    if (pyramidLevelCount > 1)
     {
-        return points;
+        pyramid.build(points, reductionCellSize, pyramidLevelCount, reductionAggregation);
     }
+    requestedLevel = 0;
+    shownLevel = 0;
+}
 
-    size_t numPoints;
-    inFile >> numPoints;
+//Bytter alt som hører til ett nivå (punkter, triangulering og buffere) med other 
+void BilinearSurface::swapSurface(BilinearSurface& other)
+{
+    swap(VAO, other.VAO);
+    swap(VBO, other.VBO);
+    swap(EBO, other.EBO);
+    swap(VAONormals, other.VAONormals);
+    swap(VBONormals, other.VBONormals);
+    swap(VAOPoints, other.VAOPoints);
+    swap(VBOPoints, other.VBOPoints);
+    swap(VBOPointNormals, other.VBOPointNormals);
+    swap(VAOControlPoints, other.VAOControlPoints);
+    swap(VBOControlPoints, other.VBOControlPoints);
+    vertices.swap(other.vertices);
+    swap(mesh, other.mesh);
+    normalLines.swap(other.normalLines);
+    points.swap(other.points);
+    controlPoints.swap(other.controlPoints);
+    swap(fittedSurface, other.fittedSurface);
+    swap(pointIndex, other.pointIndex);
+    pointNormals.swap(other.pointNormals);
+    pointVariations.swap(other.pointVariations);
+    swap(quantizedPoints, other.quantizedPoints);
+    swap(editor, other.editor);
+    swap(editOrigin, other.editOrigin);
+    editTriangles.swap(other.editTriangles);
+    swap(vertexBufferCapacity, other.vertexBufferCapacity);
+    swap(elementBufferCapacity, other.elementBufferCapacity);
+    swap(pointBufferCapacity, other.pointBufferCapacity);
+    swap(normalBufferCapacity, other.normalBufferCapacity);
+    swap(pointNormalBufferCapacity, other.pointNormalBufferCapacity);
+}
 
-    float x, y, z;
-    const float xScale = 0.0001f;
-    const float yScale = 0.0001f;
-    const float zScale = 0.0002f;
-    const glm::vec3 translationOffset(-59.0f, -663.0f, 0.0f);
+//Laster opp elementene med indeksene i indices (sortert). Indekser som ligger etter hverandre lastes opp samlet.
+//Er bufferen for liten, lages den på nytt med plass til 50 % flere elementer, og alt lastes opp. 
+static void uploadElements(GLuint buffer, size_t& capacity, const void* data, size_t elementSize, size_t count,
+    const vector<size_t>& indices)
+{
+    const char* bytes = static_cast<const char*>(data);
+    size_t size = count * elementSize;
+    glBindBuffer(GL_COPY_WRITE_BUFFER, buffer);
+    if (size > capacity)
+    {
+        capacity = size + size / 2;
+        glBufferData(GL_COPY_WRITE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+        glBufferSubData(GL_COPY_WRITE_BUFFER, 0, size, bytes);
+    }
+    else
+    {
+        size_t i = 0;
+        while (i < indices.size() && indices[i] < count)
+        {
+            size_t begin = indices[i];
+            size_t end = begin + 1;
+            while (++i < indices.size() && indices[i] == end && end < count)
+            {
+                ++end;
+            }
+            glBufferSubData(GL_COPY_WRITE_BUFFER, begin * elementSize, (end - begin) * elementSize, bytes + begin * elementSize);
+        }
+    }
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
+}
 
-    while (inFile >> x >> y >> z) 
+//Trianguleringen lages på nytt serielt i en DelaunayTriangulator som kan endres. Bufferne for punktene får
+//plass til flere punkter, og EBO skrives om til én trekant per plass i trianguleringen. 
+bool BilinearSurface::beginEditing()
+{
+    if (editor)
     {
-        glm::vec3 point(x * xScale, y * yScale, z * zScale);
-        point += translationOffset;
-        points.push_back(point);
+        return true;
     }
+    if (!surfaceReady || VAO == 0)
+    {
+        return false;
+    }
+
+    editor = make_unique<DelaunayTriangulator>();
+    editOrigin = planarOrigin();
+    editor->triangulate(planarPoints());
+    editor->clearChangedTriangles();
 
-    inFile.close();
-    return points;
+    editTriangles.resize(editor->triangleSlotCount());
+    for (size_t t = 0; t < editTriangles.size(); ++t)
+    {
+        editTriangles[t] = editor->drawableTriangle(static_cast<int>(t));
+    }
+    //Kapasitet 0 gjør at alt lastes opp på nytt med ekstra plass 
+    vertexBufferCapacity = elementBufferCapacity = pointBufferCapacity = normalBufferCapacity = 0;
+    pointNormalBufferCapacity = 0;
+    vector<size_t> changedVertices;
+    updateEditedSurface(changedVertices);
+    return true;
 }
 
-//Denne funksjonen reduserer antall punkter i punktskyen. Den bruker hash funksjoenen til  
-//organisere punktene i et rutenett og reduserer antall punkter slik at hver celle i rutenettet
-//inneholder et punkt 
-vector<glm::vec3> BilinearSurface::reducePoints(const vector<glm::vec3>& points, float cellSize) {
-    unordered_map<pair<int, int>, glm::vec3, pair_hash> grid;
+int BilinearSurface::insertPoint(const glm::vec3& point)
+{
+    if (!beginEditing())
+    {
+        return -1;
+    }
+    size_t index = pointCount();
+    if (!appendPoint(point))
+    {
+        return -1;
+    }
+    glm::vec3 stored = pointAt(index);
+    if (editor->insertPoint(glm::dvec2(stored.x, stored.y) - editOrigin) < 0)
+    {
+        removeLastPoint();
+        return -1;
+    }
+    vertices.push_back({ stored, encodeOctahedral(glm::vec3(0.0f, 0.0f, 1.0f)) });
+    normalLines.push_back(stored);
+    normalLines.push_back(stored);
+    //Punktnormalen settes fra normalen i nettet i updateEditedSurface 
+    if (hasPointNormals())
+    {
+        pointNormals.push_back(vertices.back().normal);
+        pointVariations.push_back(0.0f);
+    }
 
-    for (const auto& point : points) 
+    vector<size_t> changedVertices = { index };
+    updateEditedSurface(changedVertices);
+    return static_cast<int>(index);
+}
+
+bool BilinearSurface::removePoint(size_t index)
+{
+    if (!beginEditing() || index >= pointCount())
     {
-        int xIdx = static_cast<int>(point.x / cellSize);
-        int yIdx = static_cast<int>(point.y / cellSize);
-        std::pair<int, int> gridCell = { xIdx, yIdx };
+        return false;
+    }
+    //Editoren og punktene må ha de samme indeksene, så ingenting flyttes hvis editoren ikke fjernet punktet 
+    if (!editor->removePoint(static_cast<int>(index)))
+    {
+        return false;
+    }
 
-        if (grid.find(gridCell) == grid.end()) 
+    //Samme flytting som i DelaunayTriangulator::removePoint 
+    vector<size_t> changedVertices;
+    size_t last = pointCount() - 1;
+    if (index != last)
+    {
+        storePoint(index, pointAt(last));
+        vertices[index] = vertices[last];
+        normalLines[index * 2] = normalLines[last * 2];
+        normalLines[index * 2 + 1] = normalLines[last * 2 + 1];
+        if (hasPointNormals())
         {
-            grid[gridCell] = point;
+            pointNormals[index] = pointNormals[last];
+            pointVariations[index] = pointVariations[last];
         }
+        changedVertices.push_back(index);
+    }
+    removeLastPoint();
+    vertices.pop_back();
+    normalLines.resize(normalLines.size() - 2);
+    if (hasPointNormals())
+    {
+        pointNormals.pop_back();
+        pointVariations.pop_back();
     }
 
-    vector<glm::vec3> reducedPoints;
-    for (const auto& cell : grid) 
+    updateEditedSurface(changedVertices);
+    return true;
+}
+
+bool BilinearSurface::movePoint(size_t index, const glm::vec3& point)
+{
+    if (!beginEditing() || index >= pointCount())
+    {
+        return false;
+    }
+    glm::vec3 oldPoint = pointAt(index);
+    if (!storePoint(index, point))
+    {
+        return false;
+    }
+    glm::vec3 stored = pointAt(index);
+    if (!editor->movePoint(static_cast<int>(index), glm::dvec2(stored.x, stored.y) - editOrigin))
     {
-        reducedPoints.push_back(cell.second);
+        storePoint(index, oldPoint);
+        return false;
     }
-    return reducedPoints;
+    vertices[index].position = stored;
+
+    vector<size_t> changedVertices = { index };
+    updateEditedSurface(changedVertices);
+    return true;
 }
 
-void BilinearSurface::drawPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
+void BilinearSurface::finishEditing()
 {
-    glBindVertexArray(VAOPoints);
-    glPointSize(2.0f);
-    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(points.size()));
-    glBindVertexArray(0);
+    if (!editor)
+    {
+        return;
+    }
+    mesh = editor->mesh();
+    editor.reset();
+    editTriangles.clear();
+    editTriangles.shrink_to_fit();
+    fitControlPoints();
+
+    glBindBuffer(GL_COPY_WRITE_BUFFER, EBO);
+    glBufferData(GL_COPY_WRITE_BUFFER, mesh.triangleCount() * sizeof(glm::ivec3), mesh.getTriangles().data(), GL_DYNAMIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, VBOControlPoints);
+    glBufferData(GL_COPY_WRITE_BUFFER, controlPoints.size() * sizeof(glm::vec3), controlPoints.data(), GL_STATIC_DRAW);
+    glBindBuffer(GL_COPY_WRITE_BUFFER, 0);
 }
 
-void BilinearSurface::draw(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
+//Hjørnene i de endrede trekantene får nye normaler. Trekantene som ble fjernet har bare hjørner som også er med
+//i en av de nye trekantene, så det holder å se på trekantene som finnes nå (DelaunayTriangulator::changedPoints). 
+void BilinearSurface::updateEditedSurface(vector<size_t>& changedVertices)
 {
-    glBindVertexArray(VAO);
-    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
-    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(triangles.size() * 3), GL_UNSIGNED_INT, 0);
-    glBindVertexArray(0);
+    vector<size_t> changedSlots(editor->changedTriangles().begin(), editor->changedTriangles().end());
+    for (int vertex : editor->changedPoints())
+    {
+        changedVertices.push_back(static_cast<size_t>(vertex));
+    }
+    editor->clearChangedTriangles();
+    editTriangles.resize(editor->triangleSlotCount());
+    for (size_t slot : changedSlots)
+    {
+        editTriangles[slot] = editor->drawableTriangle(static_cast<int>(slot));
+    }
+    sort(changedSlots.begin(), changedSlots.end());
+    changedSlots.erase(unique(changedSlots.begin(), changedSlots.end()), changedSlots.end());
+    sort(changedVertices.begin(), changedVertices.end());
+    changedVertices.erase(unique(changedVertices.begin(), changedVertices.end()), changedVertices.end());
+
+    for (size_t i : changedVertices)
+    {
+        glm::vec3 sum(0.0f);
+        glm::vec3 point = pointAt(i);
+        editor->forEachTriangleAround(static_cast<int>(i), [&](const glm::ivec3& triangle)
+        {
+            int corner = triangle.x == static_cast<int>(i) ? 0 : (triangle.y == static_cast<int>(i) ? 1 : 2);
+            sum += cornerNormal(point, pointAt(triangle[(corner + 1) % 3]), pointAt(triangle[(corner + 2) % 3]),
+                normalWeighting);
+        });
+        glm::vec3 normal = finishNormal(sum);
+        vertices[i].normal = encodeOctahedral(normal);
+        normalLines[i * 2] = vertices[i].position;
+        normalLines[i * 2 + 1] = vertices[i].position + normal * 0.001f;
+        //k-d treet slettes når punktene endres, så de endrede punktene får normalen fra nettet i stedet for PCA 
+        if (hasPointNormals())
+        {
+            pointNormals[i] = vertices[i].normal;
+        }
+    }
+
+    uploadElements(EBO, elementBufferCapacity, editTriangles.data(), sizeof(glm::ivec3), editTriangles.size(), changedSlots);
+    uploadElements(VBO, vertexBufferCapacity, vertices.data(), sizeof(VertexData), vertices.size(), changedVertices);
+    uploadElements(VBONormals, normalBufferCapacity, normalLines.data(), 2 * sizeof(glm::vec3), vertices.size(), changedVertices);
+    if (quantizePoints)
+    {
+        uploadElements(VBOPoints, pointBufferCapacity, quantizedPoints.data(), sizeof(glm::u16vec3), pointCount(), changedVertices);
+    }
+    else
+    {
+        uploadElements(VBOPoints, pointBufferCapacity, points.data(), sizeof(glm::vec3), pointCount(), changedVertices);
+    }
+    if (VBOPointNormals != 0)
+    {
+        uploadElements(VBOPointNormals, pointNormalBufferCapacity, pointNormals.data(), sizeof(glm::i16vec2),
+            pointNormals.size(), changedVertices);
+    }
 }
 
-void BilinearSurface::drawNormals(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
+bool BilinearSurface::storePoint(size_t i, const glm::vec3& point)
 {
-    glBindVertexArray(VAONormals);
-    glLineWidth(2.0f);
-    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(normalLines.size()));
-    glBindVertexArray(0);
+    pointIndex.clear();
+    if (quantizePoints)
+    {
+        if (!quantizedPoints.contains(point))
+        {
+            return false;
+        }
+        quantizedPoints.set(i, point);
+    }
+    else
+    {
+        points[i] = point;
+    }
+    return true;
 }
 
-void BilinearSurface::drawControlPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) {
-    glBindVertexArray(VAOControlPoints);
-    glPointSize(6.0f); 
-    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(controlPoints.size()));
-    glBindVertexArray(0);
+bool BilinearSurface::appendPoint(const glm::vec3& point)
+{
+    pointIndex.clear();
+    if (quantizePoints)
+    {
+        if (!quantizedPoints.contains(point))
+        {
+            return false;
+        }
+        quantizedPoints.push_back(point);
+    }
+    else
+    {
+        points.push_back(point);
+    }
+    return true;
 }
 
-//Utfrer Delaunay trianguleringen p punktskyen, legger frst til trkanten som omfavner alle punktene. 
-// Gr gjennom hvert punkt og ser om punktene er innenfor en omskrevne sirkelen til en trelant, fjerner trekanter 
-// som ikke flger Delaunay egenskapen, bruker kantene fra trekantene til  lage nye trekanter. 
-// Tilslutt fjernes alle trekanter som bruker noen av punktene til den store trekanten. 
-//Referanse https://github.com/Maknee/Delaunay-Triangulation/tree/master/source
-vector<glm::ivec3> BilinearSurface::delaunayTriangulation(vector<glm::vec3>& points) 
+void BilinearSurface::removeLastPoint()
 {
-    vector<glm::ivec3> triangles;
-    addSuperTriangle(points);
-    int superTriangleStartIndex = points.size() - 3;
+    pointIndex.clear();
+    if (quantizePoints)
+    {
+        quantizedPoints.pop_back();
+    }
+    else
+    {
+        points.pop_back();
+    }
+}
 
-    triangles.push_back(glm::ivec3(superTriangleStartIndex, superTriangleStartIndex + 1, superTriangleStartIndex + 2));
+//Trianguleringen, normalene, kontrollpunktene og bufferne lages av de reduserte punktene 
+void BilinearSurface::buildSurface()
+{
+    pointIndex.clear();
+    quantizeReducedPoints();
+    computePointNormals();
+    triangulateSurface();
+    fitControlPoints();
 
-    for (size_t i = 0; i < superTriangleStartIndex; ++i) {
-        vector<glm::ivec3> badTriangles;
-        vector<pair<int, int>> polygon;
+    setupPointBuffers();
+    setupBuffers();
+    setupNormalBuffers();
+    setupControlPointBuffers(); 
+    surfaceReady = true;
+}
 
-        for (const auto& tri : triangles) {
-            if (inCircumcircle(points[tri.x], points[tri.y], points[tri.z], points[i])) {
-                badTriangles.push_back(tri);
-                polygon.emplace_back(tri.x, tri.y);
-                polygon.emplace_back(tri.y, tri.z);
-                polygon.emplace_back(tri.z, tri.x);
-            }
-        }
+//Med kvantisering lagres punktene som 16 bits heltall, og float-kopien slettes 
+void BilinearSurface::quantizeReducedPoints()
+{
+    if (quantizePoints)
+    {
+        quantizedPoints.quantize(points);
+        points.clear();
+        points.shrink_to_fit();
+    }
+}
 
-        triangles.erase(std::remove_if(triangles.begin(), triangles.end(),
-            [&](const glm::ivec3& tri) {
-                return std::find(badTriangles.begin(), badTriangles.end(), tri) != badTriangles.end();
-            }),
-            triangles.end());
-
-        for (auto it = polygon.begin(); it != polygon.end();) {
-            auto reverseEdge = std::make_pair(it->second, it->first);
-            if (std::count(polygon.begin(), polygon.end(), reverseEdge)) {
-                polygon.erase(std::remove(polygon.begin(), polygon.end(), reverseEdge), polygon.end());
-                it = polygon.erase(it);
-            }
-            else {
-                ++it;
-            }
+//PCA-normalene bruker k-d treet over xy, som også kan brukes til andre søk etterpå 
+void BilinearSurface::computePointNormals()
+{
+    pointNormals.clear();
+    pointVariations.clear();
+    if (!pointNormalsEnabled || pointCount() == 0)
+    {
+        return;
+    }
+    if (pointIndex.size() != pointCount())
+    {
+        buildPointIndex();
+    }
+
+    vector<glm::vec3> normals;
+    estimatePointNormals(pointIndex, pointNormalNeighbourCount, normals, &pointVariations);
+    pointNormals.resize(normals.size());
+    parallelFor(normals.size(), [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            pointNormals[i] = encodeOctahedral(normals[i]);
         }
+    });
+}
+
+//Delaunay trianguleringen, normalene i hvert punkt og linjene som viser normalene 
+void BilinearSurface::triangulateSurface()
+{
+    mesh = delaunayTriangulation();
+    Normals(mesh);
+}
+
+//Laster punktene fra tekstfilen med PointCloudLoader, som minnemapper filen og leser den parallelt.
+//Skaleringen og forskyvningen av punktene gjøres samtidig som tallene leses.
+PointCloud BilinearSurface::loadsPointsFromTextfile(const string& filename) 
+{
+    return PointCloudLoader::loadTextFile(filename, tileTransform());
+}
+
+//Laster punktene rett fra en LAS-fil, i biter. Koordinatene gjøres om med skaleringen i LAS headeren
+//og deretter med den samme transformasjonen som tekstfilene.
+PointCloud BilinearSurface::loadsPointsFromLasFile(const string& filename)
+{
+    return LasReader::loadFile(filename, tileTransform());
+}
 
-        for (const auto& edge : polygon) {
-            triangles.push_back(glm::ivec3(edge.first, edge.second, static_cast<int>(i)));
+//Skaleringen og forskyvningen som flytter punktene fra filene inn i koordinatene til scenen 
+PointTransform BilinearSurface::tileTransform()
+{
+    PointTransform transform;
+    transform.scale = glm::dvec3(0.0001, 0.0001, 0.0002);
+    transform.offset = glm::dvec3(-59.0, -663.0, 0.0);
+    return transform;
+}
+
+//Denne funksjonen reduserer antall punkter i punktskyen. Punktene sorteres på cellen de ligger i
+//i et rutenett, og antall punkter reduseres slik at hver celle i rutenettet inneholder et punkt.
+//Hvilket punkt som blir igjen bestemmes av reductionAggregation. Punktene kommer ut sortert rad for rad. 
+vector<glm::vec3> BilinearSurface::reducePoints(const PointCloud& points, float cellSize) {
+    GridReducer reducer(cellSize, reductionAggregation);
+    reducer.addPoints(points);
+    return reducer.reducedPoints();
+}
+
+//Leser filen i biter og legger hver bit rett inn i rutenettet før neste bit leses. Hele punktskyen
+//ligger aldri i minnet, bare én bit og cellene i rutenettet. Slik kan filer som er større enn minnet reduseres.
+vector<glm::vec3> BilinearSurface::reducePointsStreaming(const string& filename, float cellSize)
+{
+    const size_t streamBlockBytes = 64 * 1024 * 1024;
+    const size_t streamChunkPoints = 2 * 1024 * 1024;
+
+    GridReducer reducer(cellSize, reductionAggregation);
+    if (LasReader::isLasFile(filename))
+    {
+        LasReader reader;
+        if (reader.open(filename))
+        {
+            PointCloud chunk;
+            while (reader.readChunk(chunk, nullptr, streamChunkPoints, tileTransform()) > 0)
+            {
+                reducer.addPoints(chunk);
+            }
         }
     }
+    else
+    {
+        PointCloudLoader::streamTextFile(filename, tileTransform(), streamBlockBytes,
+            [&](const PointCloud& chunk) { reducer.addPoints(chunk); });
+    }
 
-    triangles.erase(std::remove_if(triangles.begin(), triangles.end(),
-        [superTriangleStartIndex](const glm::ivec3& tri) {
-            return tri.x >= superTriangleStartIndex || tri.y >= superTriangleStartIndex || tri.z >= superTriangleStartIndex;
-        }),
-        triangles.end());
+    cout << "Reduserte " << reducer.pointsAdded() << " punkter til " << reducer.cellCount() << " celler" << endl;
+    return reducer.reducedPoints();
+}
 
-    return triangles;
+void BilinearSurface::setPointQuantization(bool enabled)
+{
+    quantizePoints = enabled;
 }
 
-//Ser etter om et punkt ligger innenfor den omskrevne sirkelen til en trekant. 
-//Bruker determinanter til  avgjre om punktet ligger innenfor den omskrevne sirkelen. 
-bool BilinearSurface::inCircumcircle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& p)
+void BilinearSurface::setReductionAggregation(CellAggregation aggregation)
 {
-    float ax = a.x - p.x, ay = a.y - p.y;
-    float bx = b.x - p.x, by = b.y - p.y;
-    float cx = c.x - p.x, cy = c.y - p.y;
-    float determinant =
-        (ax * ax + ay * ay) * (bx * cy - by * cx) -
-        (bx * bx + by * by) * (ax * cy - ay * cx) +
-        (cx * cx + cy * cy) * (ax * by - ay * bx);
-    return determinant > 0;
+    reductionAggregation = aggregation;
 }
 
-//Legger til en stor trekant hvor hele punktskyen er innenfor trekanten. 
-//Dette gjres for at det ikke skal vre noen annen kode f.eks andre punkter son kan forstyrre Delaunay trianguleringen 
-void BilinearSurface::addSuperTriangle(vector<glm::vec3>& points) 
+void BilinearSurface::setPointNormals(bool enabled, size_t neighbourCount)
 {
-    float maxCoordinate = 50.0f;
-    points.push_back(glm::vec3(-maxCoordinate, -maxCoordinate, 0.0f));
-    points.push_back(glm::vec3(maxCoordinate, -maxCoordinate, 0.0f));
-    points.push_back(glm::vec3(0.0f, maxCoordinate, 0.0f));
+    pointNormalsEnabled = enabled;
+    pointNormalNeighbourCount = max<size_t>(neighbourCount, 3);
 }
 
-//Referanse https://stackoverflow.com/questions/30120636/calculating-vertex-normals-in-opengl-with-c
-//Regner ut normalvektorer til punktene p den bilinere flaten. Disse brukes til lysetting for phong shaderen. 
-vector<BilinearSurface::VertexData> BilinearSurface::Normals(const vector<glm::vec3>& points, const vector<glm::ivec3>& triangles) 
+void BilinearSurface::setPyramidLevels(int levelCount)
 {
-    vector<glm::vec3> normals(points.size(), glm::vec3(0.0f));
+    pyramidLevelCount = max(levelCount, 1);
+}
 
-    for (const auto& triangle : triangles) 
-    {
-        glm::vec3 p0 = points[triangle.x];
-        glm::vec3 p1 = points[triangle.y];
-        glm::vec3 p2 = points[triangle.z];
+//Henter punkt i, enten fra float-punktene eller fra de kvantiserte punktene 
+glm::vec3 BilinearSurface::pointAt(size_t i) const
+{
+    return quantizePoints ? quantizedPoints[i] : points[i];
+}
 
-        glm::vec3 edge1 = p1 - p0;
-        glm::vec3 edge2 = p2 - p0;
-        glm::vec3 normal = glm::normalize(glm::cross(edge1, edge2));
+size_t BilinearSurface::pointCount() const
+{
+    return quantizePoints ? quantizedPoints.size() : points.size();
+}
 
-        normals[triangle.x] += normal;
-        normals[triangle.y] += normal;
-        normals[triangle.z] += normal;
+//Kvantiserte punkter gjøres om til float først, siden treet lagrer en kopi av punktene uansett 
+void BilinearSurface::buildPointIndex(int dimensions)
+{
+    if (quantizePoints)
+    {
+        pointIndex.build(decodedPoints(), dimensions);
+    }
+    else
+    {
+        pointIndex.build(points, dimensions);
     }
+}
 
-    for (auto& normal : normals) 
+vector<glm::vec3> BilinearSurface::decodedPoints() const
+{
+    vector<glm::vec3> decoded(pointCount());
+    parallelFor(decoded.size(), [&](size_t begin, size_t end, unsigned int)
     {
-        normal = glm::normalize(normal);
+        for (size_t i = begin; i < end; ++i)
+        {
+            decoded[i] = pointAt(i);
+        }
+    });
+    return decoded;
+}
+
+//Trådantallet er ikke med, siden det ikke endrer flaten, bare hvor raskt den lages 
+uint64_t BilinearSurface::surfaceCacheKey(float reductionCellSize) const
+{
+    uint64_t key = PointCloudCache::hashSeed;
+    auto add = [&key](const void* data, size_t size) { key = PointCloudCache::hashBytes(key, data, size); };
+    auto addValue = [&add](auto value) { add(&value, sizeof(value)); };
+
+    PointTransform transform = tileTransform();
+    addValue(transform.scale);
+    addValue(transform.offset);
+    addValue(reductionCellSize);
+    addValue(static_cast<int32_t>(reductionAggregation));
+    addValue(static_cast<int32_t>(quantizePoints));
+    addValue(static_cast<int32_t>(normalWeighting));
+    addValue(static_cast<int32_t>(pointNormalsEnabled));
+    addValue(static_cast<uint64_t>(pointNormalsEnabled ? pointNormalNeighbourCount : 0));
+
+    const SurfaceFitSettings& fit = surfaceFitSettings;
+    addValue(fit.widthU);
+    addValue(fit.widthV);
+    addValue(fit.degree);
+    addValue(static_cast<uint64_t>(fit.knotU.size()));
+    add(fit.knotU.data(), fit.knotU.size() * sizeof(float));
+    addValue(static_cast<uint64_t>(fit.knotV.size()));
+    add(fit.knotV.data(), fit.knotV.size() * sizeof(float));
+    addValue(fit.smoothing);
+    addValue(fit.minCorner);
+    addValue(fit.maxCorner);
+    addValue(fit.maxIterations);
+    addValue(fit.tolerance);
+    return key;
+}
+
+//Tabellene fra cachen flyttes rett inn, og bare det som er billig å lage av dem (punktene i vertices, linjene som
+//viser normalene og naboene til hvert hjørne i nettet) regnes ut. Pyramiden er ikke med i cachen og lages av
+//punktene fra cachen, så med kvantisering blir nivåene laget av de kvantiserte punktene. 
+bool BilinearSurface::readCachedSurface(const vector<string>& filenames, float reductionCellSize)
+{
+    CachedSurface cached;
+    if (filenames.empty() || !SurfaceCache::load(filenames, surfaceCacheKey(reductionCellSize), cached))
+    {
+        return false;
     }
 
-    vector<VertexData> vertexData;
-    for (size_t i = 0; i < points.size(); ++i) 
+    pointIndex.clear();
+    points = move(cached.points);
+    if (quantizePoints)
     {
-        vertexData.push_back({ points[i], normals[i] });
+        quantizedPoints.assign(cached.quantizedOrigin, cached.quantizedScale, move(cached.quantizedPositions));
     }
+    size_t count = pointCount();
+    mesh = TriangleMesh(count, move(cached.triangles), move(cached.neighbours));
+
+    vertices.resize(count);
+    normalLines.resize(count * 2);
+    parallelFor(count, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            glm::vec3 position = pointAt(i);
+            vertices[i] = { position, cached.vertexNormals[i] };
+            normalLines[i * 2] = position;
+            normalLines[i * 2 + 1] = position + decodeOctahedral(cached.vertexNormals[i]) * 0.001f;
+        }
+    });
+    pointNormals = move(cached.pointNormals);
+    pointVariations = move(cached.pointVariations);
+    fittedSurface = move(cached.fittedSurface);
+    controlPoints = fittedSurface.controlPoints;
 
-    return vertexData;
+    if (pyramidLevelCount > 1 && quantizePoints)
+    {
+        pyramid.build(decodedPoints(), reductionCellSize, pyramidLevelCount, reductionAggregation);
+        requestedLevel = 0;
+        shownLevel = 0;
+    }
+    else
+    {
+        buildPyramid(reductionCellSize);
+    }
+    return true;
 }
 
-//Ser p trekantene som blir generert av Delaunay trianguleringen. Senteret av trekantene blir kontrollpunktene for B-spline flaten 
-vector<glm::vec3> BilinearSurface::calculateControlPoints(const vector<glm::vec3>& points, const vector<glm::ivec3>& triangles) 
+bool BilinearSurface::loadCachedSurface(const vector<string>& filenames, float reductionCellSize)
 {
-    vector<glm::vec3> controlPoints;
-
-    for (const auto& triangle : triangles) 
+    if (!readCachedSurface(filenames, reductionCellSize))
     {
-        glm::vec3 p0 = points[triangle.x];
-        glm::vec3 p1 = points[triangle.y];
-        glm::vec3 p2 = points[triangle.z];
+        return false;
+    }
+    setupSurfaceBuffers();
+    return true;
+}
 
-        glm::vec3 midpoint01 = (p0 + p1) * 0.5f;
-        glm::vec3 midpoint12 = (p1 + p2) * 0.5f;
-        glm::vec3 midpoint20 = (p2 + p0) * 0.5f;
+void BilinearSurface::setupSurfaceBuffers()
+{
+    setupPointBuffers();
+    setupBuffers();
+    setupNormalBuffers();
+    setupControlPointBuffers();
+    surfaceReady = true;
+}
 
-        glm::vec3 center = (p0 + p1 + p2) / 3.0f;
+void BilinearSurface::saveCachedSurface(const vector<string>& filenames, float reductionCellSize) const
+{
+    if (filenames.empty())
+    {
+        return;
+    }
+    CachedSurface cached;
+    if (quantizePoints)
+    {
+        cached.quantizedPositions.assign(quantizedPoints.data(), quantizedPoints.data() + quantizedPoints.size());
+        cached.quantizedOrigin = quantizedPoints.origin;
+        cached.quantizedScale = quantizedPoints.scale;
+    }
+    else
+    {
+        cached.points = points;
+    }
+    cached.triangles = mesh.getTriangles();
+    cached.neighbours = mesh.getNeighbours();
+    cached.vertexNormals.resize(vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i)
+    {
+        cached.vertexNormals[i] = vertices[i].normal;
+    }
+    cached.pointNormals = pointNormals;
+    cached.pointVariations = pointVariations;
+    cached.fittedSurface = fittedSurface;
+    SurfaceCache::save(filenames, surfaceCacheKey(reductionCellSize), cached);
+}
 
-        controlPoints.push_back(p0);
-        controlPoints.push_back(p1);
-        controlPoints.push_back(p2);
-        controlPoints.push_back(midpoint01);
-        controlPoints.push_back(midpoint12);
-        controlPoints.push_back(midpoint20);
-        controlPoints.push_back(center);
+void BilinearSurface::drawPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
+{
+    //Punktene kan fortsatt skrives på arbeidstråden til VAOPoints er laget av opplastingsjobben 
+    if (VAOPoints == 0)
+    {
+        return;
+    }
+    //De kvantiserte punktene gjøres om til float i vertex shaderen 
+    if (quantizePoints)
+    {
+        shader.setVec3("positionOrigin", quantizedPoints.origin);
+        shader.setVec3("positionScale", quantizedPoints.scale);
     }
+    else
+    {
+        shader.setVec3("positionOrigin", 0.0f, 0.0f, 0.0f);
+        shader.setVec3("positionScale", 1.0f, 1.0f, 1.0f);
+    }
+    glBindVertexArray(VAOPoints);
+    glPointSize(2.0f);
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(pointCount()));
+    glBindVertexArray(0);
+}
 
-    return controlPoints;
+void BilinearSurface::draw(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
+{
+    //Bufferne kan fortsatt være under opplasting når flaten lastes i bakgrunnen 
+    if (VAO == 0)
+    {
+        return;
+    }
+    glBindVertexArray(VAO);
+    glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
+    //Mens punktene endres har EBO én trekant per plass i editor, og ledige plasser er tomme trekanter 
+    size_t triangleCount = editor ? editTriangles.size() : mesh.triangleCount();
+    glDrawElements(GL_TRIANGLES, static_cast<GLsizei>(triangleCount * 3), GL_UNSIGNED_INT, 0);
+    glBindVertexArray(0);
 }
 
-//Lager skjtvektoren for B-spine flaten. Den lager jevnt stigende verdier (uniform skjtvektor)
-vector<float> BilinearSurface::generateKnotVector(int numControlPoints) 
+void BilinearSurface::drawNormals(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) 
 {
-    int m = numControlPoints - 1;
-    vector<float> knotVector;
+    shader.setVec3("positionOrigin", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("positionScale", 1.0f, 1.0f, 1.0f);
+    if (VAONormals == 0)
+    {
+        return;
+    }
+    glBindVertexArray(VAONormals);
+    glLineWidth(2.0f);
+    glDrawArrays(GL_LINES, 0, static_cast<GLsizei>(normalLines.size()));
+    glBindVertexArray(0);
+}
 
-    for (int i = 0; i < 3; ++i) knotVector.push_back(0.0f);
-    for (int i = 1; i < m - 1; ++i) knotVector.push_back(static_cast<float>(i));
-    for (int i = 0; i < 3; ++i) knotVector.push_back(static_cast<float>(m));
+void BilinearSurface::drawControlPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model) {
+    shader.setVec3("positionOrigin", 0.0f, 0.0f, 0.0f);
+    shader.setVec3("positionScale", 1.0f, 1.0f, 1.0f);
+    if (VAOControlPoints == 0)
+    {
+        return;
+    }
+    glBindVertexArray(VAOControlPoints);
+    glPointSize(6.0f); 
+    glDrawArrays(GL_POINTS, 0, static_cast<GLsizei>(controlPoints.size()));
+    glBindVertexArray(0);
+}
 
-    return knotVector;
+//Utfører Delaunay trianguleringen på punktskyen, med DelaunayTriangulator eller i striper på flere tråder
+//(parallelDelaunayMesh). Legger reduksjonen punktene midt i cellene (CellAggregation::CenterMeanZ eller Count), lages
+//trianguleringen direkte fra rutene (gridDelaunayTriangulation). De andre modusene beholder xy fra punktskyen, så da
+//hoppes testen for rutenett over. Trekantene er mot klokka og bruker indeksene til punktene.
+TriangleMesh BilinearSurface::delaunayTriangulation() 
+{
+    if (pointCount() < 3)
+    {
+        return TriangleMesh();
+    }
+    vector<glm::dvec2> planar = planarPoints();
+    vector<glm::ivec3> gridTriangles;
+    if (GridReducer::producesLattice(reductionAggregation) &&
+        gridDelaunayTriangulation(planar, gridTriangles, triangulationThreads))
+    {
+        TriangleMesh gridMesh;
+        gridMesh.build(planar.size(), move(gridTriangles), triangulationThreads);
+        return gridMesh;
+    }
+    return parallelDelaunayMesh(planar, triangulationThreads);
 }
 
-//Ser p B-spline overflaten i u og v retning ved et kontrollpunkt. 
-//Basisfuksjonene brukes til  bestemme hvor mye hvert kontrollpunkt pvirker overflaten. 
-glm::vec3 BilinearSurface::evaluateBSpline(float u, float v, const vector<glm::vec3>& controlPoints, const vector<float>& knotsU, const vector<float>& knotsV) 
+//Midten av boksen rundt punktene i xy 
+glm::dvec2 BilinearSurface::planarOrigin() const
 {
-    int n = controlPoints.size();
-    glm::vec3 result(0.0f);
+    size_t count = pointCount();
+    if (count == 0)
+    {
+        return glm::dvec2(0.0);
+    }
 
-    for (int i = 0; i < n; ++i) 
+    glm::vec3 minBounds = pointAt(0);
+    glm::vec3 maxBounds = minBounds;
+    for (size_t i = 1; i < count; ++i)
     {
-        for (int j = 0; j < n; ++j) 
-        {
-            float Bu = basisFunction(i, 3, u, knotsU);
-            float Bv = basisFunction(j, 3, v, knotsV);
-            result += Bu * Bv * controlPoints[i * n + j];
-        }
+        glm::vec3 point = pointAt(i);
+        minBounds = glm::min(minBounds, point);
+        maxBounds = glm::max(maxBounds, point);
     }
+    return (glm::dvec2(minBounds.x, minBounds.y) + glm::dvec2(maxBounds.x, maxBounds.y)) * 0.5;
+}
 
+//Punktene flyttes slik at midten av punktskyen ligger i origo, da blir avrundingsfeilene i determinantene minst
+vector<glm::dvec2> BilinearSurface::planarPoints() const
+{
+    size_t count = pointCount();
+    glm::dvec2 center = planarOrigin();
+    vector<glm::dvec2> result(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::vec3 point = pointAt(i);
+        result[i] = glm::dvec2(point.x, point.y) - center;
+    }
     return result;
 }
 
-//Basisfunksjonene for B-spline flaten 
-float BilinearSurface::basisFunction(int i, int k, float u, const vector<float>& knots) 
+//Referanse https://stackoverflow.com/questions/30120636/calculating-vertex-normals-in-opengl-with-c
+//Regner ut normalvektorer til punktene på den bilineære flaten. Disse brukes til lysetting for phong shaderen. 
+//Hvert punkt summerer bidragene fra trekantene rundt seg (computeVertexNormals), parallelt og uten atomics, og
+//skrives rett inn i vertices og normalLines. 
+void BilinearSurface::Normals(const TriangleMesh& mesh) 
 {
-    if (k == 1) 
+    size_t count = pointCount();
+    vertices.resize(count);
+    normalLines.resize(count * 2);
+    computeVertexNormals(mesh, count, [this](size_t i) { return pointAt(i); }, [this](size_t i, const glm::vec3& normal)
     {
-        return (knots[i] <= u && u < knots[i + 1]) ? 1.0f : 0.0f;
-    }
-    else {
-        float coefficient1 = (u - knots[i]) / (knots[i + k - 1] - knots[i]);
-        float coefficient2 = (knots[i + k] - u) / (knots[i + k] - knots[i + 1]);
+        glm::vec3 position = pointAt(i);
+        vertices[i] = { position, encodeOctahedral(normal) };
+        normalLines[i * 2] = position;
+        normalLines[i * 2 + 1] = position + normal * 0.001f;
+    }, normalWeighting);
+}
 
-        return coefficient1 * basisFunction(i, k - 1, u, knots) + coefficient2 * basisFunction(i + 1, k - 1, u, knots);
+//Punktene utenfor området i surfaceFitSettings brukes ikke, og kontrollnettet erstatter de gamle kontrollpunktene
+//(sju punkter per trekant), så det blir noen tusen punkter i stedet for flere ganger antall trekanter 
+void BilinearSurface::fitControlPoints()
+{
+    if (quantizePoints)
+    {
+        fittedSurface = fitBSplineSurface(decodedPoints(), surfaceFitSettings);
     }
+    else
+    {
+        fittedSurface = fitBSplineSurface(points, surfaceFitSettings);
+    }
+    controlPoints = fittedSurface.controlPoints;
 }
 
 void BilinearSurface::setupBuffers() 
@@ -327,11 +985,12 @@ void BilinearSurface::setupBuffers()
     glBufferData(GL_ARRAY_BUFFER, vertices.size() * sizeof(VertexData), vertices.data(), GL_DYNAMIC_DRAW);
     glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, position));
     glEnableVertexAttribArray(0);
-    glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(VertexData), (void*)offsetof(VertexData, normal));
+    //Oktaeder-kodet normal, to normaliserte 16 bits heltall som dekodes i phongOctahedral.vert 
+    glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(VertexData), (void*)offsetof(VertexData, normal));
     glEnableVertexAttribArray(1);
 
     glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, EBO);
-    glBufferData(GL_ELEMENT_ARRAY_BUFFER, triangles.size() * sizeof(glm::ivec3), triangles.data(), GL_DYNAMIC_DRAW);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, mesh.triangleCount() * sizeof(glm::ivec3), mesh.getTriangles().data(), GL_DYNAMIC_DRAW);
 
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
@@ -361,12 +1020,30 @@ void BilinearSurface::setupPointBuffers()
 
     glBindVertexArray(VAOPoints);
 
+    //Kvantiserte punkter lastes opp som 3 x uint16 og gjøres om til float i vs.vs 
     glBindBuffer(GL_ARRAY_BUFFER, VBOPoints);
-    glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), points.data(), GL_DYNAMIC_DRAW);
-
-    glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    if (quantizePoints)
+    {
+        glBufferData(GL_ARRAY_BUFFER, quantizedPoints.size() * sizeof(glm::u16vec3), quantizedPoints.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_UNSIGNED_SHORT, GL_FALSE, sizeof(glm::u16vec3), (void*)0);
+    }
+    else
+    {
+        glBufferData(GL_ARRAY_BUFFER, points.size() * sizeof(glm::vec3), points.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(glm::vec3), (void*)0);
+    }
     glEnableVertexAttribArray(0);
 
+    //PCA-normalene ligger i en egen buffer, så punktbufferen er den samme med og uten normaler 
+    if (hasPointNormals())
+    {
+        glGenBuffers(1, &VBOPointNormals);
+        glBindBuffer(GL_ARRAY_BUFFER, VBOPointNormals);
+        glBufferData(GL_ARRAY_BUFFER, pointNormals.size() * sizeof(glm::i16vec2), pointNormals.data(), GL_STATIC_DRAW);
+        glVertexAttribPointer(1, 2, GL_SHORT, GL_TRUE, sizeof(glm::i16vec2), (void*)0);
+        glEnableVertexAttribArray(1);
+    }
+
     glBindBuffer(GL_ARRAY_BUFFER, 0);
     glBindVertexArray(0);
 }
@@ -387,15 +1064,26 @@ void BilinearSurface::setupNormalBuffers()
     glBindVertexArray(0);
 }
 
+//Sletter bare buffere som finnes, og nullstiller dem, slik at cleanup kan kalles flere ganger og et
+//objekt uten buffere aldri kaller OpenGL (f.eks når det slettes på en arbeidstråd). 
 void BilinearSurface::cleanup() 
 {
-    glDeleteVertexArrays(1, &VAO);
-    glDeleteBuffers(1, &VBO);
-    glDeleteBuffers(1, &EBO);
-    glDeleteVertexArrays(1, &VAONormals);
-    glDeleteBuffers(1, &VBONormals);
-    glDeleteVertexArrays(1, &VAOPoints);
-    glDeleteBuffers(1, &VBOPoints);
-    glDeleteVertexArrays(1, &VAOControlPoints);
-    glDeleteBuffers(1, &VBOControlPoints);
+    GLuint* vertexArrays[] = { &VAO, &VAONormals, &VAOPoints, &VAOControlPoints };
+    GLuint* buffers[] = { &VBO, &EBO, &VBONormals, &VBOPoints, &VBOPointNormals, &VBOControlPoints };
+    for (GLuint* vertexArray : vertexArrays)
+    {
+        if (*vertexArray != 0)
+        {
+            glDeleteVertexArrays(1, vertexArray);
+            *vertexArray = 0;
+        }
+    }
+    for (GLuint* buffer : buffers)
+    {
+        if (*buffer != 0)
+        {
+            glDeleteBuffers(1, buffer);
+            *buffer = 0;
+        }
+    }
 }
@@ -9,12 +9,35 @@
 #include<glm/gtc/matrix_transform.hpp>
 #include<glm/gtc/type_ptr.hpp>
 #include "Shader.h"
-#include <unordered_map> 
+#include "PointCloud.h"
+#include "PointCloudLoader.h"
+#include "QuantizedPoints.h"
+#include "TileCatalog.h"
+#include "AssetPipeline.h"
+#include "GridReducer.h"
+#include "ReductionPyramid.h"
+#include "TriangleMesh.h"
+#include "DelaunayTriangulator.h"
+#include "VertexNormals.h"
+#include "KdTree.h"
+#include "PointNormals.h"
+#include "SurfaceFitter.h"
+#include "SurfaceCache.h"
+#include <memory>
+#include <atomic>
 #include <utility>  
 #include <algorithm>
 
 using namespace std; 
 
+//Punktskyen til loadFunctionsAsync: filene den leses fra, som er nøkkelen i SurfaceCache, og funksjonen som leser
+//dem. loadCloud kalles bare når flaten ikke finnes i cachen. Uten filer brukes ikke cachen. 
+struct SurfaceSource
+{
+    vector<string> filenames;
+    function<PointCloud()> loadCloud;
+};
+
 class BilinearSurface
 {
 
@@ -23,66 +46,180 @@ public:
     ~BilinearSurface();
 
     //Laser opp punktene fra tesktfilen, reduserer antall punkter som skal bli rendret, kaller Delaunay trianguleringen, normalene for overflaten
-    //og kontrollpunktene for B-spline overflaten 
-    void loadFunctions(const string& filename, float reductionCellSize);
+    //og kontrollpunktene for B-spline overflaten. Med streamingIngest leses filen i biter rett inn i rutenettet
+    //som reduserer punktene, slik at hele punktskyen aldri ligger i minnet. Den ferdige flaten lagres i en
+    //SurfaceCache ved siden av filen, så neste gang med samme fil og innstillinger lastes bare bufferne opp. 
+    void loadFunctions(const string& filename, float reductionCellSize, bool streamingIngest = false);
+    //Som loadFunctions, men for flere fliser fra katalogen. Flisene leses parallelt og blir én flate, som
+    //lagres i SurfaceCache ved siden av den første flisen. 
+    void loadTileFunctions(const TileCatalog& catalog, const vector<TileInfo>& tiles, float reductionCellSize);
+    //Som loadFunctions, men alt utenom opplastingen til GPU-en kjøres på arbeidstrådene til pipelinen, også
+    //oppslaget i og lagringen til SurfaceCache. findSource finner filene og kalles på arbeidstråden, slik at
+    //f.eks skanningen av en katalog ikke stopper render-løkken. Flaten vises etter hvert som render-løkken
+    //kaller pipeline.processRenderJobs. 
+    void loadFunctionsAsync(AssetPipeline& pipeline, function<SurfaceSource()> findSource, float reductionCellSize);
+    //Skaleringen og forskyvningen som brukes på punktene i filene 
+    static PointTransform tileTransform();
     //Rendrer trianguleringen 
     void draw(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
     //Rendrer normalene 
     void drawNormals(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
-    //Rendrer punktskyen 
+    //Rendrer punktskyen. Med punktnormaler (setPointNormals) kan den lyssettes med pointsLit.vert og phong.frag. 
     void drawPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
-    //Rendrer controllpunktene for B-spline overflaten 
+    //Rendrer kontrollpunktene til B-spline flaten som er tilpasset punktene 
     void drawControlPoints(const Shader& shader, const glm::mat4& projection, const glm::mat4& view, const glm::mat4& model);
 
-//Referanse https://www.geeksforgeeks.org/how-to-create-an-unordered_map-of-pairs-in-c/
-    struct pair_hash {
-        template <class T1, class T2>
-        std::size_t operator()(const std::pair<T1, T2>& pair) const {
-            auto hash1 = hash<T1>{}(pair.first);
-            auto hash2 = hash<T2>{}(pair.second);
-            return hash1 ^ (hash2 << 1);
-        }
-    };
-    unordered_map<pair<int, int>, glm::vec3, pair_hash> grid;
-
+    //Lagrer punktene som 16 bits heltall i stedet for float, både i minnet og på GPU-en. Må kalles før loadFunctions. 
+    void setPointQuantization(bool enabled);
+    //Velger hvilket punkt som blir igjen i hver celle når punktene reduseres, f.eks LowestZ for å lage en
+    //terrengmodell av bakkepunktene. Med CenterMeanZ ligger punktene i et rutenett og trianguleres mye raskere
+    //(gridDelaunayTriangulation). Standard er First. Må kalles før loadFunctions. 
+    void setReductionAggregation(CellAggregation aggregation);
+    //Antall nivåer i reduksjonspyramiden. Nivå 0 har cellestørrelsen fra loadFunctions, og hvert nivå over
+    //har dobbelt så store celler. Standard er 1 (ingen pyramide). Må kalles før loadFunctions. 
+    void setPyramidLevels(int levelCount);
+    //Bytter til et annet nivå i pyramiden mens programmet kjører. Trianguleringen og bufferne for nivået
+    //lages i bakgrunnen, og nivået byttes inn når det er ferdig. Returnerer false hvis nivået ikke kan velges,
+    //også mens punktene endres (isEditing), siden endringene ellers ville blitt borte med det gamle nivået.
+    //Kalles finishEditing først, kan nivået byttes. 
+    bool selectPyramidLevel(AssetPipeline& pipeline, int level);
+    //Nivået som sist ble valgt (det kan fortsatt være under bygging) 
+    int getPyramidLevel() const { return requestedLevel; }
+    int pyramidLevels() const { return max(pyramid.levelCount(), 1); }
+    //true når trianguleringen og bufferne fra loadFunctionsAsync er klare 
+    bool isSurfaceReady() const { return surfaceReady; }
+    //Antall tråder som brukes til Delaunay trianguleringen (se ParallelDelaunay.h). 0 betyr alle kjernene.
+    //Standard er 1 (seriell). 
+    void setTriangulationThreads(unsigned int threadCount) { triangulationThreads = threadCount; }
+    //Hvordan trekantene rundt et punkt veies i normalen (se VertexNormals.h). Standard er Area. Må kalles før
+    //loadFunctions. 
+    void setNormalWeighting(NormalWeighting weighting) { normalWeighting = weighting; }
+    //Regner ut en normal for hvert punkt i punktskyen med PCA over de neighbourCount nærmeste punktene (se
+    //PointNormals.h), slik at punktene kan lyssettes uten triangulering. Normalene lastes opp som attributt 1 i
+    //punktbufferen, oktaeder-kodet som normalene i draw. Standard er av. Må kalles før loadFunctions. 
+    void setPointNormals(bool enabled, size_t neighbourCount = 16);
+    bool hasPointNormals() const { return !pointNormals.empty(); }
+    glm::vec3 pointNormalAt(size_t i) const { return decodeOctahedral(pointNormals[i]); }
+    //Hvor lite punkt i og naboene ligger i et plan, fra 0 (plan) til 1/3 (spredt, f.eks vegetasjon eller støy) 
+    float pointVariationAt(size_t i) const { return pointVariations[i]; }
+    //Kontrollnettet, graden og området til B-spline flaten som tilpasses punktene med minste kvadraters metode
+    //(se SurfaceFitter.h). Standard er 32 x 32 bikvadratisk over boksen rundt punktene. Må kalles før loadFunctions. 
+    void setSurfaceFit(const SurfaceFitSettings& settings) { surfaceFitSettings = settings; }
+    //Flaten som er tilpasset punktene. toSurface() gir en Surface som kan brukes i stedet for punktskyen. 
+    const FittedSurface& getFittedSurface() const { return fittedSurface; }
+    bool hasFittedSurface() const { return !fittedSurface.empty(); }
+    //xy til de reduserte punktene, flyttet slik at midten av punktskyen ligger i origo 
+    vector<glm::dvec2> planarPoints() const;
+    //Punktene kan endres etter at flaten er lastet, uten å triangulere alt på nytt. beginEditing lager en
+    //DelaunayTriangulator av punktene (én full triangulering), og etter det endrer insertPoint, removePoint og
+    //movePoint bare trekantene rundt punktet, og bare de endrede delene av bufferne lastes opp (glBufferSubData).
+    //removePoint flytter det siste punktet til indeksen som ble ledig. Kvantiserte punkter må ligge inne i boksen
+    //til kvantiseringen. Alt må kalles på render-tråden. 
+    bool beginEditing();
+    bool isEditing() const { return editor != nullptr; }
+    //Returnerer indeksen til punktet, eller -1 hvis det allerede finnes et punkt med samme x og y 
+    int insertPoint(const glm::vec3& point);
+    bool removePoint(size_t index);
+    bool movePoint(size_t index, const glm::vec3& point);
+    //Lager nettet av trekantene igjen, pakker trekantene tett i EBO og regner ut kontrollpunktene på nytt 
+    void finishEditing();
+    //Punkt i i punktskyen, uansett om punktene er lagret som float eller kvantisert 
+    glm::vec3 pointAt(size_t i) const;
+    size_t pointCount() const;
+    //Bygger et k-d tre over punktene (se KdTree.h), med samme indekser som pointAt, slik at punktene nær (x, y)
+    //kan finnes uten å gå gjennom alle. Med 2 dimensjoner brukes bare x og y. Treet slettes når punktene endres
+    //eller flaten lastes på nytt, og må da bygges igjen. 
+    void buildPointIndex(int dimensions = 2);
+    const KdTree& getPointIndex() const { return pointIndex; }
 
 private:
 
+    //Normalen er oktaeder-kodet (encodeOctahedral), 16 bytes per punkt i stedet for 24. draw må derfor brukes med
+    //phongOctahedral.vert. 
     struct VertexData
     {
         glm::vec3 position;
-        glm::vec3 normal;
+        glm::i16vec2 normal;
     };
 
     GLuint VAO, VBO, EBO;
     GLuint VAONormals, VBONormals;
-    GLuint VAOPoints, VBOPoints;
+    GLuint VAOPoints, VBOPoints, VBOPointNormals;
     GLuint VAOControlPoints, VBOControlPoints;
 
     vector<VertexData> vertices;
-    vector<glm::ivec3> triangles;
+    //Trekantene med naboene, se TriangleMesh.h
+    TriangleMesh mesh;
     vector<glm::vec3> normalLines;
     vector<glm::vec3> points;
     vector<glm::vec3> controlPoints;
+    KdTree pointIndex;
+    vector<glm::i16vec2> pointNormals;
+    vector<float> pointVariations;
+    bool pointNormalsEnabled;
+    size_t pointNormalNeighbourCount;
+    SurfaceFitSettings surfaceFitSettings;
+    FittedSurface fittedSurface;
+    bool quantizePoints;
+    CellAggregation reductionAggregation;
+    QuantizedPoints quantizedPoints;
+    ReductionPyramid pyramid;
+    int pyramidLevelCount;
+    unsigned int triangulationThreads;
+    NormalWeighting normalWeighting;
+    //Skrives av buildPyramid på arbeidstråden og leses av getPyramidLevel på render-tråden 
+    atomic<int> requestedLevel;
+    //Nivået som vises nå. Settes av buildPyramid før flaten er klar, og etter det bare på render-tråden. 
+    int shownLevel;
+    bool surfaceReady;
+    //Trianguleringen som endres av insertPoint, removePoint og movePoint. EBO har da én trekant for hver plass
+    //i editor (editTriangles), så en endring bare skriver over plassene som er endret. 
+    unique_ptr<DelaunayTriangulator> editor;
+    glm::dvec2 editOrigin;
+    vector<glm::ivec3> editTriangles;
+    //Størrelsen i bytes som er satt av til bufferne mens punktene endres 
+    size_t vertexBufferCapacity, elementBufferCapacity, pointBufferCapacity, normalBufferCapacity,
+        pointNormalBufferCapacity;
 
     //Laster punktene fra tesktstfil 
-    vector<glm::vec3> loadsPointsFromTextfile(const string& filename);
+    PointCloud loadsPointsFromTextfile(const string& filename);
+    //Laster punktene fra en LAS-fil
+    PointCloud loadsPointsFromLasFile(const string& filename);
     //Reduserer antall punkter som skal bli rendret 
-    vector<glm::vec3> reducePoints(const vector<glm::vec3>& points, float cellSize);
-    //Regulr Delaunay triangulering 
-    vector<glm::ivec3> delaunayTriangulation(vector<glm::vec3>& points);
-    //
-    vector<VertexData> Normals(const vector<glm::vec3>& points, const vector<glm::ivec3>& triangles);
-    //Ser etter om et punkt ligger innenfor den omskrevne sirkelen til en trekant. 
-    bool inCircumcircle(const glm::vec3& a, const glm::vec3& b, const glm::vec3& c, const glm::vec3& p);
-    //Lager en stor trekant som danner en trekant rundt alle punktene 
-    void addSuperTriangle(vector<glm::vec3>& points);
-    //Kalkulerer kontrollpunktene for den bikvadratiske tensorprodukt B-spline flaten. 
-    vector<glm::vec3> calculateControlPoints(const std::vector<glm::vec3>& points, const vector<glm::ivec3>& triangles);
-    //Lager skjtvektoren som skal brukes for B-spline beregningene 
-    vector<float> generateKnotVector(int numControlPoints);
-    glm::vec3 evaluateBSpline(float u, float v, const vector<glm::vec3>& controlPoints, const vector<float>& knotsU, const vector<float>& knotsV);
-    float basisFunction(int i, int k, float u, const vector<float>& knots);
+    vector<glm::vec3> reducePoints(const PointCloud& points, float cellSize);
+    //Lager triangulering, normaler, kontrollpunkter og buffere av de reduserte punktene 
+    void buildSurface();
+    void quantizeReducedPoints();
+    void computePointNormals();
+    void triangulateSurface();
+    void buildPyramid(float reductionCellSize);
+    void swapSurface(BilinearSurface& other);
+    //Leser filen i biter og reduserer hver bit før neste leses 
+    vector<glm::vec3> reducePointsStreaming(const string& filename, float cellSize);
+    glm::dvec2 planarOrigin() const;
+    bool storePoint(size_t i, const glm::vec3& point);
+    bool appendPoint(const glm::vec3& point);
+    void removeLastPoint();
+    //Regner ut normalene rundt de endrede trekantene og laster opp de endrede delene av bufferne 
+    void updateEditedSurface(vector<size_t>& changedVertices);
+    //Regulær Delaunay triangulering 
+    TriangleMesh delaunayTriangulation();
+    //Punktene og normalene i vertices og linjene som viser normalene 
+    void Normals(const TriangleMesh& mesh);
+    //Tilpasser B-spline flaten til punktene og legger kontrollnettet i controlPoints 
+    void fitControlPoints();
+    //Punktene som float, også når de er kvantisert 
+    vector<glm::vec3> decodedPoints() const;
+    //Hash av alle innstillingene som påvirker flaten fra loadFunctions, nøkkelen i SurfaceCache 
+    uint64_t surfaceCacheKey(float reductionCellSize) const;
+    //Henter flaten fra SurfaceCache uten å laste opp bufferne, så den kan kalles på en arbeidstråd. Returnerer
+    //false hvis cachen ikke kan brukes. 
+    bool readCachedSurface(const vector<string>& filenames, float reductionCellSize);
+    //readCachedSurface og opplastingen av bufferne 
+    bool loadCachedSurface(const vector<string>& filenames, float reductionCellSize);
+    void saveCachedSurface(const vector<string>& filenames, float reductionCellSize) const;
+    //Laster opp alle bufferne til flaten og markerer den som klar 
+    void setupSurfaceBuffers();
 
     void setupBuffers();
     void setupNormalBuffers();
@@ -0,0 +1,659 @@
+#include "DelaunayTriangulator.h"
+#include "Predicates.h"
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+//Indeksen til (x, y) langs en Hilbert-kurve i et 2^16 x 2^16 rutenett
+//Referanse https://en.wikipedia.org/wiki/Hilbert_curve
+static uint64_t hilbertIndex(uint32_t x, uint32_t y)
+{
+    const uint32_t n = 1u << 16;
+    uint64_t d = 0;
+    for (uint32_t s = n / 2; s > 0; s /= 2)
+    {
+        uint32_t rx = (x & s) > 0 ? 1 : 0;
+        uint32_t ry = (y & s) > 0 ? 1 : 0;
+        d += static_cast<uint64_t>(s) * s * ((3 * rx) ^ ry);
+        if (ry == 0)
+        {
+            if (rx == 1)
+            {
+                x = n - 1 - x;
+                y = n - 1 - y;
+            }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+DelaunayTriangulator::DelaunayTriangulator() : lastTriangle(0), duplicates(0), randomState(2463534242u), recordChanges(false),
+visitStamp(0) {}
+
+static int compare(double a, double b)
+{
+    return (a > b) - (a < b);
+}
+
+//Hjørnene i den store trekanten ligger på (-X, -Y) for 0, (X', -Y') for 1 og (-x, y) for 2, der koordinatene er
+//uendelig store og y >> X >> Y >> X' >> Y' >> x. Hjørne 2 er altså uendelig mye lenger unna enn 0, og 0 enn 1.
+//Fortegnet til orient2d(a, b, hjørne) for to vanlige punkter a og b er da gitt av leddet med den største
+//koordinaten, og leddet med den nest største hvis a og b ligger på linje med hjørnet. To eller tre hjørner ligger
+//alltid mot klokka i rekkefølgen 0, 1, 2, uansett hvor det vanlige punktet ligger.
+int DelaunayTriangulator::orientation(int a, int b, int c) const
+{
+    int supers = (a < superVertexCount) + (b < superVertexCount) + (c < superVertexCount);
+    if (supers == 0)
+    {
+        double value = orient2d(vertices[a], vertices[b], vertices[c]);
+        return (value > 0.0) - (value < 0.0);
+    }
+    if (supers == 3)
+    {
+        return b == (a + 1) % superVertexCount ? 1 : -1;
+    }
+    //Roterer (samme fortegn) slik at hjørnene fra den store trekanten kommer sist
+    while ((supers == 1 && c >= superVertexCount) || (supers == 2 && a < superVertexCount))
+    {
+        int first = a;
+        a = b;
+        b = c;
+        c = first;
+    }
+    if (supers == 2)
+    {
+        return c == (b + 1) % superVertexCount ? 1 : -1;
+    }
+
+    const glm::dvec2& p = vertices[a];
+    const glm::dvec2& q = vertices[b];
+    int sign = 0;
+    if (c == 0)
+    {
+        sign = compare(q.y, p.y);
+        return sign != 0 ? sign : compare(p.x, q.x);
+    }
+    if (c == 1)
+    {
+        sign = compare(p.y, q.y);
+        return sign != 0 ? sign : compare(p.x, q.x);
+    }
+    sign = compare(q.x, p.x);
+    return sign != 0 ? sign : compare(q.y, p.y);
+}
+
+//Om d ligger inne i sirkelen gjennom trekanten (a, b, c). Punktene på sirkelen avgjøres med inCircleSymbolic, så
+//hulrommet blir det samme uansett rekkefølge på punktene. Er noen av hjørnene fra den store trekanten med, bestemmer
+//hjørnet som ligger lengst unna: er det d, ligger d utenfor. Ellers blir sirkelen til halvplanet på samme side
+//av linjen gjennom de to andre hjørnene som dette hjørnet, og punkter på linjen er inne bare mellom de to hjørnene.
+bool DelaunayTriangulator::inCircumcircle(int a, int b, int c, int d) const
+{
+    if (a >= superVertexCount && b >= superVertexCount && c >= superVertexCount && d >= superVertexCount)
+    {
+        return inCircleSymbolic(vertices[a], vertices[b], vertices[c], vertices[d]) > 0;
+    }
+
+    //Hjørne 2 ligger lengst unna, så 0, så 1
+    const int distance[superVertexCount] = { 2, 1, 3 };
+    auto farness = [&](int v) { return v < superVertexCount ? distance[v] : 0; };
+    int farthest = max(max(farness(a), farness(b)), max(farness(c), farness(d)));
+    if (farness(d) == farthest)
+    {
+        return false;
+    }
+    //Roterer trekanten så hjørnet som ligger lengst unna kommer sist
+    while (farness(c) != farthest)
+    {
+        int first = a;
+        a = b;
+        b = c;
+        c = first;
+    }
+
+    int side = orientation(a, b, d);
+    if (side != 0)
+    {
+        return side > 0;
+    }
+    //d ligger på linjen gjennom a og b, og alle tre er vanlige punkter
+    const glm::dvec2& p = vertices[a];
+    const glm::dvec2& q = vertices[b];
+    const glm::dvec2& r = vertices[d];
+    if (p.x != q.x)
+    {
+        return min(p.x, q.x) < r.x && r.x < max(p.x, q.x);
+    }
+    return min(p.y, q.y) < r.y && r.y < max(p.y, q.y);
+}
+
+bool DelaunayTriangulator::inCircumcircle(int triangle, int vertex) const
+{
+    const glm::ivec3& v = triangleVertices[triangle];
+    return inCircumcircle(v.x, v.y, v.z, vertex);
+}
+
+//Lager den store trekanten som alle punktene ligger inne i. Hjørnene har ingen koordinater (se orientation).
+void DelaunayTriangulator::reset()
+{
+    vertices.assign(superVertexCount, glm::dvec2(0.0));
+    triangleVertices.assign(1, glm::ivec3(0, 1, 2));
+    neighbours.assign(1, glm::ivec3(-1));
+    alive.assign(1, 1);
+    vertexTriangles.assign(superVertexCount, 0);
+    freeTriangles.clear();
+    changed.clear();
+    recordChanges = true;
+    visited.assign(1, 0);
+    visitStamp = 0;
+    lastTriangle = 0;
+    duplicates = 0;
+}
+
+void DelaunayTriangulator::triangulate(const vector<glm::dvec2>& points)
+{
+    glm::dvec2 minBounds(0.0), maxBounds(0.0);
+    if (!points.empty())
+    {
+        minBounds = maxBounds = points[0];
+        for (const auto& point : points)
+        {
+            minBounds = glm::min(minBounds, point);
+            maxBounds = glm::max(maxBounds, point);
+        }
+    }
+    reset();
+    recordChanges = false;
+
+    size_t count = points.size();
+    vertices.insert(vertices.end(), points.begin(), points.end());
+    vertexTriangles.resize(vertices.size(), -1);
+    triangleVertices.reserve(2 * count + 1);
+    neighbours.reserve(2 * count + 1);
+    alive.reserve(2 * count + 1);
+    visited.reserve(2 * count + 1);
+    newTriangleFrom.assign(vertices.size(), -1);
+
+    //BRIO: tilfeldig rekkefølge, delt i runder der hver runde er dobbelt så stor som den før.
+    //Innenfor hver runde sorteres punktene langs Hilbert-kurven.
+    vector<uint32_t> order(count);
+    iota(order.begin(), order.end(), 0u);
+    mt19937 random(12345);
+    shuffle(order.begin(), order.end(), random);
+
+    glm::dvec2 extent = glm::max(maxBounds - minBounds, glm::dvec2(1e-300));
+    vector<uint64_t> curveIndex(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::dvec2 scaled = (points[i] - minBounds) / extent * 65535.0;
+        curveIndex[i] = hilbertIndex(static_cast<uint32_t>(scaled.x), static_cast<uint32_t>(scaled.y));
+    }
+
+    size_t roundEnd = count;
+    while (roundEnd > 0)
+    {
+        size_t roundStart = roundEnd > 64 ? roundEnd / 2 : 0;
+        sort(order.begin() + roundStart, order.begin() + roundEnd,
+            [&](uint32_t a, uint32_t b) { return curveIndex[a] < curveIndex[b]; });
+        roundEnd = roundStart;
+    }
+
+    for (uint32_t index : order)
+    {
+        if (insertVertex(static_cast<int>(index) + superVertexCount) < 0)
+        {
+            ++duplicates;
+        }
+    }
+    recordChanges = true;
+}
+
+int DelaunayTriangulator::insertPoint(const glm::dvec2& point)
+{
+    if (vertices.empty())
+    {
+        reset();
+    }
+    vertices.push_back(point);
+    vertexTriangles.push_back(-1);
+    newTriangleFrom.push_back(-1);
+    int vertex = static_cast<int>(vertices.size()) - 1;
+    if (insertVertex(vertex) < 0)
+    {
+        vertices.pop_back();
+        vertexTriangles.pop_back();
+        newTriangleFrom.pop_back();
+        ++duplicates;
+        return -1;
+    }
+    return vertex - superVertexCount;
+}
+
+bool DelaunayTriangulator::removePoint(int index)
+{
+    if (index < 0 || index >= static_cast<int>(pointCount()))
+    {
+        return false;
+    }
+    int vertex = index + superVertexCount;
+    if (vertexTriangles[vertex] >= 0)
+    {
+        removeVertex(vertex);
+    }
+
+    //Det siste punktet får indeksen som ble ledig. Bare trekantene rundt det må skrives om.
+    int last = static_cast<int>(vertices.size()) - 1;
+    if (vertex != last)
+    {
+        int start = vertexTriangles[last];
+        if (start >= 0)
+        {
+            int t = start;
+            do
+            {
+                glm::ivec3& v = triangleVertices[t];
+                int corner = v.x == last ? 0 : (v.y == last ? 1 : 2);
+                v[corner] = vertex;
+                if (recordChanges)
+                {
+                    changed.push_back(t);
+                }
+                t = neighbours[t][(corner + 1) % 3];
+            } while (t != start);
+        }
+        vertices[vertex] = vertices[last];
+        vertexTriangles[vertex] = start;
+    }
+    vertices.pop_back();
+    vertexTriangles.pop_back();
+    newTriangleFrom.pop_back();
+    return true;
+}
+
+bool DelaunayTriangulator::movePoint(int index, const glm::dvec2& point)
+{
+    if (index < 0 || index >= static_cast<int>(pointCount()))
+    {
+        return false;
+    }
+    int vertex = index + superVertexCount;
+    glm::dvec2 oldPoint = vertices[vertex];
+    bool inserted = vertexTriangles[vertex] >= 0;
+    if (inserted)
+    {
+        removeVertex(vertex);
+    }
+    vertices[vertex] = point;
+    if (insertVertex(vertex) >= 0)
+    {
+        return true;
+    }
+
+    //Det lå allerede et punkt der, så punktet settes tilbake
+    vertices[vertex] = oldPoint;
+    if (inserted)
+    {
+        insertVertex(vertex);
+    }
+    return false;
+}
+
+glm::ivec3 DelaunayTriangulator::drawableTriangle(int t) const
+{
+    const glm::ivec3& v = triangleVertices[t];
+    if (alive[t] && v.x >= superVertexCount && v.y >= superVertexCount && v.z >= superVertexCount)
+    {
+        return v - glm::ivec3(superVertexCount);
+    }
+    return glm::ivec3(0);
+}
+
+vector<int> DelaunayTriangulator::changedPoints() const
+{
+    vector<int> result;
+    for (int t : changed)
+    {
+        if (!alive[t])
+        {
+            continue;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            if (triangleVertices[t][i] >= superVertexCount)
+            {
+                result.push_back(triangleVertices[t][i] - superVertexCount);
+            }
+        }
+    }
+    return result;
+}
+
+//Går fra trekant til trekant mot punktet. I hver trekant velges en tilfeldig kant å starte med, og kanten
+//vi kom fra hoppes over, så gangen ikke kan gå i ring.
+//Referanse Devillers, Pion og Teillaud, "Walking in a triangulation" (2001)
+int DelaunayTriangulator::locate(int vertex, int startTriangle)
+{
+    int triangle = startTriangle;
+    int previous = -1;
+    while (true)
+    {
+        randomState ^= randomState << 13;
+        randomState ^= randomState >> 17;
+        randomState ^= randomState << 5;
+        int first = static_cast<int>(randomState % 3);
+
+        int next = -1;
+        for (int k = 0; k < 3; ++k)
+        {
+            int i = (first + k) % 3;
+            int neighbour = neighbours[triangle][i];
+            if (neighbour < 0 || neighbour == previous)
+            {
+                continue;
+            }
+            const glm::ivec3& v = triangleVertices[triangle];
+            if (orientation(v[(i + 1) % 3], v[(i + 2) % 3], vertex) < 0)
+            {
+                next = neighbour;
+                break;
+            }
+        }
+
+        if (next < 0)
+        {
+            return triangle;
+        }
+        previous = triangle;
+        triangle = next;
+    }
+}
+
+int DelaunayTriangulator::allocateTriangle()
+{
+    if (!freeTriangles.empty())
+    {
+        int triangle = freeTriangles.back();
+        freeTriangles.pop_back();
+        alive[triangle] = 1;
+        if (recordChanges)
+        {
+            changed.push_back(triangle);
+        }
+        return triangle;
+    }
+    triangleVertices.push_back(glm::ivec3(-1));
+    neighbours.push_back(glm::ivec3(-1));
+    alive.push_back(1);
+    visited.push_back(0);
+    int triangle = static_cast<int>(triangleVertices.size()) - 1;
+    if (recordChanges)
+    {
+        changed.push_back(triangle);
+    }
+    return triangle;
+}
+
+void DelaunayTriangulator::killTriangle(int triangle)
+{
+    alive[triangle] = 0;
+    freeTriangles.push_back(triangle);
+    if (recordChanges)
+    {
+        changed.push_back(triangle);
+    }
+}
+
+//Lager trekanten (a, b, c) med naboene på andre siden av kantene motsatt a, b og c, og kobler naboene tilbake
+int DelaunayTriangulator::createTriangle(int a, int b, int c, int acrossA, int acrossB, int acrossC)
+{
+    int triangle = allocateTriangle();
+    glm::ivec3 v(a, b, c);
+    glm::ivec3 across(acrossA, acrossB, acrossC);
+    triangleVertices[triangle] = v;
+    neighbours[triangle] = across;
+    for (int k = 0; k < 3; ++k)
+    {
+        vertexTriangles[v[k]] = triangle;
+        int outside = across[k];
+        if (outside < 0)
+        {
+            continue;
+        }
+        //Kanten fra v[k + 1] til v[k + 2] går motsatt vei i naboen
+        const glm::ivec3& outsideVertices = triangleVertices[outside];
+        for (int i = 0; i < 3; ++i)
+        {
+            if (outsideVertices[(i + 1) % 3] == v[(k + 2) % 3] && outsideVertices[(i + 2) % 3] == v[(k + 1) % 3])
+            {
+                neighbours[outside][i] = triangle;
+                break;
+            }
+        }
+    }
+    return triangle;
+}
+
+//Fjerner trekantene rundt punktet og fyller hullet med øre-klipping: et øre (tre hjørner etter hverandre på randen
+//av hullet) som er konvekst og ikke har noen av de andre hjørnene i den omskrevne sirkelen, er en Delaunay trekant.
+//Det klippes av og hullet blir ett hjørne mindre. Hullet har i snitt 6 hjørner, så dette går raskt.
+//Referanse Devillers, "On deletion in Delaunay triangulations" (1999)
+void DelaunayTriangulator::removeVertex(int vertex)
+{
+    //Randen av hullet mot klokka. Kant i går fra hole[i] til hole[i + 1], og holeOutside[i] er trekanten utenfor.
+    hole.clear();
+    holeOutside.clear();
+    int start = vertexTriangles[vertex];
+    int t = start;
+    do
+    {
+        const glm::ivec3& v = triangleVertices[t];
+        int corner = v.x == vertex ? 0 : (v.y == vertex ? 1 : 2);
+        hole.push_back(v[(corner + 1) % 3]);
+        holeOutside.push_back(neighbours[t][corner]);
+        int next = neighbours[t][(corner + 1) % 3];
+        killTriangle(t);
+        t = next;
+    } while (t != start);
+    vertexTriangles[vertex] = -1;
+
+    while (hole.size() > 3)
+    {
+        size_t n = hole.size();
+        size_t ear = n;
+        size_t convex = n;
+        for (size_t i = 0; i < n && ear == n; ++i)
+        {
+            int a = hole[(i + n - 1) % n];
+            int b = hole[i];
+            int c = hole[(i + 1) % n];
+            if (orientation(a, b, c) <= 0)
+            {
+                continue;
+            }
+            convex = min(convex, i);
+            bool empty = true;
+            for (size_t j = 0; j < n && empty; ++j)
+            {
+                if (j != i && j != (i + n - 1) % n && j != (i + 1) % n)
+                {
+                    empty = !inCircumcircle(a, b, c, hole[j]);
+                }
+            }
+            if (empty)
+            {
+                ear = i;
+            }
+        }
+        //Det finnes alltid et slikt øre, men et konvekst øre holder nettet sammenhengende om noe skulle gå galt
+        if (ear == n)
+        {
+            ear = convex < n ? convex : 0;
+        }
+
+        size_t previous = (ear + n - 1) % n;
+        int triangle = createTriangle(hole[previous], hole[ear], hole[(ear + 1) % n], holeOutside[ear], -1, holeOutside[previous]);
+        holeOutside[previous] = triangle;
+        hole.erase(hole.begin() + ear);
+        holeOutside.erase(holeOutside.begin() + ear);
+    }
+    lastTriangle = createTriangle(hole[0], hole[1], hole[2], holeOutside[1], holeOutside[2], holeOutside[0]);
+}
+
+int DelaunayTriangulator::insertVertex(int vertex)
+{
+    const glm::dvec2 point = vertices[vertex];
+    int start = locate(vertex, alive[lastTriangle] ? lastTriangle : 0);
+
+    //Et punkt som ligger oppå et hjørne i trekanten det havnet i, settes ikke inn
+    const glm::ivec3& startVertices = triangleVertices[start];
+    for (int i = 0; i < 3; ++i)
+    {
+        if (startVertices[i] >= superVertexCount && vertices[startVertices[i]] == point)
+        {
+            return -1;
+        }
+    }
+
+    //Hulrommet: alle trekanter som er sammenhengende med start og har punktet i den omskrevne sirkelen.
+    //Kantene der naboen ikke er med blir randen av hulrommet.
+    ++visitStamp;
+    cavity.clear();
+    boundary.clear();
+    stack.clear();
+    stack.push_back(start);
+    cavity.push_back(start);
+    visited[start] = visitStamp;
+    while (!stack.empty())
+    {
+        int triangle = stack.back();
+        stack.pop_back();
+        for (int i = 0; i < 3; ++i)
+        {
+            int neighbour = neighbours[triangle][i];
+            if (neighbour >= 0 && visited[neighbour] == visitStamp)
+            {
+                continue;
+            }
+            if (neighbour >= 0 && inCircumcircle(neighbour, vertex))
+            {
+                visited[neighbour] = visitStamp;
+                cavity.push_back(neighbour);
+                stack.push_back(neighbour);
+            }
+            else
+            {
+                const glm::ivec3& v = triangleVertices[triangle];
+                boundary.push_back({ v[(i + 1) % 3], v[(i + 2) % 3], neighbour });
+            }
+        }
+    }
+
+    for (int triangle : cavity)
+    {
+        killTriangle(triangle);
+    }
+
+    //Én ny trekant (a, b, punkt) for hver kant på randen
+    for (const auto& edge : boundary)
+    {
+        int triangle = allocateTriangle();
+        triangleVertices[triangle] = glm::ivec3(edge.a, edge.b, vertex);
+        neighbours[triangle] = glm::ivec3(-1, -1, edge.outside);
+        //Naboen utenfor finner kanten via hjørnene (b, a). Indeksen til den gamle trekanten kan allerede være
+        //gjenbrukt av en av de nye trekantene, så den kan ikke brukes til å finne kanten.
+        if (edge.outside >= 0)
+        {
+            const glm::ivec3& outsideVertices = triangleVertices[edge.outside];
+            for (int i = 0; i < 3; ++i)
+            {
+                if (outsideVertices[(i + 1) % 3] == edge.b && outsideVertices[(i + 2) % 3] == edge.a)
+                {
+                    neighbours[edge.outside][i] = triangle;
+                    break;
+                }
+            }
+        }
+        newTriangleFrom[edge.a] = triangle;
+        vertexTriangles[edge.a] = triangle;
+        lastTriangle = triangle;
+    }
+
+    //Trekanten som starter i b ligger på andre siden av kanten (b, punkt)
+    for (size_t i = 0; i < boundary.size(); ++i)
+    {
+        int triangle = newTriangleFrom[boundary[i].a];
+        int next = newTriangleFrom[boundary[i].b];
+        neighbours[triangle][0] = next;
+        neighbours[next][1] = triangle;
+    }
+    vertexTriangles[vertex] = lastTriangle;
+    return vertex;
+}
+
+vector<glm::ivec3> DelaunayTriangulator::triangles() const
+{
+    vector<glm::ivec3> result;
+    result.reserve(triangleVertices.size());
+    for (size_t t = 0; t < triangleVertices.size(); ++t)
+    {
+        const glm::ivec3& v = triangleVertices[t];
+        if (alive[t] && v.x >= superVertexCount && v.y >= superVertexCount && v.z >= superVertexCount)
+        {
+            result.push_back(v - glm::ivec3(superVertexCount));
+        }
+    }
+    return result;
+}
+
+TriangleMesh DelaunayTriangulator::mesh() const
+{
+    //Nytt nummer for hver trekant som er med, -1 for de andre
+    vector<int> remap(triangleVertices.size(), -1);
+    int count = 0;
+    for (size_t t = 0; t < triangleVertices.size(); ++t)
+    {
+        const glm::ivec3& v = triangleVertices[t];
+        if (alive[t] && v.x >= superVertexCount && v.y >= superVertexCount && v.z >= superVertexCount)
+        {
+            remap[t] = count++;
+        }
+    }
+
+    vector<glm::ivec3> meshTriangles(count);
+    vector<glm::ivec3> meshNeighbours(count);
+    for (size_t t = 0; t < triangleVertices.size(); ++t)
+    {
+        if (remap[t] < 0)
+        {
+            continue;
+        }
+        meshTriangles[remap[t]] = triangleVertices[t] - glm::ivec3(superVertexCount);
+        for (int i = 0; i < 3; ++i)
+        {
+            int across = neighbours[t][i];
+            meshNeighbours[remap[t]][i] = across >= 0 ? remap[across] : -1;
+        }
+    }
+    return TriangleMesh(pointCount(), move(meshTriangles), move(meshNeighbours));
+}
+
+vector<char> DelaunayTriangulator::boundaryVertices() const
+{
+    vector<char> result(pointCount(), 0);
+    for (size_t t = 0; t < triangleVertices.size(); ++t)
+    {
+        const glm::ivec3& v = triangleVertices[t];
+        if (!alive[t] || (v.x >= superVertexCount && v.y >= superVertexCount && v.z >= superVertexCount))
+        {
+            continue;
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            if (v[i] >= superVertexCount)
+            {
+                result[v[i] - superVertexCount] = 1;
+            }
+        }
+    }
+    return result;
+}
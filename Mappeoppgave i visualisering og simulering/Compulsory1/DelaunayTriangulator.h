@@ -0,0 +1,141 @@
+#ifndef DELAUNAYTRIANGULATOR_H
+#define DELAUNAYTRIANGULATOR_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "TriangleMesh.h"
+
+using namespace std;
+
+//Inkrementell Delaunay triangulering (Bowyer-Watson) som tar vare på hvilke trekanter som er naboer.
+//Punktene settes inn i BRIO-rekkefølge: de stokkes tilfeldig, deles i runder som dobles i størrelse, og
+//hver runde sorteres langs en Hilbert-kurve. Da ligger hvert nytt punkt nær det forrige, og trekanten som
+//inneholder punktet finnes ved å gå fra nabo til nabo fra den sist lagde trekanten. De trekantene som har
+//punktet inne i den omskrevne sirkelen (hulrommet) finnes ved å gå utover fra denne trekanten (flood fill),
+//så hvert punkt koster omtrent like mye uansett hvor mange punkter som er satt inn. Totalt O(n log n).
+//
+//Trekant t har hjørnene vertices[t] mot klokka. neighbours[t][i] er trekanten på andre siden av kanten
+//motsatt hjørne i, dvs. kanten fra hjørne i + 1 til hjørne i + 2. Testene er eksakte (Predicates.h), men
+//den raske veien brukes oftere når punktene ligger rundt origo.
+//
+//Den store trekanten rundt punktene har ingen koordinater. Hjørnene regnes som uendelig langt unna (symbolsk),
+//og hvert hjørne uendelig mye lenger unna enn det neste, så testene med dem avgjøres bare med sammenligninger av
+//koordinatene. Et slikt hjørne ligger aldri i sirkelen gjennom tre vanlige punkter, så ingen trekanter langs
+//randen går tapt og randen blir alltid det konvekse skallet av punktene.
+//Referanse de Berg m.fl., "Computational Geometry", kapittel 9.3 (de symbolske punktene p-1 og p-2)
+class DelaunayTriangulator
+{
+public:
+    DelaunayTriangulator();
+
+    //Triangulerer punktene. Etter kallet kan flere punkter settes inn med insertPoint.
+    void triangulate(const vector<glm::dvec2>& points);
+
+    //Setter inn ett punkt og returnerer indeksen til punktet, eller -1 hvis det finnes et punkt på samme sted
+    int insertPoint(const glm::dvec2& point);
+    //Fjerner punktet og triangulerer hullet rundt det på nytt. Det siste punktet flyttes til indeksen som ble
+    //ledig, slik at indeksene fortsatt er 0 til pointCount() - 1.
+    bool removePoint(int index);
+    //Flytter punktet: fjerner det og setter det inn på nytt med samme indeks. Returnerer false, og lar punktet
+    //ligge, hvis det allerede finnes et punkt på det nye stedet.
+    bool movePoint(int index, const glm::dvec2& point);
+
+    //Trekantene mot klokka, uten trekantene som bruker hjørnene til den store trekanten rundt punktene.
+    //Indeksene er indeksene til punktene som ble gitt til triangulate og insertPoint.
+    vector<glm::ivec3> triangles() const;
+    //De samme trekantene i samme rekkefølge som triangles(), med naboene. Kanter mot den store trekanten blir rand.
+    TriangleMesh mesh() const;
+    //1 for punktene som er hjørner i en trekant sammen med den store trekanten, dvs. punktene på randen av
+    //trianguleringen. Brukes når flere trianguleringer skal settes sammen.
+    vector<char> boundaryVertices() const;
+
+    //Trekantplassene etter endringene med insertPoint, removePoint og movePoint. Plassene til trekantene gjenbrukes,
+    //så trekant t ligger alltid på samme plass, og en endring berører bare plassene i changedTriangles().
+    //drawableTriangle(t) er trekanten med indeksene til punktene, eller (0, 0, 0) for plasser som er ledige
+    //eller bruker den store trekanten.
+    size_t triangleSlotCount() const { return triangleVertices.size(); }
+    glm::ivec3 drawableTriangle(int t) const;
+    //Plassene som er endret siden clearChangedTriangles(). Samme plass kan være med flere ganger.
+    const vector<int>& changedTriangles() const { return changed; }
+    void clearChangedTriangles() { changed.clear(); }
+    //Punktene i trekantene på de endrede plassene, også trekantene som bruker den store trekanten. Dette er alle
+    //punktene som har fått andre trekanter rundt seg. Samme punkt kan være med flere ganger.
+    vector<int> changedPoints() const;
+
+    //Kaller function(triangle) for hver trekant rundt punktet, med indeksene til punktene
+    template <class Function>
+    void forEachTriangleAround(int index, Function function) const
+    {
+        int vertex = index + superVertexCount;
+        int start = vertexTriangles[vertex];
+        if (start < 0)
+        {
+            return;
+        }
+        int t = start;
+        do
+        {
+            const glm::ivec3& v = triangleVertices[t];
+            if (v.x >= superVertexCount && v.y >= superVertexCount && v.z >= superVertexCount)
+            {
+                function(v - glm::ivec3(superVertexCount));
+            }
+            int corner = v.x == vertex ? 0 : (v.y == vertex ? 1 : 2);
+            t = neighbours[t][(corner + 1) % 3];
+        } while (t != start);
+    }
+
+    size_t pointCount() const { return vertices.empty() ? 0 : vertices.size() - superVertexCount; }
+    //Antall punkter som ikke ble satt inn fordi et annet punkt lå på samme sted
+    size_t duplicateCount() const { return duplicates; }
+
+private:
+    //De tre første hjørnene er den store trekanten rundt alle punktene: 0 uendelig langt til venstre, 1 til
+    //høyre og 2 oppover
+    static const int superVertexCount = 3;
+
+    void reset();
+    int insertVertex(int vertex);
+    void removeVertex(int vertex);
+    int createTriangle(int a, int b, int c, int acrossA, int acrossB, int acrossC);
+    void killTriangle(int triangle);
+    int locate(int vertex, int startTriangle);
+    //Testene med hjørnene gitt som indekser, også hjørnene til den store trekanten
+    int orientation(int a, int b, int c) const;
+    bool inCircumcircle(int a, int b, int c, int d) const;
+    bool inCircumcircle(int triangle, int vertex) const;
+    int allocateTriangle();
+
+    vector<glm::dvec2> vertices;
+    vector<glm::ivec3> triangleVertices;
+    vector<glm::ivec3> neighbours;
+    vector<char> alive;
+    //En trekant for hvert hjørne, -1 for punkter som ikke er satt inn
+    vector<int> vertexTriangles;
+    vector<int> freeTriangles;
+    int lastTriangle;
+    size_t duplicates;
+    uint32_t randomState;
+    //Endringene registreres bare etter triangulate, ikke mens alle punktene settes inn
+    bool recordChanges;
+    vector<int> changed;
+
+    //Arbeidstabeller for hulrommet, gjenbrukes mellom innsettingene
+    struct BoundaryEdge
+    {
+        int a, b;
+        int outside;
+    };
+    vector<uint32_t> visited;
+    uint32_t visitStamp;
+    vector<int> cavity;
+    vector<int> stack;
+    vector<BoundaryEdge> boundary;
+    vector<int> newTriangleFrom;
+    //Hullet etter et punkt som fjernes: hjørnene mot klokka og trekanten utenfor hver kant
+    vector<int> hole;
+    vector<int> holeOutside;
+};
+
+#endif
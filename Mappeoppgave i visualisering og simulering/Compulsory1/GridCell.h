@@ -0,0 +1,35 @@
+#ifndef GRIDCELL_H
+#define GRIDCELL_H
+
+#include <cstdint>
+#include <cmath>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+//Cellene og cellenøklene som GridReducer sorterer punktene på
+
+//Cellen et punkt ligger i, i et rutenett i xy-planet. Bruker floor, slik at -0.5 havner i celle -1
+//og ikke i celle 0 (static_cast<int> runder mot null og slår sammen cellene på hver side av null).
+inline glm::ivec2 gridCellOf(float x, float y, float cellSize)
+{
+    return glm::ivec2(static_cast<int>(floor(x / cellSize)), static_cast<int>(floor(y / cellSize)));
+}
+
+//Pakker cellen i en 64 bits nøkkel med y i de øverste 32 bitene og x i de nederste. Fortegnsbiten snus,
+//slik at nøklene sorteres i samme rekkefølge som cellene (rad for rad).
+inline uint64_t packCellKey(const glm::ivec2& cell)
+{
+    uint64_t keyX = static_cast<uint32_t>(cell.x) ^ 0x80000000u;
+    uint64_t keyY = static_cast<uint32_t>(cell.y) ^ 0x80000000u;
+    return (keyY << 32) | keyX;
+}
+
+inline glm::ivec2 unpackCellKey(uint64_t key)
+{
+    uint32_t keyX = static_cast<uint32_t>(key) ^ 0x80000000u;
+    uint32_t keyY = static_cast<uint32_t>(key >> 32) ^ 0x80000000u;
+    return glm::ivec2(static_cast<int32_t>(keyX), static_cast<int32_t>(keyY));
+}
+
+#endif
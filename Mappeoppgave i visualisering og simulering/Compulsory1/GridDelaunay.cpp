@@ -0,0 +1,333 @@
+#include "GridDelaunay.h"
+#include "Predicates.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <limits>
+
+//Største andel av punktene som kan ligge utenfor rutenettet, og største antall hjørner i rutenettet per punkt
+static const double maximumIrregularFraction = 0.1;
+static const double maximumNodesPerPoint = 4.0;
+//Hvor langt fra et hjørne et punkt kan ligge og fortsatt høre til rutenettet, målt i den minste avstanden mellom rutene
+static const double latticeTolerance = 0.01;
+
+//Avstanden mellom rutene langs aksen. Avstandene mellom punkter som ligger etter hverandre (større enn minimum) er
+//for det meste ett steg, så steget er den avstanden flest av dem ligger nær. Den finnes i et utvalg på høyst
+//stepSamples avstander, så det koster det samme uansett antall punkter. Gjennomsnittet av avstandene nær steget
+//jevner ut avrundingen i float-koordinatene. anchor blir koordinaten til et punkt på rutenettet: blant noen av
+//punktene som ligger ett steg fra punktet før, velges det flest av punktene i utvalget ligger et helt antall steg fra.
+static double gridStep(const vector<glm::dvec2>& points, int axis, double minimum, double& anchor)
+{
+    const size_t stepSamples = 4096;
+    const double window = 0.02;
+
+    //Langs y er de fleste avstandene 0 (punktene i samme rad), så utvalget tas bare blant avstandene over minimum
+    size_t differenceCount = 0;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        differenceCount += fabs(points[i][axis] - points[i - 1][axis]) > minimum ? 1 : 0;
+    }
+    vector<double> samples;
+    size_t stride = max<size_t>(differenceCount / stepSamples, 1);
+    for (size_t i = 1, k = 0; i < points.size(); ++i)
+    {
+        double difference = fabs(points[i][axis] - points[i - 1][axis]);
+        if (difference > minimum && k++ % stride == 0)
+        {
+            samples.push_back(difference);
+        }
+    }
+    if (samples.empty())
+    {
+        return numeric_limits<double>::infinity();
+    }
+    sort(samples.begin(), samples.end());
+    double step = samples[0];
+    size_t bestCount = 0;
+    for (size_t first = 0, last = 0; first < samples.size(); ++first)
+    {
+        while (last < samples.size() && samples[last] <= samples[first] * (1.0 + window))
+        {
+            ++last;
+        }
+        if (last - first > bestCount)
+        {
+            bestCount = last - first;
+            step = samples[first];
+        }
+    }
+
+    const size_t anchorCandidates = 8;
+    double sum = 0.0;
+    size_t steps = 0;
+    vector<double> candidates;
+    size_t candidateInterval = bestCount * stride / anchorCandidates + 1;
+    for (size_t i = 1; i < points.size(); ++i)
+    {
+        double difference = fabs(points[i][axis] - points[i - 1][axis]);
+        if (difference >= step && difference <= step * (1.0 + window))
+        {
+            sum += difference;
+            ++steps;
+            if (candidates.size() < anchorCandidates && (steps - 1) % candidateInterval == 0)
+            {
+                candidates.push_back(points[i][axis]);
+            }
+        }
+    }
+    step = sum / steps;
+
+    size_t bestHits = 0;
+    anchor = candidates[0];
+    for (double candidate : candidates)
+    {
+        size_t hits = 0;
+        for (size_t i = 0; i < points.size(); i += max<size_t>(points.size() / stepSamples, 1))
+        {
+            double position = (points[i][axis] - candidate) / step;
+            hits += fabs(position - round(position)) <= latticeTolerance ? 1 : 0;
+        }
+        if (hits > bestHits)
+        {
+            bestHits = hits;
+            anchor = candidate;
+        }
+    }
+    return step;
+}
+
+bool gridDelaunayTriangulation(const vector<glm::dvec2>& points, vector<glm::ivec3>& triangles, unsigned int threadCount,
+    TriangulationStatistics* statistics)
+{
+    auto startTime = chrono::steady_clock::now();
+    if (threadCount == 0)
+    {
+        threadCount = workerCount();
+    }
+    size_t count = points.size();
+    if (count < 4)
+    {
+        return false;
+    }
+
+    glm::dvec2 minBounds = points[0], maxBounds = points[0];
+    for (const auto& point : points)
+    {
+        minBounds = glm::min(minBounds, point);
+        maxBounds = glm::max(maxBounds, point);
+    }
+    glm::dvec2 extent = maxBounds - minBounds;
+    double minimumStep = 1e-9 * max(extent.x, extent.y);
+    glm::dvec2 anchor(0.0);
+    glm::dvec2 spacing(gridStep(points, 0, minimumStep, anchor.x), gridStep(points, 1, minimumStep, anchor.y));
+    if (!isfinite(spacing.x) || !isfinite(spacing.y))
+    {
+        return false;
+    }
+    glm::dvec2 tolerance = glm::dvec2(latticeTolerance * min(spacing.x, spacing.y)) / spacing;
+
+    //Hjørnet punktet ligger på, regnet fra anker. false hvis punktet ikke ligger på rutenettet.
+    auto nodeOf = [&](const glm::dvec2& point, glm::dvec2& node)
+    {
+        glm::dvec2 position = (point - anchor) / spacing;
+        node = glm::round(position);
+        return !glm::any(glm::greaterThan(glm::abs(position - node), tolerance));
+    };
+
+    //Hvor stort rutenettet er, fra hjørnene punktene på rutenettet ligger på
+    glm::dvec2 minNode(numeric_limits<double>::infinity()), maxNode(-numeric_limits<double>::infinity());
+    size_t latticeCount = 0;
+    for (const auto& point : points)
+    {
+        glm::dvec2 node;
+        if (nodeOf(point, node))
+        {
+            minNode = glm::min(minNode, node);
+            maxNode = glm::max(maxNode, node);
+            ++latticeCount;
+        }
+    }
+    if (count - latticeCount > maximumIrregularFraction * count)
+    {
+        return false;
+    }
+    double columnCount = maxNode.x - minNode.x + 1.0;
+    double rowCount = maxNode.y - minNode.y + 1.0;
+    if (columnCount < 2.0 || rowCount < 2.0 || columnCount * rowCount > maximumNodesPerPoint * count)
+    {
+        return false;
+    }
+    int columns = static_cast<int>(columnCount);
+    int rows = static_cast<int>(rowCount);
+    glm::dvec2 origin = anchor + minNode * spacing;
+
+    //Punktet på hvert hjørne: -1 for tomme hjørner, -2 for hjørner med flere punkter (de blir resten).
+    //Punkter utenfor rutenettet blir skjøtpunkter med en gang.
+    vector<int> nodePoint(static_cast<size_t>(columns) * rows, -1);
+    vector<char> isSeam(count, 0);
+    size_t irregularCount = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        glm::dvec2 node;
+        if (!nodeOf(points[i], node))
+        {
+            isSeam[i] = 1;
+            ++irregularCount;
+            continue;
+        }
+        node -= minNode;
+        int& slot = nodePoint[static_cast<size_t>(node.y) * columns + static_cast<size_t>(node.x)];
+        if (slot == -1)
+        {
+            slot = static_cast<int>(i);
+            continue;
+        }
+        if (slot >= 0)
+        {
+            isSeam[slot] = 1;
+            ++irregularCount;
+            slot = -2;
+        }
+        isSeam[i] = 1;
+        ++irregularCount;
+    }
+    if (irregularCount > maximumIrregularFraction * count)
+    {
+        return false;
+    }
+
+    //Resten av punktene sortert på ruten de ligger i (tellesortering)
+    int cellColumns = columns - 1;
+    int cellRows = rows - 1;
+    auto cellOf = [&](const glm::dvec2& point)
+    {
+        glm::dvec2 position = glm::floor((point - origin) / spacing);
+        glm::ivec2 cell(static_cast<int>(position.x), static_cast<int>(position.y));
+        return glm::clamp(cell, glm::ivec2(0), glm::ivec2(cellColumns - 1, cellRows - 1));
+    };
+    vector<uint32_t> cellStart(static_cast<size_t>(cellColumns) * cellRows + 1, 0);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (isSeam[i])
+        {
+            glm::ivec2 cell = cellOf(points[i]);
+            ++cellStart[static_cast<size_t>(cell.y) * cellColumns + cell.x + 1];
+        }
+    }
+    for (size_t c = 1; c < cellStart.size(); ++c)
+    {
+        cellStart[c] += cellStart[c - 1];
+    }
+    vector<uint32_t> irregularPoints(irregularCount);
+    vector<uint32_t> position(cellStart.begin(), cellStart.end() - 1);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (isSeam[i])
+        {
+            glm::ivec2 cell = cellOf(points[i]);
+            irregularPoints[position[static_cast<size_t>(cell.y) * cellColumns + cell.x]++] = static_cast<uint32_t>(i);
+        }
+    }
+
+    //Den omskrevne sirkelen til en rute har radius lik halve diagonalen og kan nå så mange ruter utenfor ruten
+    double radius = 0.5 * glm::length(spacing);
+    glm::ivec2 reach(static_cast<int>(ceil((radius - 0.5 * spacing.x) / spacing.x + 0.05)),
+        static_cast<int>(ceil((radius - 0.5 * spacing.y) / spacing.y + 0.05)));
+
+    //To trekanter for hver rute som har alle fire hjørnene. Diagonalen er den som gir Delaunay trekanter.
+    vector<char> cellFinal(static_cast<size_t>(cellColumns) * cellRows, 0);
+    vector<vector<glm::ivec3>> finalTriangles(threadCount);
+    parallelFor(static_cast<size_t>(cellRows), threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+    {
+        for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+        {
+            for (int x = 0; x < cellColumns; ++x)
+            {
+                int a = nodePoint[static_cast<size_t>(y) * columns + x];
+                int b = nodePoint[static_cast<size_t>(y) * columns + x + 1];
+                int c = nodePoint[static_cast<size_t>(y + 1) * columns + x + 1];
+                int d = nodePoint[static_cast<size_t>(y + 1) * columns + x];
+                if (a < 0 || b < 0 || c < 0 || d < 0)
+                {
+                    continue;
+                }
+
+                glm::ivec3 first(a, b, c), second(a, c, d);
+                if (inCircleSymbolic(points[a], points[b], points[c], points[d]) > 0)
+                {
+                    first = glm::ivec3(a, b, d);
+                    second = glm::ivec3(b, c, d);
+                }
+
+                //Ruten er ferdig hvis ingen av punktene utenfor rutenettet ligger i sirkelen
+                bool empty = true;
+                for (int cy = max(y - reach.y, 0); cy <= min(y + reach.y, cellRows - 1) && empty; ++cy)
+                {
+                    for (int cx = max(x - reach.x, 0); cx <= min(x + reach.x, cellColumns - 1) && empty; ++cx)
+                    {
+                        size_t cell = static_cast<size_t>(cy) * cellColumns + cx;
+                        for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1] && empty; ++k)
+                        {
+                            const glm::dvec2& point = points[irregularPoints[k]];
+                            empty = inCircleSymbolic(points[first.x], points[first.y], points[first.z], point) <= 0 &&
+                                inCircleSymbolic(points[second.x], points[second.y], points[second.z], point) <= 0;
+                        }
+                    }
+                }
+                if (empty)
+                {
+                    cellFinal[static_cast<size_t>(y) * cellColumns + x] = 1;
+                    finalTriangles[chunk].push_back(first);
+                    finalTriangles[chunk].push_back(second);
+                }
+            }
+        }
+    });
+
+    //Hjørner som ikke har fire ferdige ruter rundt seg hører til skjøten
+    parallelFor(static_cast<size_t>(rows), threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (int y = static_cast<int>(begin); y < static_cast<int>(end); ++y)
+        {
+            for (int x = 0; x < columns; ++x)
+            {
+                int point = nodePoint[static_cast<size_t>(y) * columns + x];
+                if (point < 0)
+                {
+                    continue;
+                }
+                bool surrounded = x > 0 && y > 0 && x < cellColumns && y < cellRows;
+                for (int cy = y - 1; cy <= y && surrounded; ++cy)
+                {
+                    for (int cx = x - 1; cx <= x && surrounded; ++cx)
+                    {
+                        surrounded = cellFinal[static_cast<size_t>(cy) * cellColumns + cx] != 0;
+                    }
+                }
+                if (!surrounded)
+                {
+                    isSeam[point] = 1;
+                }
+            }
+        }
+    });
+    auto gridTime = chrono::steady_clock::now();
+
+    size_t seamPointCount = 0;
+    triangles = completeDelaunayTriangulation(points, finalTriangles, isSeam, threadCount, &seamPointCount);
+
+    if (statistics)
+    {
+        auto endTime = chrono::steady_clock::now();
+        *statistics = TriangulationStatistics();
+        statistics->pointCount = count;
+        statistics->triangleCount = triangles.size();
+        statistics->strips = 1;
+        statistics->seamPoints = seamPointCount;
+        statistics->stripSeconds = chrono::duration<double>(gridTime - startTime).count();
+        statistics->seamSeconds = chrono::duration<double>(endTime - gridTime).count();
+        statistics->seconds = chrono::duration<double>(endTime - startTime).count();
+    }
+    return true;
+}
@@ -0,0 +1,28 @@
+#ifndef GRIDDELAUNAY_H
+#define GRIDDELAUNAY_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "ParallelDelaunay.h"
+
+using namespace std;
+
+//Rask Delaunay triangulering av punkter som ligger i et regulært rutenett, f.eks etter reducePoints med
+//CellAggregation::CenterMeanZ eller Count (GridReducer::producesLattice). Punktene på rutenettet trianguleres
+//direkte med to trekanter per rute, i lineær tid. Diagonalen i hver rute velges med inCircleSymbolic, som i
+//DelaunayTriangulator, så resultatet blir det samme som den vanlige trianguleringen gir selv om alle fire hjørnene
+//ligger på samme sirkel.
+//
+//Punkter som ikke ligger på rutenettet, og ruter som mangler et hjørne (hull, kanten av punktskyen), er resten.
+//En rute er ferdig hvis den har alle fire hjørnene og ingen av de andre punktene i den omskrevne sirkelen.
+//Hjørnene som ikke bare har ferdige ruter rundt seg trianguleres sammen med resten av punktene i
+//completeDelaunayTriangulation (ParallelDelaunay.h).
+//
+//Returnerer false uten å triangulere hvis punktene ikke ser ut som et rutenett: avstanden mellom rutene finnes
+//fra punktene som ligger etter hverandre i points (reducePoints gir dem rad for rad), og for mange punkter utenfor
+//rutenettet eller for mange tomme ruter gjør at den vanlige trianguleringen brukes i stedet. stripSeconds i
+//statistics er tiden for rutenettet og seamSeconds tiden for resten. 0 tråder betyr workerCount().
+bool gridDelaunayTriangulation(const vector<glm::dvec2>& points, vector<glm::ivec3>& triangles,
+    unsigned int threadCount = 0, TriangulationStatistics* statistics = nullptr);
+
+#endif
@@ -0,0 +1,379 @@
+#include "GridReducer.h"
+#include "Parallel.h"
+#include "RadixSort.h"
+#include "GridCell.h"
+#include <cmath>
+#include <climits>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define GRIDREDUCER_SSE2
+#endif
+
+GridReducer::GridReducer(float cellSize, CellAggregation aggregation) : cellSize(cellSize), aggregation(aggregation), addedPoints(0) {}
+
+glm::ivec2 GridReducer::cellOf(float x, float y) const
+{
+    return gridCellOf(x, y, cellSize);
+}
+
+uint64_t GridReducer::cellKey(const glm::ivec2& cell)
+{
+    return packCellKey(cell);
+}
+
+glm::ivec2 GridReducer::cellFromKey(uint64_t key)
+{
+    return unpackCellKey(key);
+}
+
+struct RunSums
+{
+    double x, y, z;
+    float minZ, maxZ;
+};
+
+//Summerer x, y og z (i double) og finner laveste og høyeste z for punktene i en celle.
+//Med SSE2 behandles fire punkter om gangen, resten tas ett og ett.
+static RunSums sumRun(const float* x, const float* y, const float* z, size_t count)
+{
+    RunSums sums = { 0.0, 0.0, 0.0, z[0], z[0] };
+    size_t i = 0;
+
+#ifdef GRIDREDUCER_SSE2
+    if (count >= 4)
+    {
+        __m128d sumX = _mm_setzero_pd();
+        __m128d sumY = _mm_setzero_pd();
+        __m128d sumZ = _mm_setzero_pd();
+        __m128 minZ = _mm_set1_ps(z[0]);
+        __m128 maxZ = minZ;
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 vx = _mm_loadu_ps(x + i);
+            __m128 vy = _mm_loadu_ps(y + i);
+            __m128 vz = _mm_loadu_ps(z + i);
+            sumX = _mm_add_pd(sumX, _mm_add_pd(_mm_cvtps_pd(vx), _mm_cvtps_pd(_mm_movehl_ps(vx, vx))));
+            sumY = _mm_add_pd(sumY, _mm_add_pd(_mm_cvtps_pd(vy), _mm_cvtps_pd(_mm_movehl_ps(vy, vy))));
+            sumZ = _mm_add_pd(sumZ, _mm_add_pd(_mm_cvtps_pd(vz), _mm_cvtps_pd(_mm_movehl_ps(vz, vz))));
+            minZ = _mm_min_ps(minZ, vz);
+            maxZ = _mm_max_ps(maxZ, vz);
+        }
+
+        double lanes[2];
+        _mm_storeu_pd(lanes, sumX);
+        sums.x = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, sumY);
+        sums.y = lanes[0] + lanes[1];
+        _mm_storeu_pd(lanes, sumZ);
+        sums.z = lanes[0] + lanes[1];
+
+        float minLanes[4], maxLanes[4];
+        _mm_storeu_ps(minLanes, minZ);
+        _mm_storeu_ps(maxLanes, maxZ);
+        sums.minZ = min(min(minLanes[0], minLanes[1]), min(minLanes[2], minLanes[3]));
+        sums.maxZ = max(max(maxLanes[0], maxLanes[1]), max(maxLanes[2], maxLanes[3]));
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        sums.x += x[i];
+        sums.y += y[i];
+        sums.z += z[i];
+        sums.minZ = min(sums.minZ, z[i]);
+        sums.maxZ = max(sums.maxZ, z[i]);
+    }
+    return sums;
+}
+
+//Punktene ligger sortert i filrekkefølge, så det første punktet er cellens første punkt.
+//Det laveste og høyeste punktet er det første punktet som har minste og største z.
+GridReducer::Cell GridReducer::aggregateRun(uint64_t key, const float* sx, const float* sy, const float* sz, size_t count)
+{
+    RunSums sums = sumRun(sx, sy, sz, count);
+    size_t lowest = 0;
+    while (lowest + 1 < count && sz[lowest] != sums.minZ)
+    {
+        ++lowest;
+    }
+    size_t highest = 0;
+    while (highest + 1 < count && sz[highest] != sums.maxZ)
+    {
+        ++highest;
+    }
+
+    Cell cell;
+    cell.key = key;
+    cell.count = static_cast<uint32_t>(count);
+    cell.sum = glm::dvec3(sums.x, sums.y, sums.z);
+    cell.first = glm::vec3(sx[0], sy[0], sz[0]);
+    cell.lowest = glm::vec3(sx[lowest], sy[lowest], sz[lowest]);
+    cell.highest = glm::vec3(sx[highest], sy[highest], sz[highest]);
+    return cell;
+}
+
+//Finner cellene til punktene, sorterer dem på celle og slår sammen punktene i hver celle.
+//Nøklene som sorteres er relative til det minste rutenettet rundt punktene, slik at radix sorteringen
+//bare trenger så mange runder som bredden og høyden krever.
+void GridReducer::addPoints(const PointCloud& points)
+{
+    const float* x = points.x();
+    const float* y = points.y();
+    const float* z = points.z();
+    size_t count = points.size();
+    addedPoints += count;
+    if (count == 0)
+    {
+        return;
+    }
+
+    unsigned int threadCount = workerCount();
+
+    //Rutenettet rundt punktene i denne biten
+    vector<glm::ivec4> chunkRanges(threadCount, glm::ivec4(INT_MAX, INT_MAX, INT_MIN, INT_MIN));
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+    {
+        glm::ivec4 range = chunkRanges[chunk];
+        for (size_t i = begin; i < end; ++i)
+        {
+            glm::ivec2 cell = cellOf(x[i], y[i]);
+            range = glm::ivec4(glm::min(glm::ivec2(range.x, range.y), cell), glm::max(glm::ivec2(range.z, range.w), cell));
+        }
+        chunkRanges[chunk] = range;
+    });
+
+    glm::ivec2 minCell(INT_MAX), maxCell(INT_MIN);
+    for (const auto& range : chunkRanges)
+    {
+        minCell = glm::min(minCell, glm::ivec2(range.x, range.y));
+        maxCell = glm::max(maxCell, glm::ivec2(range.z, range.w));
+    }
+    uint64_t width = static_cast<uint64_t>(static_cast<int64_t>(maxCell.x) - minCell.x + 1);
+    uint64_t height = static_cast<uint64_t>(static_cast<int64_t>(maxCell.y) - minCell.y + 1);
+
+    vector<uint64_t> keys(count);
+    vector<uint32_t> indices(count);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            glm::ivec2 cell = cellOf(x[i], y[i]);
+            keys[i] = static_cast<uint64_t>(static_cast<int64_t>(cell.y) - minCell.y) * width
+                + static_cast<uint64_t>(static_cast<int64_t>(cell.x) - minCell.x);
+            indices[i] = static_cast<uint32_t>(i);
+        }
+    });
+
+    parallelRadixSort(keys, indices, bitWidth(width * height - 1), threadCount);
+
+    //Hver tråd teller hvor mange celler som starter i sin bit, så skrives startene rett på plass.
+    //Sorteringen er stabil, så punktene i hver celle ligger i samme rekkefølge som i filen.
+    vector<size_t> chunkCells(threadCount + 1, 0);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+    {
+        size_t starts = 0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            starts += (i == 0 || keys[i] != keys[i - 1]) ? 1 : 0;
+        }
+        chunkCells[chunk + 1] = starts;
+    });
+    for (unsigned int chunk = 0; chunk < threadCount; ++chunk)
+    {
+        chunkCells[chunk + 1] += chunkCells[chunk];
+    }
+
+    size_t newCellCount = chunkCells.back();
+    vector<size_t> runStarts(newCellCount + 1, count);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+    {
+        size_t target = chunkCells[chunk];
+        for (size_t i = begin; i < end; ++i)
+        {
+            if (i == 0 || keys[i] != keys[i - 1])
+            {
+                runStarts[target++] = i;
+            }
+        }
+    });
+
+    //Punktene kopieres i sortert rekkefølge, slik at hver celle ligger samlet og kan summeres med SIMD
+    vector<float> sortedX(count), sortedY(count), sortedZ(count);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t index = indices[i];
+            sortedX[i] = x[index];
+            sortedY[i] = y[index];
+            sortedZ[i] = z[index];
+        }
+    });
+
+    auto absoluteKey = [&](uint64_t key)
+    {
+        return cellKey(glm::ivec2(minCell.x + static_cast<int>(key % width), minCell.y + static_cast<int>(key / width)));
+    };
+
+    vector<Cell> newCells(newCellCount);
+    parallelFor(newCellCount, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t c = begin; c < end; ++c)
+        {
+            size_t first = runStarts[c];
+            size_t runLength = runStarts[c + 1] - first;
+            newCells[c] = aggregateRun(absoluteKey(keys[first]), &sortedX[first], &sortedY[first], &sortedZ[first], runLength);
+        }
+    });
+
+    //Medianen krever alle punktene, så de tas vare på sortert på celle
+    if (aggregation == CellAggregation::MedianZ)
+    {
+        vector<Sample> newSamples(count);
+        parallelFor(newCellCount, threadCount, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t c = begin; c < end; ++c)
+            {
+                for (size_t i = runStarts[c]; i < runStarts[c + 1]; ++i)
+                {
+                    newSamples[i] = { newCells[c].key, glm::vec3(sortedX[i], sortedY[i], sortedZ[i]) };
+                }
+            }
+        });
+
+        vector<Sample> merged(samples.size() + newSamples.size());
+        merge(samples.begin(), samples.end(), newSamples.begin(), newSamples.end(), merged.begin(),
+            [](const Sample& a, const Sample& b) { return a.key < b.key; });
+        samples.swap(merged);
+    }
+
+    mergeCells(newCells);
+}
+
+//Celler som finnes i begge slås sammen. Det gamle punktet er først i filen, så det beholdes som first,
+//og ved lik z beholdes også det gamle laveste og høyeste punktet.
+void GridReducer::mergeCells(vector<Cell>& newCells)
+{
+    if (cells.empty())
+    {
+        cells.swap(newCells);
+        return;
+    }
+
+    vector<Cell> merged;
+    merged.reserve(cells.size() + newCells.size());
+    size_t a = 0, b = 0;
+    while (a < cells.size() && b < newCells.size())
+    {
+        if (cells[a].key < newCells[b].key)
+        {
+            merged.push_back(cells[a++]);
+        }
+        else if (newCells[b].key < cells[a].key)
+        {
+            merged.push_back(newCells[b++]);
+        }
+        else
+        {
+            Cell cell = cells[a++];
+            const Cell& added = newCells[b++];
+            cell.count += added.count;
+            cell.sum += added.sum;
+            if (added.lowest.z < cell.lowest.z)
+            {
+                cell.lowest = added.lowest;
+            }
+            if (added.highest.z > cell.highest.z)
+            {
+                cell.highest = added.highest;
+            }
+            merged.push_back(cell);
+        }
+    }
+    merged.insert(merged.end(), cells.begin() + a, cells.end());
+    merged.insert(merged.end(), newCells.begin() + b, newCells.end());
+    cells.swap(merged);
+}
+
+vector<glm::vec3> GridReducer::reducedPoints() const
+{
+    vector<glm::vec3> reduced(cells.size());
+
+    if (aggregation == CellAggregation::MedianZ)
+    {
+        //Punktene til celle c ligger fra sampleStarts[c] i samples
+        vector<size_t> sampleStarts(cells.size() + 1, 0);
+        for (size_t c = 0; c < cells.size(); ++c)
+        {
+            sampleStarts[c + 1] = sampleStarts[c] + cells[c].count;
+        }
+
+        parallelFor(cells.size(), [&](size_t begin, size_t end, unsigned int)
+        {
+            vector<glm::vec3> cellPoints;
+            for (size_t c = begin; c < end; ++c)
+            {
+                cellPoints.clear();
+                for (size_t i = sampleStarts[c]; i < sampleStarts[c + 1]; ++i)
+                {
+                    cellPoints.push_back(samples[i].point);
+                }
+                auto median = cellPoints.begin() + (cellPoints.size() - 1) / 2;
+                nth_element(cellPoints.begin(), median, cellPoints.end(),
+                    [](const glm::vec3& a, const glm::vec3& b) { return a.z < b.z; });
+                reduced[c] = *median;
+            }
+        });
+        return reduced;
+    }
+
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        const Cell& cell = cells[i];
+        switch (aggregation)
+        {
+        case CellAggregation::Centroid:
+            reduced[i] = glm::vec3(cell.sum / static_cast<double>(cell.count));
+            break;
+        case CellAggregation::LowestZ:
+            reduced[i] = cell.lowest;
+            break;
+        case CellAggregation::HighestZ:
+            reduced[i] = cell.highest;
+            break;
+        case CellAggregation::Count:
+        {
+            glm::vec2 center = (glm::vec2(cellFromKey(cell.key)) + 0.5f) * cellSize;
+            reduced[i] = glm::vec3(center, static_cast<float>(cell.count));
+            break;
+        }
+        case CellAggregation::CenterMeanZ:
+        {
+            glm::vec2 center = (glm::vec2(cellFromKey(cell.key)) + 0.5f) * cellSize;
+            reduced[i] = glm::vec3(center, static_cast<float>(cell.sum.z / static_cast<double>(cell.count)));
+            break;
+        }
+        default:
+            reduced[i] = cell.first;
+            break;
+        }
+    }
+    return reduced;
+}
+
+bool GridReducer::producesLattice(CellAggregation aggregation)
+{
+    return aggregation == CellAggregation::Count || aggregation == CellAggregation::CenterMeanZ;
+}
+
+vector<uint32_t> GridReducer::pointCounts() const
+{
+    vector<uint32_t> counts(cells.size());
+    for (size_t i = 0; i < cells.size(); ++i)
+    {
+        counts[i] = cells[i].count;
+    }
+    return counts;
+}
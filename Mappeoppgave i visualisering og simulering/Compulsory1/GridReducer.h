@@ -0,0 +1,89 @@
+#ifndef GRIDREDUCER_H
+#define GRIDREDUCER_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "PointCloud.h"
+
+using namespace std;
+
+//Hvilket punkt som blir igjen i hver celle når punktskyen reduseres
+enum class CellAggregation
+{
+    First,      //Det første punktet i filen som havnet i cellen
+    Centroid,   //Gjennomsnittet av alle punktene i cellen
+    LowestZ,    //Punktet med lavest z (bakken, til terrengmodell/DTM)
+    HighestZ,   //Punktet med høyest z (tretopper og tak, til overflatemodell/DSM)
+    MedianZ,    //Punktet med median z, tåler enkeltpunkter som ligger langt over eller under
+    Count,      //Midten av cellen med antall punkter i cellen som z
+    CenterMeanZ //Midten av cellen med gjennomsnittet av z, et regulært rutenett som kan brukes som terreng
+};
+
+//Reduserer punktskyen ved å legge punktene i et rutenett i xy-planet og beholde ett punkt per celle.
+//Punktene kan legges til i flere omganger (biter), slik at hele punktskyen aldri trenger å ligge i minnet.
+//Minnebruken avhenger dermed bare av hvor mange celler som har punkter, ikke av hvor stor filen er.
+//Unntaket er MedianZ, som må ta vare på alle punktene til medianen regnes ut i reducedPoints.
+//
+//Hvert punkt får en 64 bits nøkkel laget av cellen det ligger i. Nøklene sorteres parallelt med radix
+//sortering, og punktene i hver rekke av like nøkler slås sammen til én celle. For hver celle lagres
+//antall, summen, første, laveste og høyeste punkt, så alle modusene regnes ut i samme gjennomgang.
+//Cellene lagres sortert på nøkkel (rad for rad i y, deretter x), så resultatet er det samme uansett antall tråder.
+class GridReducer
+{
+public:
+    GridReducer(float cellSize, CellAggregation aggregation = CellAggregation::First);
+
+    //Legger punktene i rutenettet
+    void addPoints(const PointCloud& points);
+
+    //Ett punkt for hver celle som har fått punkter, valgt med aggregation og sortert rad for rad
+    vector<glm::vec3> reducedPoints() const;
+    //Antall punkter i hver celle, i samme rekkefølge som reducedPoints
+    vector<uint32_t> pointCounts() const;
+
+    size_t cellCount() const { return cells.size(); }
+    size_t pointsAdded() const { return addedPoints; }
+    float getCellSize() const { return cellSize; }
+    CellAggregation getAggregation() const { return aggregation; }
+
+    //true for modusene som legger punktet midt i cellen (Count og CenterMeanZ). Bare da ligger de reduserte
+    //punktene i et regulært rutenett, så gridDelaunayTriangulation (GridDelaunay.h) kan brukes.
+    static bool producesLattice(CellAggregation aggregation);
+
+    //Cellen punktet ligger i og nøkkelen til cellen, med gridCellOf og packCellKey (GridCell.h)
+    glm::ivec2 cellOf(float x, float y) const;
+    static uint64_t cellKey(const glm::ivec2& cell);
+    static glm::ivec2 cellFromKey(uint64_t key);
+
+private:
+    struct Cell
+    {
+        uint64_t key;
+        uint32_t count;
+        glm::dvec3 sum;
+        glm::vec3 first;
+        glm::vec3 lowest;
+        glm::vec3 highest;
+    };
+
+    //Et punkt med nøkkelen til cellen sin, brukes bare av MedianZ
+    struct Sample
+    {
+        uint64_t key;
+        glm::vec3 point;
+    };
+
+    //Slår sammen punktene i sx, sy, sz (som alle ligger i samme celle) til én celle
+    static Cell aggregateRun(uint64_t key, const float* sx, const float* sy, const float* sz, size_t count);
+    //Fletter de nye cellene (sortert) inn i cells. Celler som finnes fra før slås sammen.
+    void mergeCells(vector<Cell>& newCells);
+
+    float cellSize;
+    CellAggregation aggregation;
+    size_t addedPoints;
+    vector<Cell> cells;
+    vector<Sample> samples;
+};
+
+#endif
@@ -0,0 +1,386 @@
+#include "InCircleBatch.h"
+#include "Predicates.h"
+#include <atomic>
+
+#if defined(_M_X64) || defined(_M_IX86) || defined(__x86_64__) || defined(__i386__)
+#define INCIRCLE_X86
+#include <immintrin.h>
+#ifdef _MSC_VER
+#include <intrin.h>
+#define SSE2_FUNCTION
+#define AVX2_FUNCTION
+#else
+#include <cpuid.h>
+//GCC og Clang lager bare AVX2 kode i funksjoner som er merket for det. Ikke "fma": da kan kompilatoren slå sammen
+//gange og pluss, og feilgrensen under gjelder for vanlige operasjoner.
+#define SSE2_FUNCTION __attribute__((target("sse2")))
+#define AVX2_FUNCTION __attribute__((target("avx2")))
+#endif
+#endif
+
+//Samme feilgrense som den raske veien i inCircle (Predicates.cpp). Er determinanten større enn grensen ganger
+//permanenten har den riktig fortegn. Filen må, som Predicates.cpp, ikke kompileres med /fp:fast.
+static const double epsilon = 1.1102230246251565e-16;
+static const double inCircleErrorBound = (10.0 + 96.0 * epsilon) * epsilon;
+
+void TriangleSoA::clear()
+{
+    resize(0);
+}
+
+void TriangleSoA::resize(size_t count)
+{
+    ax.resize(count);
+    ay.resize(count);
+    bx.resize(count);
+    by.resize(count);
+    cx.resize(count);
+    cy.resize(count);
+}
+
+void TriangleSoA::set(size_t i, const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+{
+    ax[i] = a.x;
+    ay[i] = a.y;
+    bx[i] = b.x;
+    by[i] = b.y;
+    cx[i] = c.x;
+    cy[i] = c.y;
+}
+
+void TriangleSoA::push_back(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+{
+    resize(size() + 1);
+    set(size() - 1, a, b, c);
+}
+
+//Pekere til hjørnene for trekantene som testes, så TriangleSoA og inCircleGather kan bruke de samme kjernene
+struct CornerPointers
+{
+    const double* ax;
+    const double* ay;
+    const double* bx;
+    const double* by;
+    const double* cx;
+    const double* cy;
+};
+
+static int bitCount(uint64_t bits)
+{
+    int count = 0;
+    for (; bits != 0; bits &= bits - 1)
+    {
+        ++count;
+    }
+    return count;
+}
+
+#ifdef INCIRCLE_X86
+
+static void cpuid(int leaf, int subleaf, unsigned int registers[4])
+{
+#ifdef _MSC_VER
+    int values[4];
+    __cpuidex(values, leaf, subleaf);
+    for (int i = 0; i < 4; ++i)
+    {
+        registers[i] = static_cast<unsigned int>(values[i]);
+    }
+#else
+    __cpuid_count(leaf, subleaf, registers[0], registers[1], registers[2], registers[3]);
+#endif
+}
+
+//Registrene operativsystemet tar vare på ved trådbytte (bit 1 SSE, bit 2 AVX)
+static uint64_t enabledRegisters()
+{
+#ifdef _MSC_VER
+    return _xgetbv(0);
+#else
+    unsigned int low, high;
+    __asm__ volatile("xgetbv" : "=a"(low), "=d"(high) : "c"(0));
+    return (static_cast<uint64_t>(high) << 32) | low;
+#endif
+}
+
+static SimdLevel detectSimdLevel()
+{
+    unsigned int registers[4];
+    cpuid(0, 0, registers);
+    unsigned int maxLeaf = registers[0];
+    cpuid(1, 0, registers);
+    bool sse2 = (registers[3] & (1u << 26)) != 0;
+    bool osxsave = (registers[2] & (1u << 27)) != 0;
+    bool avx = (registers[2] & (1u << 28)) != 0;
+    if (avx && osxsave && maxLeaf >= 7 && (enabledRegisters() & 6) == 6)
+    {
+        cpuid(7, 0, registers);
+        if ((registers[1] & (1u << 5)) != 0)
+        {
+            return SimdLevel::AVX2;
+        }
+    }
+    return sse2 ? SimdLevel::SSE2 : SimdLevel::Scalar;
+}
+
+//Determinanten og permanenten fra inCircle for to trekanter. Bit 0 og 1 i inside er trekantene der punktet
+//sikkert ligger i sirkelen, og i uncertain trekantene der feilgrensen ikke holder.
+SSE2_FUNCTION static void inCircleBlockSse2(const CornerPointers& t, size_t i, __m128d dx, __m128d dy,
+    uint32_t& inside, uint32_t& uncertain)
+{
+    const __m128d signMask = _mm_set1_pd(-0.0);
+    __m128d adx = _mm_sub_pd(_mm_loadu_pd(t.ax + i), dx), ady = _mm_sub_pd(_mm_loadu_pd(t.ay + i), dy);
+    __m128d bdx = _mm_sub_pd(_mm_loadu_pd(t.bx + i), dx), bdy = _mm_sub_pd(_mm_loadu_pd(t.by + i), dy);
+    __m128d cdx = _mm_sub_pd(_mm_loadu_pd(t.cx + i), dx), cdy = _mm_sub_pd(_mm_loadu_pd(t.cy + i), dy);
+
+    __m128d bdxcdy = _mm_mul_pd(bdx, cdy), cdxbdy = _mm_mul_pd(cdx, bdy);
+    __m128d cdxady = _mm_mul_pd(cdx, ady), adxcdy = _mm_mul_pd(adx, cdy);
+    __m128d adxbdy = _mm_mul_pd(adx, bdy), bdxady = _mm_mul_pd(bdx, ady);
+    __m128d aLift = _mm_add_pd(_mm_mul_pd(adx, adx), _mm_mul_pd(ady, ady));
+    __m128d bLift = _mm_add_pd(_mm_mul_pd(bdx, bdx), _mm_mul_pd(bdy, bdy));
+    __m128d cLift = _mm_add_pd(_mm_mul_pd(cdx, cdx), _mm_mul_pd(cdy, cdy));
+
+    __m128d determinant = _mm_add_pd(_mm_add_pd(
+        _mm_mul_pd(aLift, _mm_sub_pd(bdxcdy, cdxbdy)),
+        _mm_mul_pd(bLift, _mm_sub_pd(cdxady, adxcdy))),
+        _mm_mul_pd(cLift, _mm_sub_pd(adxbdy, bdxady)));
+    __m128d permanent = _mm_add_pd(_mm_add_pd(
+        _mm_mul_pd(_mm_add_pd(_mm_andnot_pd(signMask, bdxcdy), _mm_andnot_pd(signMask, cdxbdy)), aLift),
+        _mm_mul_pd(_mm_add_pd(_mm_andnot_pd(signMask, cdxady), _mm_andnot_pd(signMask, adxcdy)), bLift)),
+        _mm_mul_pd(_mm_add_pd(_mm_andnot_pd(signMask, adxbdy), _mm_andnot_pd(signMask, bdxady)), cLift));
+    __m128d bound = _mm_mul_pd(_mm_set1_pd(inCircleErrorBound), permanent);
+
+    //NaN gir false i begge sammenligningene og blir usikker
+    int certain = _mm_movemask_pd(_mm_cmpgt_pd(_mm_andnot_pd(signMask, determinant), bound));
+    int positive = _mm_movemask_pd(_mm_cmpgt_pd(determinant, bound));
+    inside = static_cast<uint32_t>(positive & certain);
+    uncertain = static_cast<uint32_t>(~certain & 3);
+}
+
+SSE2_FUNCTION static uint64_t inCircleSse2(const CornerPointers& t, size_t count, const glm::dvec2& point,
+    uint64_t& uncertain, size_t& processed)
+{
+    __m128d dx = _mm_set1_pd(point.x), dy = _mm_set1_pd(point.y);
+    uint64_t inside = 0;
+    uncertain = 0;
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t inside0, uncertain0, inside1, uncertain1;
+        inCircleBlockSse2(t, i, dx, dy, inside0, uncertain0);
+        inCircleBlockSse2(t, i + 2, dx, dy, inside1, uncertain1);
+        inside |= static_cast<uint64_t>(inside0 | (inside1 << 2)) << i;
+        uncertain |= static_cast<uint64_t>(uncertain0 | (uncertain1 << 2)) << i;
+    }
+    for (; i + 2 <= count; i += 2)
+    {
+        uint32_t inside0, uncertain0;
+        inCircleBlockSse2(t, i, dx, dy, inside0, uncertain0);
+        inside |= static_cast<uint64_t>(inside0) << i;
+        uncertain |= static_cast<uint64_t>(uncertain0) << i;
+    }
+    processed = i;
+    return inside;
+}
+
+//Som inCircleBlockSse2, for fire trekanter
+AVX2_FUNCTION static void inCircleBlockAvx2(const CornerPointers& t, size_t i, __m256d dx, __m256d dy,
+    uint32_t& inside, uint32_t& uncertain)
+{
+    const __m256d signMask = _mm256_set1_pd(-0.0);
+    __m256d adx = _mm256_sub_pd(_mm256_loadu_pd(t.ax + i), dx), ady = _mm256_sub_pd(_mm256_loadu_pd(t.ay + i), dy);
+    __m256d bdx = _mm256_sub_pd(_mm256_loadu_pd(t.bx + i), dx), bdy = _mm256_sub_pd(_mm256_loadu_pd(t.by + i), dy);
+    __m256d cdx = _mm256_sub_pd(_mm256_loadu_pd(t.cx + i), dx), cdy = _mm256_sub_pd(_mm256_loadu_pd(t.cy + i), dy);
+
+    __m256d bdxcdy = _mm256_mul_pd(bdx, cdy), cdxbdy = _mm256_mul_pd(cdx, bdy);
+    __m256d cdxady = _mm256_mul_pd(cdx, ady), adxcdy = _mm256_mul_pd(adx, cdy);
+    __m256d adxbdy = _mm256_mul_pd(adx, bdy), bdxady = _mm256_mul_pd(bdx, ady);
+    __m256d aLift = _mm256_add_pd(_mm256_mul_pd(adx, adx), _mm256_mul_pd(ady, ady));
+    __m256d bLift = _mm256_add_pd(_mm256_mul_pd(bdx, bdx), _mm256_mul_pd(bdy, bdy));
+    __m256d cLift = _mm256_add_pd(_mm256_mul_pd(cdx, cdx), _mm256_mul_pd(cdy, cdy));
+
+    __m256d determinant = _mm256_add_pd(_mm256_add_pd(
+        _mm256_mul_pd(aLift, _mm256_sub_pd(bdxcdy, cdxbdy)),
+        _mm256_mul_pd(bLift, _mm256_sub_pd(cdxady, adxcdy))),
+        _mm256_mul_pd(cLift, _mm256_sub_pd(adxbdy, bdxady)));
+    __m256d permanent = _mm256_add_pd(_mm256_add_pd(
+        _mm256_mul_pd(_mm256_add_pd(_mm256_andnot_pd(signMask, bdxcdy), _mm256_andnot_pd(signMask, cdxbdy)), aLift),
+        _mm256_mul_pd(_mm256_add_pd(_mm256_andnot_pd(signMask, cdxady), _mm256_andnot_pd(signMask, adxcdy)), bLift)),
+        _mm256_mul_pd(_mm256_add_pd(_mm256_andnot_pd(signMask, adxbdy), _mm256_andnot_pd(signMask, bdxady)), cLift));
+    __m256d bound = _mm256_mul_pd(_mm256_set1_pd(inCircleErrorBound), permanent);
+
+    int certain = _mm256_movemask_pd(_mm256_cmp_pd(_mm256_andnot_pd(signMask, determinant), bound, _CMP_GT_OQ));
+    int positive = _mm256_movemask_pd(_mm256_cmp_pd(determinant, bound, _CMP_GT_OQ));
+    inside = static_cast<uint32_t>(positive & certain);
+    uncertain = static_cast<uint32_t>(~certain & 15);
+}
+
+AVX2_FUNCTION static uint64_t inCircleAvx2(const CornerPointers& t, size_t count, const glm::dvec2& point,
+    uint64_t& uncertain, size_t& processed)
+{
+    __m256d dx = _mm256_set1_pd(point.x), dy = _mm256_set1_pd(point.y);
+    uint64_t inside = 0;
+    uncertain = 0;
+    size_t i = 0;
+    //To blokker per runde, så de to utregningene kan gå samtidig i prosessoren
+    for (; i + 8 <= count; i += 8)
+    {
+        uint32_t inside0, uncertain0, inside1, uncertain1;
+        inCircleBlockAvx2(t, i, dx, dy, inside0, uncertain0);
+        inCircleBlockAvx2(t, i + 4, dx, dy, inside1, uncertain1);
+        inside |= static_cast<uint64_t>(inside0 | (inside1 << 4)) << i;
+        uncertain |= static_cast<uint64_t>(uncertain0 | (uncertain1 << 4)) << i;
+    }
+    for (; i + 4 <= count; i += 4)
+    {
+        uint32_t inside0, uncertain0;
+        inCircleBlockAvx2(t, i, dx, dy, inside0, uncertain0);
+        inside |= static_cast<uint64_t>(inside0) << i;
+        uncertain |= static_cast<uint64_t>(uncertain0) << i;
+    }
+    processed = i;
+    return inside;
+}
+
+//Hjørnene til opptil fire trekanter hentes rett inn i registrene. Ledige plasser fylles med den første trekanten.
+AVX2_FUNCTION static uint32_t inCircleGatherAvx2(const vector<glm::dvec2>& vertices, const glm::ivec3* triangles,
+    int count, const glm::dvec2& point)
+{
+    const glm::dvec2* corners[4][3];
+    for (int i = 0; i < 4; ++i)
+    {
+        const glm::ivec3& v = triangles[i < count ? i : 0];
+        corners[i][0] = &vertices[v.x];
+        corners[i][1] = &vertices[v.y];
+        corners[i][2] = &vertices[v.z];
+    }
+    //_mm256_set_pd tar den siste plassen først
+    alignas(32) double coordinates[6][4];
+    for (int k = 0; k < 3; ++k)
+    {
+        _mm256_store_pd(coordinates[2 * k], _mm256_set_pd(corners[3][k]->x, corners[2][k]->x, corners[1][k]->x, corners[0][k]->x));
+        _mm256_store_pd(coordinates[2 * k + 1], _mm256_set_pd(corners[3][k]->y, corners[2][k]->y, corners[1][k]->y, corners[0][k]->y));
+    }
+    CornerPointers t = { coordinates[0], coordinates[1], coordinates[2], coordinates[3], coordinates[4], coordinates[5] };
+    uint32_t inside, uncertain;
+    inCircleBlockAvx2(t, 0, _mm256_set1_pd(point.x), _mm256_set1_pd(point.y), inside, uncertain);
+
+    uint32_t used = (1u << count) - 1;
+    inside &= used;
+    uncertain &= used;
+    countInCircleCalls(count - bitCount(uncertain));
+    for (int i = 0; uncertain != 0; ++i, uncertain >>= 1)
+    {
+        if ((uncertain & 1) != 0 && inCircleSymbolic(*corners[i][0], *corners[i][1], *corners[i][2], point) > 0)
+        {
+            inside |= 1u << i;
+        }
+    }
+    return inside;
+}
+
+#else
+
+static SimdLevel detectSimdLevel()
+{
+    return SimdLevel::Scalar;
+}
+
+#endif
+
+static SimdLevel supported = detectSimdLevel();
+static atomic<SimdLevel> selected(supported);
+
+SimdLevel supportedSimdLevel()
+{
+    return supported;
+}
+
+SimdLevel inCircleBatchLevel()
+{
+    return selected.load(memory_order_relaxed);
+}
+
+void setInCircleBatchLevel(SimdLevel level)
+{
+    selected.store(static_cast<int>(level) > static_cast<int>(supported) ? supported : level);
+}
+
+const char* simdLevelName(SimdLevel level)
+{
+    switch (level)
+    {
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::SSE2: return "SSE2";
+    default: return "skalar";
+    }
+}
+
+static uint64_t inCircleCorners(const CornerPointers& t, size_t count, const glm::dvec2& point)
+{
+    uint64_t inside = 0;
+    uint64_t uncertain = 0;
+    size_t processed = 0;
+#ifdef INCIRCLE_X86
+    SimdLevel level = inCircleBatchLevel();
+    if (level == SimdLevel::AVX2)
+    {
+        inside = inCircleAvx2(t, count, point, uncertain, processed);
+    }
+    else if (level == SimdLevel::SSE2)
+    {
+        inside = inCircleSse2(t, count, point, uncertain, processed);
+    }
+#endif
+    if (processed > 0)
+    {
+        countInCircleCalls(processed - bitCount(uncertain));
+    }
+
+    //Trekantene etter den siste hele blokken, og de der feilgrensen ikke holdt, testes en og en
+    for (size_t i = processed; i < count; ++i)
+    {
+        uncertain |= uint64_t(1) << i;
+    }
+    for (size_t i = 0; uncertain != 0; ++i, uncertain >>= 1)
+    {
+        if ((uncertain & 1) != 0 &&
+            inCircleSymbolic(glm::dvec2(t.ax[i], t.ay[i]), glm::dvec2(t.bx[i], t.by[i]), glm::dvec2(t.cx[i], t.cy[i]), point) > 0)
+        {
+            inside |= uint64_t(1) << i;
+        }
+    }
+    return inside;
+}
+
+uint64_t inCircleBatch(const TriangleSoA& triangles, size_t first, size_t count, const glm::dvec2& point)
+{
+    CornerPointers t = { triangles.ax.data() + first, triangles.ay.data() + first, triangles.bx.data() + first,
+        triangles.by.data() + first, triangles.cx.data() + first, triangles.cy.data() + first };
+    return inCircleCorners(t, count, point);
+}
+
+uint32_t inCircleGather(const vector<glm::dvec2>& vertices, const glm::ivec3* triangles, int count,
+    const glm::dvec2& point)
+{
+    if (count == 0)
+    {
+        return 0;
+    }
+#ifdef INCIRCLE_X86
+    if (inCircleBatchLevel() == SimdLevel::AVX2)
+    {
+        return inCircleGatherAvx2(vertices, triangles, count, point);
+    }
+#endif
+    uint32_t inside = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        const glm::ivec3& v = triangles[i];
+        if (inCircleSymbolic(vertices[v.x], vertices[v.y], vertices[v.z], point) > 0)
+        {
+            inside |= 1u << i;
+        }
+    }
+    return inside;
+}
@@ -0,0 +1,55 @@
+#ifndef INCIRCLEBATCH_H
+#define INCIRCLEBATCH_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+//Hjørnene til en samling trekanter lagret som struktur av tabeller (SoA): trekant i har hjørnene (ax[i], ay[i]),
+//(bx[i], by[i]) og (cx[i], cy[i]) mot klokka. Da ligger samme koordinat for flere trekanter etter hverandre i
+//minnet, så fire trekanter kan lastes med én SIMD instruksjon.
+struct TriangleSoA
+{
+    vector<double> ax, ay, bx, by, cx, cy;
+
+    size_t size() const { return ax.size(); }
+    void clear();
+    void resize(size_t count);
+    void set(size_t i, const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c);
+    void push_back(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c);
+};
+
+enum class SimdLevel
+{
+    Scalar,
+    SSE2,
+    AVX2
+};
+
+//Den beste instruksjonen maskinen støtter (finnes med cpuid første gang)
+SimdLevel supportedSimdLevel();
+//Instruksjonene inCircleBatch bruker. Er som standard supportedSimdLevel(). Kan settes lavere for å sammenligne,
+//et nivå maskinen ikke støtter blir supportedSimdLevel().
+SimdLevel inCircleBatchLevel();
+void setInCircleBatchLevel(SimdLevel level);
+const char* simdLevelName(SimdLevel level);
+
+//Tester om point ligger i den omskrevne sirkelen til trekantene first til first + count (count <= 64).
+//Bit i i svaret er satt hvis point ligger i sirkelen til trekant first + i, med samme svar som
+//inCircleSymbolic(a, b, c, point) > 0 i Predicates.h.
+//
+//Determinanten og feilgrensen fra inCircle regnes ut for fire (AVX2) eller to (SSE2) trekanter om gangen, og to
+//slike blokker per runde. Bare trekantene der determinanten er mindre enn feilgrensen, og trekantene som ikke
+//fyller en hel blokk, testes med inCircleSymbolic. Trådsikker.
+uint64_t inCircleBatch(const TriangleSoA& triangles, size_t first, size_t count, const glm::dvec2& point);
+
+//Tester point mot count (<= 4) trekanter gitt med indekser inn i vertices, uten en egen TriangleSoA, f.eks
+//naboene til en trekant. Hjørnene må hentes fra spredte steder i minnet, så dette lønner seg mye mindre enn
+//inCircleBatch (se TriangulationBenchmark --incircle). Hulromsøket i DelaunayTriangulator bruker derfor
+//fortsatt inCircleSymbolic for hver nabo, der det målte raskere.
+uint32_t inCircleGather(const vector<glm::dvec2>& vertices, const glm::ivec3* triangles, int count,
+    const glm::dvec2& point);
+
+#endif
@@ -0,0 +1,416 @@
+#include "KdTree.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <limits>
+
+static bool neighbourLess(const KdNeighbour& a, const KdNeighbour& b)
+{
+    return a.distanceSquared < b.distanceSquared;
+}
+
+//Kjører search(i, found, part) for hvert søk og samler svarene i offsets og indices. Hver tråd samler i sin egen
+//tabell, og tabellene kopieres etter hverandre til slutt, så svaret ligger i samme rekkefølge som søkene.
+template <class Search>
+static void gatherBatch(size_t queryCount, unsigned int threadCount, vector<uint32_t>& offsets,
+    vector<uint32_t>& indices, Search search)
+{
+    offsets.assign(queryCount + 1, 0);
+    vector<vector<uint32_t>> partIndices(threadCount);
+    parallelFor(queryCount, threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        vector<uint32_t>& found = partIndices[part];
+        for (size_t i = begin; i < end; ++i)
+        {
+            size_t before = found.size();
+            search(i, found, part);
+            offsets[i + 1] = static_cast<uint32_t>(found.size() - before);
+        }
+    });
+
+    for (size_t i = 0; i < queryCount; ++i)
+    {
+        offsets[i + 1] += offsets[i];
+    }
+    indices.clear();
+    indices.reserve(offsets[queryCount]);
+    for (const auto& found : partIndices)
+    {
+        indices.insert(indices.end(), found.begin(), found.end());
+    }
+}
+
+const uint32_t KdTree::invalidIndex;
+const size_t KdTree::leafSize;
+
+KdTree::KdTree() : dimensions(3) {}
+
+KdTree::KdTree(const vector<glm::vec3>& points, int dimensions, unsigned int threadCount) : dimensions(3)
+{
+    build(points, dimensions, threadCount);
+}
+
+void KdTree::clear()
+{
+    entries.clear();
+    splitAxes.clear();
+    positions.clear();
+}
+
+void KdTree::build(const vector<glm::vec3>& points, int dimensions, unsigned int threadCount)
+{
+    this->dimensions = dimensions == 2 ? 2 : 3;
+    threadCount = threadCount == 0 ? workerCount() : threadCount;
+    clear();
+    if (points.empty())
+    {
+        return;
+    }
+
+    size_t count = points.size();
+    entries.resize(count);
+    splitAxes.assign(count, 0);
+    positions.resize(count);
+
+    //Kopierer punktene og finner boksen rundt dem, med én boks per tråd som slås sammen etterpå
+    vector<glm::vec3> partMin(threadCount, points[0]);
+    vector<glm::vec3> partMax(threadCount, points[0]);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            entries[i].position = points[i];
+            entries[i].index = static_cast<uint32_t>(i);
+            partMin[part] = glm::min(partMin[part], points[i]);
+            partMax[part] = glm::max(partMax[part], points[i]);
+        }
+    });
+    PendingNode root = { 0, count, partMin[0], partMax[0] };
+    for (unsigned int part = 1; part < threadCount; ++part)
+    {
+        root.cellMin = glm::min(root.cellMin, partMin[part]);
+        root.cellMax = glm::max(root.cellMax, partMax[part]);
+    }
+
+    //De øverste nivåene deles ett nivå om gangen, med nodene på nivået fordelt på trådene. Når det er minst
+    //fire deltrær per tråd, bygges hvert deltre ferdig av én tråd.
+    vector<PendingNode> pending(1, root);
+    while (threadCount > 1 && !pending.empty() && pending.size() < 4 * static_cast<size_t>(threadCount))
+    {
+        vector<PendingNode> children(2 * pending.size());
+        vector<int> childCounts(pending.size());
+        parallelForEach(pending.size(), threadCount, [&](size_t i)
+        {
+            childCounts[i] = splitNode(pending[i], &children[2 * i]);
+        });
+
+        vector<PendingNode> next;
+        for (size_t i = 0; i < pending.size(); ++i)
+        {
+            next.insert(next.end(), children.begin() + 2 * i, children.begin() + 2 * i + childCounts[i]);
+        }
+        pending.swap(next);
+    }
+    parallelForEach(pending.size(), threadCount, [&](size_t i)
+    {
+        buildSubtree(pending[i]);
+    });
+
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            positions[entries[i].index] = static_cast<uint32_t>(i);
+        }
+    });
+}
+
+//Midten av intervallet blir noden. nth_element legger punktene med mindre koordinat langs aksen før midten og
+//punktene med større etter, og cellen til hvert deltre er cellen til noden kuttet ved koordinaten til midten.
+int KdTree::splitNode(const PendingNode& node, PendingNode* children)
+{
+    if (node.end - node.begin <= leafSize)
+    {
+        return 0;
+    }
+
+    glm::vec3 extent = node.cellMax - node.cellMin;
+    int axis = extent.y > extent.x ? 1 : 0;
+    if (dimensions == 3 && extent.z > extent[axis])
+    {
+        axis = 2;
+    }
+
+    size_t mid = node.begin + (node.end - node.begin) / 2;
+    nth_element(entries.begin() + node.begin, entries.begin() + mid, entries.begin() + node.end,
+        [axis](const Entry& a, const Entry& b) { return a.position[axis] < b.position[axis]; });
+    splitAxes[mid] = static_cast<uint8_t>(axis);
+    float split = entries[mid].position[axis];
+
+    int childCount = 0;
+    if (mid - node.begin > 0)
+    {
+        children[childCount] = { node.begin, mid, node.cellMin, node.cellMax };
+        children[childCount].cellMax[axis] = split;
+        ++childCount;
+    }
+    if (node.end - (mid + 1) > 0)
+    {
+        children[childCount] = { mid + 1, node.end, node.cellMin, node.cellMax };
+        children[childCount].cellMin[axis] = split;
+        ++childCount;
+    }
+    return childCount;
+}
+
+void KdTree::buildSubtree(PendingNode node)
+{
+    PendingNode children[2];
+    int childCount = splitNode(node, children);
+    for (int i = 0; i < childCount; ++i)
+    {
+        buildSubtree(children[i]);
+    }
+}
+
+float KdTree::distanceSquared(const glm::vec3& a, const glm::vec3& b) const
+{
+    glm::vec3 d = a - b;
+    float result = d.x * d.x + d.y * d.y;
+    return dimensions == 3 ? result + d.z * d.z : result;
+}
+
+uint32_t KdTree::nearest(const glm::vec3& query) const
+{
+    vector<KdNeighbour> result;
+    nearest(query, 1, result);
+    return result.empty() ? invalidIndex : result[0].index;
+}
+
+void KdTree::nearest(const glm::vec3& query, size_t k, vector<KdNeighbour>& result) const
+{
+    result.clear();
+    if (k == 0 || entries.empty())
+    {
+        return;
+    }
+    result.reserve(min(k, entries.size()));
+    nearestNode(0, entries.size(), query, k, result);
+    sort_heap(result.begin(), result.end(), neighbourLess);
+}
+
+//heap er en max-heap på avstand med de k nærmeste punktene så langt. Den nære siden av noden søkes først, så
+//heap fylles med nære punkter tidlig og den andre siden oftest kan hoppes over.
+void KdTree::nearestNode(size_t begin, size_t end, const glm::vec3& query, size_t k, vector<KdNeighbour>& heap) const
+{
+    auto consider = [&](size_t i)
+    {
+        float distance = distanceSquared(entries[i].position, query);
+        if (heap.size() < k)
+        {
+            heap.push_back({ entries[i].index, distance });
+            push_heap(heap.begin(), heap.end(), neighbourLess);
+        }
+        else if (distance < heap.front().distanceSquared)
+        {
+            pop_heap(heap.begin(), heap.end(), neighbourLess);
+            heap.back() = { entries[i].index, distance };
+            push_heap(heap.begin(), heap.end(), neighbourLess);
+        }
+    };
+
+    if (end - begin <= leafSize)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            consider(i);
+        }
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    int axis = splitAxes[mid];
+    float difference = query[axis] - entries[mid].position[axis];
+    if (difference < 0.0f)
+    {
+        nearestNode(begin, mid, query, k, heap);
+    }
+    else
+    {
+        nearestNode(mid + 1, end, query, k, heap);
+    }
+    consider(mid);
+    if (heap.size() < k || difference * difference < heap.front().distanceSquared)
+    {
+        if (difference < 0.0f)
+        {
+            nearestNode(mid + 1, end, query, k, heap);
+        }
+        else
+        {
+            nearestNode(begin, mid, query, k, heap);
+        }
+    }
+}
+
+void KdTree::withinRadius(const glm::vec3& query, float radius, vector<KdNeighbour>& result, bool sorted) const
+{
+    result.clear();
+    if (entries.empty() || radius < 0.0f)
+    {
+        return;
+    }
+    radiusNode(0, entries.size(), query, radius * radius, result);
+    if (sorted)
+    {
+        sort(result.begin(), result.end(), neighbourLess);
+    }
+}
+
+void KdTree::radiusNode(size_t begin, size_t end, const glm::vec3& query, float radiusSquared,
+    vector<KdNeighbour>& result) const
+{
+    if (end - begin <= leafSize)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            float distance = distanceSquared(entries[i].position, query);
+            if (distance <= radiusSquared)
+            {
+                result.push_back({ entries[i].index, distance });
+            }
+        }
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    int axis = splitAxes[mid];
+    float difference = query[axis] - entries[mid].position[axis];
+    float distance = distanceSquared(entries[mid].position, query);
+    if (distance <= radiusSquared)
+    {
+        result.push_back({ entries[mid].index, distance });
+    }
+    if (difference <= 0.0f || difference * difference <= radiusSquared)
+    {
+        radiusNode(begin, mid, query, radiusSquared, result);
+    }
+    if (difference >= 0.0f || difference * difference <= radiusSquared)
+    {
+        radiusNode(mid + 1, end, query, radiusSquared, result);
+    }
+}
+
+void KdTree::inBox(const glm::vec2& minCorner, const glm::vec2& maxCorner, vector<uint32_t>& result) const
+{
+    result.clear();
+    if (!entries.empty())
+    {
+        boxNode(0, entries.size(), glm::vec3(minCorner, 0.0f), glm::vec3(maxCorner, 0.0f), 2, result);
+    }
+}
+
+void KdTree::inBox(const glm::vec3& minCorner, const glm::vec3& maxCorner, vector<uint32_t>& result) const
+{
+    result.clear();
+    if (!entries.empty())
+    {
+        boxNode(0, entries.size(), minCorner, maxCorner, 3, result);
+    }
+}
+
+//Bare aksene under boxDimensions sjekkes. Noder som deler langs z når boksen er i xy, søker begge sidene.
+void KdTree::boxNode(size_t begin, size_t end, const glm::vec3& minCorner, const glm::vec3& maxCorner,
+    int boxDimensions, vector<uint32_t>& result) const
+{
+    auto consider = [&](size_t i)
+    {
+        const glm::vec3& p = entries[i].position;
+        for (int axis = 0; axis < boxDimensions; ++axis)
+        {
+            if (p[axis] < minCorner[axis] || p[axis] > maxCorner[axis])
+            {
+                return;
+            }
+        }
+        result.push_back(entries[i].index);
+    };
+
+    if (end - begin <= leafSize)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            consider(i);
+        }
+        return;
+    }
+
+    size_t mid = begin + (end - begin) / 2;
+    int axis = splitAxes[mid];
+    float split = entries[mid].position[axis];
+    consider(mid);
+    if (axis >= boxDimensions || minCorner[axis] <= split)
+    {
+        boxNode(begin, mid, minCorner, maxCorner, boxDimensions, result);
+    }
+    if (axis >= boxDimensions || split <= maxCorner[axis])
+    {
+        boxNode(mid + 1, end, minCorner, maxCorner, boxDimensions, result);
+    }
+}
+
+void KdTree::nearestBatch(const vector<glm::vec3>& queries, size_t k, vector<uint32_t>& indices,
+    vector<float>& distancesSquared, unsigned int threadCount) const
+{
+    indices.assign(queries.size() * k, invalidIndex);
+    distancesSquared.assign(queries.size() * k, numeric_limits<float>::infinity());
+    if (k == 0)
+    {
+        return;
+    }
+
+    parallelFor(queries.size(), threadCount == 0 ? workerCount() : threadCount,
+        [&](size_t begin, size_t end, unsigned int)
+    {
+        vector<KdNeighbour> found;
+        for (size_t i = begin; i < end; ++i)
+        {
+            nearest(queries[i], k, found);
+            for (size_t j = 0; j < found.size(); ++j)
+            {
+                indices[i * k + j] = found[j].index;
+                distancesSquared[i * k + j] = found[j].distanceSquared;
+            }
+        }
+    });
+}
+
+void KdTree::withinRadiusBatch(const vector<glm::vec3>& queries, float radius, vector<uint32_t>& offsets,
+    vector<uint32_t>& indices, unsigned int threadCount) const
+{
+    threadCount = threadCount == 0 ? workerCount() : threadCount;
+    //Avstandene trengs ikke i svaret, så hver tråd gjenbruker én tabell til dem
+    vector<vector<KdNeighbour>> partNeighbours(threadCount);
+    gatherBatch(queries.size(), threadCount, offsets, indices, [&](size_t i, vector<uint32_t>& found, unsigned int part)
+    {
+        vector<KdNeighbour>& neighbours = partNeighbours[part];
+        withinRadius(queries[i], radius, neighbours);
+        for (const auto& neighbour : neighbours)
+        {
+            found.push_back(neighbour.index);
+        }
+    });
+}
+
+void KdTree::inBoxBatch(const vector<glm::vec2>& minCorners, const vector<glm::vec2>& maxCorners,
+    vector<uint32_t>& offsets, vector<uint32_t>& indices, unsigned int threadCount) const
+{
+    size_t queryCount = min(minCorners.size(), maxCorners.size());
+    threadCount = threadCount == 0 ? workerCount() : threadCount;
+    gatherBatch(queryCount, threadCount, offsets, indices, [&](size_t i, vector<uint32_t>& found, unsigned int)
+    {
+        if (!entries.empty())
+        {
+            boxNode(0, entries.size(), glm::vec3(minCorners[i], 0.0f), glm::vec3(maxCorners[i], 0.0f), 2, found);
+        }
+    });
+}
@@ -0,0 +1,113 @@
+#ifndef KDTREE_H
+#define KDTREE_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+//Et punkt funnet av et søk i KdTree: indeksen i punktene treet ble bygget av og kvadratet av avstanden
+struct KdNeighbour
+{
+    uint32_t index;
+    float distanceSquared;
+};
+
+//k-d tre over en punktsky, for å finne de nærmeste punktene, punktene innenfor en radius og punktene i en boks
+//uten å gå gjennom alle punktene.
+//
+//Treet er implisitt: punktene ligger i én tabell (kopiert sammen med indeksen sin, 16 bytes per punkt), ordnet slik
+//at hver node er midten av et intervall [begin, end). Punktene før midten er venstre deltre og punktene etter er
+//høyre deltre, så det trengs ingen pekere, og hvert deltre ligger samlet i minnet. Intervaller med leafSize
+//punkter eller færre deles ikke videre og gås gjennom lineært. Hver node deler langs aksen der cellen den dekker
+//er bredest, så en flat terrengsky ikke deles i z før x og y er små nok.
+//
+//Med 2 dimensjoner brukes bare x og y (z i søkepunktet ignoreres), som er det BilinearSurface trenger for å
+//finne punktene nær (x, y). Med 3 dimensjoner brukes vanlig avstand i rommet.
+//
+//Byggingen deler de øverste nivåene med nth_element nivå for nivå, med alle nodene på et nivå fordelt på
+//trådene, og bygger resten av deltrærne parallelt når det er nok av dem. Søkene er const og trådsikre.
+class KdTree
+{
+public:
+    //Indeksen som fyller opp svaret fra nearestBatch når treet har færre enn k punkter
+    static const uint32_t invalidIndex = 0xffffffffu;
+    static const size_t leafSize = 16;
+
+    KdTree();
+    //0 tråder betyr workerCount()
+    KdTree(const vector<glm::vec3>& points, int dimensions = 3, unsigned int threadCount = 0);
+
+    void build(const vector<glm::vec3>& points, int dimensions = 3, unsigned int threadCount = 0);
+    void clear();
+
+    size_t size() const { return entries.size(); }
+    bool empty() const { return entries.empty(); }
+    int getDimensions() const { return dimensions; }
+    //Punktet med indeks index i punktene treet ble bygget av
+    glm::vec3 pointAt(uint32_t index) const { return entries[positions[index]].position; }
+    //Indeksen til punkt i i rekkefølgen punktene ligger i treet. Søk for punktene i denne rekkefølgen treffer de
+    //samme delene av treet etter hverandre, så mer av treet ligger i cachen enn med den opprinnelige rekkefølgen.
+    uint32_t indexInTreeOrder(size_t i) const { return entries[i].index; }
+
+    //Det nærmeste punktet, eller invalidIndex hvis treet er tomt
+    uint32_t nearest(const glm::vec3& query) const;
+    //De k nærmeste punktene, sortert med det nærmeste først. Færre enn k hvis treet har færre punkter.
+    void nearest(const glm::vec3& query, size_t k, vector<KdNeighbour>& result) const;
+    //Alle punktene med avstand <= radius. Usortert, med mindre sorted er satt.
+    void withinRadius(const glm::vec3& query, float radius, vector<KdNeighbour>& result, bool sorted = false) const;
+    //Indeksene til punktene med x og y innenfor boksen (z ignoreres), også for et tre med 3 dimensjoner
+    void inBox(const glm::vec2& minCorner, const glm::vec2& maxCorner, vector<uint32_t>& result) const;
+    //Indeksene til punktene innenfor boksen i rommet. For et tre med 2 dimensjoner testes z på punktene.
+    void inBox(const glm::vec3& minCorner, const glm::vec3& maxCorner, vector<uint32_t>& result) const;
+
+    //Søkene under kjører mange søk fordelt på trådene. Hver tråd skriver i sin egen del av svaret, så
+    //rekkefølgen er den samme som i queries uansett antall tråder. 0 tråder betyr workerCount().
+    //
+    //De k nærmeste punktene til hvert søkepunkt. Svaret for queries[i] ligger i indices og distancesSquared fra
+    //i * k, sortert med det nærmeste først, og fylles opp med invalidIndex og uendelig avstand.
+    void nearestBatch(const vector<glm::vec3>& queries, size_t k, vector<uint32_t>& indices,
+        vector<float>& distancesSquared, unsigned int threadCount = 0) const;
+    //Punktene innenfor radius fra hvert søkepunkt. Svaret for queries[i] er indices[offsets[i]] til
+    //indices[offsets[i + 1]], så offsets får queries.size() + 1 verdier.
+    void withinRadiusBatch(const vector<glm::vec3>& queries, float radius, vector<uint32_t>& offsets,
+        vector<uint32_t>& indices, unsigned int threadCount = 0) const;
+    //Punktene med x og y i hver boks, i samme format som withinRadiusBatch
+    void inBoxBatch(const vector<glm::vec2>& minCorners, const vector<glm::vec2>& maxCorners,
+        vector<uint32_t>& offsets, vector<uint32_t>& indices, unsigned int threadCount = 0) const;
+
+private:
+    struct Entry
+    {
+        glm::vec3 position;
+        uint32_t index;
+    };
+
+    //Et intervall som ikke er delt ennå, med cellen det dekker
+    struct PendingNode
+    {
+        size_t begin, end;
+        glm::vec3 cellMin, cellMax;
+    };
+
+    //Deler intervallet i node om midten og legger deltrærne som må deles videre i children. Returnerer antallet.
+    int splitNode(const PendingNode& node, PendingNode* children);
+    void buildSubtree(PendingNode node);
+
+    void nearestNode(size_t begin, size_t end, const glm::vec3& query, size_t k, vector<KdNeighbour>& heap) const;
+    void radiusNode(size_t begin, size_t end, const glm::vec3& query, float radiusSquared,
+        vector<KdNeighbour>& result) const;
+    void boxNode(size_t begin, size_t end, const glm::vec3& minCorner, const glm::vec3& maxCorner, int boxDimensions,
+        vector<uint32_t>& result) const;
+    float distanceSquared(const glm::vec3& a, const glm::vec3& b) const;
+
+    int dimensions;
+    vector<Entry> entries;
+    //Aksen noden i hvert intervall deler langs, lagret på plassen til midten av intervallet
+    vector<uint8_t> splitAxes;
+    //Hvor punkt i ligger i entries
+    vector<uint32_t> positions;
+};
+
+#endif
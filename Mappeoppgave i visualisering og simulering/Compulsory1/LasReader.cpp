@@ -0,0 +1,250 @@
+#include "LasReader.h"
+#include <iostream>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <cctype>
+
+//Plasseringen av feltene i LAS headeren (public header block), i bytes fra starten av filen
+static const size_t headerSizeField = 94;
+static const size_t pointDataOffsetField = 96;
+static const size_t pointFormatField = 104;
+static const size_t recordLengthField = 105;
+static const size_t legacyPointCountField = 107;
+static const size_t scaleField = 131;
+static const size_t offsetField = 155;
+static const size_t boundsField = 179;
+static const size_t pointCountField = 247;
+static const size_t legacyHeaderSize = 227;
+static const size_t headerSize14 = 375;
+
+//Antall punkter som leses om gangen av loadFile
+static const size_t chunkPoints = 1 << 20;
+
+template <class T>
+static T readValue(const char* data)
+{
+    T value;
+    memcpy(&value, data, sizeof(T));
+    return value;
+}
+
+LasReader::LasReader() : major(0), minor(0), format(0), recordLength(0), pointDataOffset(0),
+totalPoints(0), readPoints(0), scale(1.0), offset(0.0), minBounds(0.0), maxBounds(0.0) {}
+
+bool LasReader::isLasFile(const string& filename)
+{
+    if (filename.size() < 4)
+    {
+        return false;
+    }
+    string extension = filename.substr(filename.size() - 4);
+    transform(extension.begin(), extension.end(), extension.begin(), [](unsigned char c) { return static_cast<char>(tolower(c)); });
+    return extension == ".las";
+}
+
+size_t LasReader::minimumRecordLength(int format)
+{
+    static const size_t lengths[] = { 20, 28, 26, 34, 57, 63, 30, 36, 38, 59, 67 };
+    return format >= 0 && format <= 10 ? lengths[format] : 0;
+}
+
+bool LasReader::open(const string& filename)
+{
+    close();
+
+    inFile.open(filename, ios::binary);
+    if (!inFile.is_open())
+    {
+        cout << "Kunne ikke åpne LAS-filen: " << filename << endl;
+        return false;
+    }
+
+    char header[headerSize14] = {};
+    inFile.read(header, headerSize14);
+    size_t bytesRead = static_cast<size_t>(inFile.gcount());
+    inFile.clear();
+
+    if (bytesRead < legacyHeaderSize || memcmp(header, "LASF", 4) != 0)
+    {
+        cout << filename << " er ikke en LAS-fil" << endl;
+        close();
+        return false;
+    }
+
+    major = static_cast<unsigned char>(header[24]);
+    minor = static_cast<unsigned char>(header[25]);
+    size_t headerSize = readValue<uint16_t>(header + headerSizeField);
+    pointDataOffset = readValue<uint32_t>(header + pointDataOffsetField);
+    int formatId = static_cast<unsigned char>(header[pointFormatField]);
+    recordLength = readValue<uint16_t>(header + recordLengthField);
+
+    //De to øverste bitene i formatet er satt for komprimerte LAZ-filer
+    if (formatId & 0xC0)
+    {
+        cout << filename << " er komprimert (LAZ), og kan ikke leses direkte" << endl;
+        close();
+        return false;
+    }
+    format = formatId & 0x3F;
+
+    if (major != 1 || minor < 2 || minor > 4 || format > 10 || recordLength < minimumRecordLength(format))
+    {
+        cout << filename << ": LAS " << major << "." << minor << " med punktformat " << format << " støttes ikke" << endl;
+        close();
+        return false;
+    }
+
+    totalPoints = readValue<uint32_t>(header + legacyPointCountField);
+    if (minor >= 4 && headerSize >= headerSize14 && bytesRead >= headerSize14)
+    {
+        uint64_t pointCount64 = readValue<uint64_t>(header + pointCountField);
+        if (pointCount64 > 0)
+        {
+            totalPoints = pointCount64;
+        }
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        scale[axis] = readValue<double>(header + scaleField + axis * 8);
+        offset[axis] = readValue<double>(header + offsetField + axis * 8);
+        //Boksen står lagret som max x, min x, max y, min y, max z, min z
+        maxBounds[axis] = readValue<double>(header + boundsField + axis * 16);
+        minBounds[axis] = readValue<double>(header + boundsField + axis * 16 + 8);
+    }
+
+    inFile.seekg(static_cast<streamoff>(pointDataOffset));
+    readPoints = 0;
+    return inFile.good();
+}
+
+void LasReader::close()
+{
+    if (inFile.is_open())
+    {
+        inFile.close();
+    }
+    inFile.clear();
+    totalPoints = 0;
+    readPoints = 0;
+}
+
+size_t LasReader::readChunk(PointCloud& points, LasAttributes* attributes, size_t maxPoints, const PointTransform& transform)
+{
+    size_t count = static_cast<size_t>(min<uint64_t>(maxPoints, totalPoints - readPoints));
+    if (!inFile.is_open() || count == 0)
+    {
+        points.resize(0);
+        return 0;
+    }
+
+    recordBuffer.resize(count * recordLength);
+    inFile.read(recordBuffer.data(), static_cast<streamsize>(recordBuffer.size()));
+    count = static_cast<size_t>(inFile.gcount()) / recordLength;
+
+    points.resize(count);
+    float* x = points.writableX();
+    float* y = points.writableY();
+    float* z = points.writableZ();
+    if (attributes != nullptr)
+    {
+        attributes->classification.resize(count);
+        attributes->intensity.resize(count);
+    }
+
+    //Formatene 6-10 har hele klassifiseringen i en egen byte, de eldre formatene bruker de fem nederste bitene
+    bool extendedFormat = format >= 6;
+    glm::vec3 chunkMin(numeric_limits<float>::max());
+    glm::vec3 chunkMax(-numeric_limits<float>::max());
+
+    for (size_t i = 0; i < count; ++i)
+    {
+        const char* record = recordBuffer.data() + i * recordLength;
+        double worldX = readValue<int32_t>(record) * scale.x + offset.x;
+        double worldY = readValue<int32_t>(record + 4) * scale.y + offset.y;
+        double worldZ = readValue<int32_t>(record + 8) * scale.z + offset.z;
+
+        glm::vec3 point = transform.apply(worldX, worldY, worldZ);
+        x[i] = point.x;
+        y[i] = point.y;
+        z[i] = point.z;
+        chunkMin = glm::min(chunkMin, point);
+        chunkMax = glm::max(chunkMax, point);
+
+        if (attributes != nullptr)
+        {
+            attributes->intensity[i] = readValue<uint16_t>(record + 12);
+            attributes->classification[i] = extendedFormat ? static_cast<uint8_t>(record[16])
+                : static_cast<uint8_t>(record[15] & 0x1F);
+        }
+    }
+
+    points.minBounds = chunkMin;
+    points.maxBounds = chunkMax;
+    readPoints += count;
+
+    if (count == 0)
+    {
+        //Filen sluttet før antallet i headeren var lest
+        totalPoints = readPoints;
+    }
+    return count;
+}
+
+PointCloud LasReader::loadFile(const string& filename, const PointTransform& transform, LasAttributes* attributes)
+{
+    auto startTime = chrono::steady_clock::now();
+    PointCloud cloud;
+
+    LasReader reader;
+    if (!reader.open(filename))
+    {
+        return cloud;
+    }
+
+    cloud.resize(static_cast<size_t>(reader.pointCount()));
+    if (attributes != nullptr)
+    {
+        attributes->classification.resize(cloud.size());
+        attributes->intensity.resize(cloud.size());
+    }
+
+    PointCloud chunk;
+    LasAttributes chunkAttributes;
+    size_t written = 0;
+    cloud.minBounds = glm::vec3(numeric_limits<float>::max());
+    cloud.maxBounds = glm::vec3(-numeric_limits<float>::max());
+
+    while (size_t count = reader.readChunk(chunk, attributes != nullptr ? &chunkAttributes : nullptr, chunkPoints, transform))
+    {
+        memcpy(cloud.writableX() + written, chunk.x(), count * sizeof(float));
+        memcpy(cloud.writableY() + written, chunk.y(), count * sizeof(float));
+        memcpy(cloud.writableZ() + written, chunk.z(), count * sizeof(float));
+        if (attributes != nullptr)
+        {
+            memcpy(attributes->classification.data() + written, chunkAttributes.classification.data(), count);
+            memcpy(attributes->intensity.data() + written, chunkAttributes.intensity.data(), count * sizeof(uint16_t));
+        }
+        cloud.minBounds = glm::min(cloud.minBounds, chunk.minBounds);
+        cloud.maxBounds = glm::max(cloud.maxBounds, chunk.maxBounds);
+        written += count;
+    }
+
+    cloud.resize(written);
+    if (attributes != nullptr)
+    {
+        attributes->classification.resize(written);
+        attributes->intensity.resize(written);
+    }
+    if (cloud.empty())
+    {
+        cloud.minBounds = cloud.maxBounds = glm::vec3(0.0f);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << "Leste " << written << " punkter fra " << filename << " (LAS " << reader.versionMajor() << "."
+        << reader.versionMinor() << ", punktformat " << reader.pointFormat() << ") på " << seconds * 1000.0 << " ms" << endl;
+    return cloud;
+}
@@ -0,0 +1,74 @@
+#ifndef LASREADER_H
+#define LASREADER_H
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "PointCloud.h"
+#include "PointCloudLoader.h"
+
+using namespace std;
+
+//Ekstra kolonner fra LAS-filen som kan leses sammen med koordinatene. Tomme vektorer hvis de ikke er bedt om.
+struct LasAttributes
+{
+    vector<uint8_t> classification;
+    vector<uint16_t> intensity;
+};
+
+//Leser LiDAR-data direkte fra LAS 1.2-1.4 filer med punktformat 0-10, uten å gå via tekstfiler.
+//Punktene leses i biter, slik at hele filen aldri trenger å ligge i minnet samtidig. Heltallskoordinatene
+//gjøres om med skaleringen og forskyvningen i headeren og deretter med den samme transformasjonen
+//som brukes for tekstfilene, slik at punktene havner i samme koordinatsystem.
+//Komprimerte LAZ-filer støttes ikke.
+//Referanse https://www.asprs.org/wp-content/uploads/2019/07/LAS_1_4_r15.pdf
+class LasReader
+{
+public:
+    LasReader();
+
+    //Åpner filen og leser headeren. Returnerer false hvis filen ikke er en LAS-fil som kan leses.
+    bool open(const string& filename);
+    void close();
+
+    //Leser opp til maxPoints punkter inn i points (og attributes hvis den ikke er nullptr).
+    //Returnerer antall punkter som ble lest, 0 når hele filen er lest.
+    size_t readChunk(PointCloud& points, LasAttributes* attributes, size_t maxPoints, const PointTransform& transform);
+
+    //Leser hele filen i biter og setter sammen punktskyen
+    static PointCloud loadFile(const string& filename, const PointTransform& transform, LasAttributes* attributes = nullptr);
+
+    uint64_t pointCount() const { return totalPoints; }
+    uint64_t pointsRead() const { return readPoints; }
+    int pointFormat() const { return format; }
+    int versionMajor() const { return major; }
+    int versionMinor() const { return minor; }
+    //Skaleringen og forskyvningen fra headeren, brukt på heltallskoordinatene i hvert punkt
+    glm::dvec3 headerScale() const { return scale; }
+    glm::dvec3 headerOffset() const { return offset; }
+    //Boksen rundt punktene slik den står i headeren, i filens egne koordinater
+    glm::dvec3 headerMinBounds() const { return minBounds; }
+    glm::dvec3 headerMaxBounds() const { return maxBounds; }
+
+    //Sjekker om filnavnet slutter på .las
+    static bool isLasFile(const string& filename);
+
+private:
+    //Minste lengde på et punkt for hvert punktformat 0-10
+    static size_t minimumRecordLength(int format);
+
+    ifstream inFile;
+    vector<char> recordBuffer;
+    int major, minor;
+    int format;
+    size_t recordLength;
+    uint64_t pointDataOffset;
+    uint64_t totalPoints;
+    uint64_t readPoints;
+    glm::dvec3 scale, offset;
+    glm::dvec3 minBounds, maxBounds;
+};
+
+#endif
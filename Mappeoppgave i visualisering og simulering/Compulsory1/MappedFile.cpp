@@ -0,0 +1,129 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+//Referanse https://learn.microsoft.com/en-us/windows/win32/memory/creating-a-file-view
+//Referanse https://man7.org/linux/man-pages/man2/mmap.2.html
+
+#ifdef _WIN32
+MappedFile::MappedFile() : mappedData(nullptr), fileSize(0), opened(false), fileHandle(INVALID_HANDLE_VALUE), mappingHandle(nullptr) {}
+#else
+MappedFile::MappedFile() : mappedData(nullptr), fileSize(0), opened(false), fileDescriptor(-1) {}
+#endif
+
+MappedFile::~MappedFile()
+{
+    close();
+}
+
+bool MappedFile::open(const string& filename)
+{
+    close();
+
+#ifdef _WIN32
+    fileHandle = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+        FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (fileHandle == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(fileHandle, &size))
+    {
+        close();
+        return false;
+    }
+    fileSize = static_cast<size_t>(size.QuadPart);
+
+    //En tom fil kan ikke mappes, men regnes som åpnet med størrelse 0
+    if (fileSize > 0)
+    {
+        mappingHandle = CreateFileMappingA(fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mappingHandle == nullptr)
+        {
+            close();
+            return false;
+        }
+
+        mappedData = static_cast<const char*>(MapViewOfFile(mappingHandle, FILE_MAP_READ, 0, 0, 0));
+        if (mappedData == nullptr)
+        {
+            close();
+            return false;
+        }
+    }
+#else
+    fileDescriptor = ::open(filename.c_str(), O_RDONLY);
+    if (fileDescriptor < 0)
+    {
+        return false;
+    }
+
+    struct stat fileInfo;
+    if (fstat(fileDescriptor, &fileInfo) != 0)
+    {
+        close();
+        return false;
+    }
+    fileSize = static_cast<size_t>(fileInfo.st_size);
+
+    if (fileSize > 0)
+    {
+        void* address = mmap(nullptr, fileSize, PROT_READ, MAP_PRIVATE, fileDescriptor, 0);
+        if (address == MAP_FAILED)
+        {
+            close();
+            return false;
+        }
+        mappedData = static_cast<const char*>(address);
+        madvise(address, fileSize, MADV_SEQUENTIAL);
+    }
+#endif
+
+    opened = true;
+    return true;
+}
+
+void MappedFile::close()
+{
+#ifdef _WIN32
+    if (mappedData != nullptr)
+    {
+        UnmapViewOfFile(mappedData);
+    }
+    if (mappingHandle != nullptr)
+    {
+        CloseHandle(mappingHandle);
+        mappingHandle = nullptr;
+    }
+    if (fileHandle != INVALID_HANDLE_VALUE)
+    {
+        CloseHandle(fileHandle);
+        fileHandle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (mappedData != nullptr)
+    {
+        munmap(const_cast<char*>(mappedData), fileSize);
+    }
+    if (fileDescriptor >= 0)
+    {
+        ::close(fileDescriptor);
+        fileDescriptor = -1;
+    }
+#endif
+
+    mappedData = nullptr;
+    fileSize = 0;
+    opened = false;
+}
@@ -0,0 +1,41 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <string>
+#include <cstddef>
+
+using namespace std;
+
+//Minnemapper en fil slik at innholdet kan leses direkte fra minnet uten å kopiere det over i egne buffere.
+//Operativsystemet henter inn sidene etter hvert som de blir lest. Filen åpnes kun for lesing.
+class MappedFile
+{
+public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    //Åpner og mapper filen. Returnerer false hvis filen ikke finnes eller ikke kan mappes.
+    bool open(const string& filename);
+    void close();
+
+    bool isOpen() const { return opened; }
+    const char* data() const { return mappedData; }
+    size_t size() const { return fileSize; }
+
+private:
+    const char* mappedData;
+    size_t fileSize;
+    bool opened;
+
+#ifdef _WIN32
+    void* fileHandle;
+    void* mappingHandle;
+#else
+    int fileDescriptor;
+#endif
+};
+
+#endif
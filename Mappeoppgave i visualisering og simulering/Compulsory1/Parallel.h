@@ -0,0 +1,89 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <vector>
+#include <thread>
+#include <algorithm>
+#include <atomic>
+
+using namespace std;
+
+//Antall tråder som brukes til de parallelle delene av programmet. Gir alltid minst én tråd.
+inline unsigned int workerCount()
+{
+    unsigned int count = thread::hardware_concurrency();
+    return count == 0 ? 1 : count;
+}
+
+//Deler intervallet [0, count) i like store biter og kjører hver bit på sin egen tråd.
+//Funksjonen får start, slutt og nummeret på biten. Den siste biten kjøres på tråden som kaller funksjonen.
+template <class Function>
+void parallelFor(size_t count, unsigned int threadCount, Function function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    threadCount = static_cast<unsigned int>(min<size_t>(max(threadCount, 1u), count));
+    size_t chunkSize = (count + threadCount - 1) / threadCount;
+    threadCount = static_cast<unsigned int>((count + chunkSize - 1) / chunkSize);
+
+    vector<thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int t = 0; t + 1 < threadCount; ++t)
+    {
+        size_t begin = t * chunkSize;
+        size_t end = min(begin + chunkSize, count);
+        threads.emplace_back(function, begin, end, t);
+    }
+
+    function(static_cast<size_t>(threadCount - 1) * chunkSize, count, threadCount - 1);
+
+    for (auto& worker : threads)
+    {
+        worker.join();
+    }
+}
+
+template <class Function>
+void parallelFor(size_t count, Function function)
+{
+    parallelFor(count, workerCount(), function);
+}
+
+//Kjører function(index) for hver index i [0, count) på threadCount tråder. I stedet for faste biter henter
+//hver tråd neste ledige index når den er ferdig, slik at jobber av ulik størrelse (f.eks filer) fordeles jevnt.
+template <class Function>
+void parallelForEach(size_t count, unsigned int threadCount, Function function)
+{
+    if (count == 0)
+    {
+        return;
+    }
+
+    threadCount = static_cast<unsigned int>(min<size_t>(max(threadCount, 1u), count));
+    atomic<size_t> nextIndex(0);
+    auto worker = [&]()
+    {
+        for (size_t i = nextIndex++; i < count; i = nextIndex++)
+        {
+            function(i);
+        }
+    };
+
+    vector<thread> threads;
+    threads.reserve(threadCount - 1);
+    for (unsigned int t = 0; t + 1 < threadCount; ++t)
+    {
+        threads.emplace_back(worker);
+    }
+    worker();
+
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+}
+
+#endif
@@ -0,0 +1,513 @@
+#include "ParallelDelaunay.h"
+#include "GridDelaunay.h"
+#include "DelaunayTriangulator.h"
+#include "Predicates.h"
+#include "RadixSort.h"
+#include "Parallel.h"
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <limits>
+
+//Under dette antallet punkter per stripe lønner det seg ikke å dele opp
+static const size_t minimumStripPoints = 4096;
+
+//Trekanten rotert slik at det minste hjørnet kommer først. Orienteringen beholdes, så samme trekant gir
+//samme tre tall uansett hvilken triangulering den kommer fra.
+static glm::ivec3 canonicalTriangle(const glm::ivec3& triangle)
+{
+    if (triangle.y < triangle.x && triangle.y < triangle.z)
+    {
+        return glm::ivec3(triangle.y, triangle.z, triangle.x);
+    }
+    if (triangle.z < triangle.x && triangle.z < triangle.y)
+    {
+        return glm::ivec3(triangle.z, triangle.x, triangle.y);
+    }
+    return triangle;
+}
+
+static bool triangleLess(const glm::ivec3& a, const glm::ivec3& b)
+{
+    if (a.x != b.x) return a.x < b.x;
+    if (a.y != b.y) return a.y < b.y;
+    return a.z < b.z;
+}
+
+//Hjørnene til trekantene, rotert slik at det minste hjørnet (x, så y) kommer først, og sortert. To trianguleringer
+//av de samme punktene gir samme tabell hvis de har de samme trekantene, også når punkter som ligger oppå hverandre
+//har fått ulik indeks.
+static vector<array<glm::dvec2, 3>> sortedTriangleCorners(const vector<glm::dvec2>& points, const vector<glm::ivec3>& triangles)
+{
+    auto pointLess = [](const glm::dvec2& a, const glm::dvec2& b)
+    {
+        return a.x != b.x ? a.x < b.x : a.y < b.y;
+    };
+    vector<array<glm::dvec2, 3>> result(triangles.size());
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        int first = 0;
+        for (int i = 1; i < 3; ++i)
+        {
+            if (pointLess(points[triangles[t][i]], points[triangles[t][first]]))
+            {
+                first = i;
+            }
+        }
+        for (int i = 0; i < 3; ++i)
+        {
+            result[t][i] = points[triangles[t][(first + i) % 3]];
+        }
+    }
+    sort(result.begin(), result.end(), [&](const array<glm::dvec2, 3>& a, const array<glm::dvec2, 3>& b)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (a[i] != b[i])
+            {
+                return pointLess(a[i], b[i]);
+            }
+        }
+        return false;
+    });
+    return result;
+}
+
+//Sentrum og radius til den omskrevne sirkelen til trekanten
+static void circumcircle(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, glm::dvec2& center, double& radius)
+{
+    glm::dvec2 ab = b - a;
+    glm::dvec2 ac = c - a;
+    double d = 2.0 * (ab.x * ac.y - ab.y * ac.x);
+    double abLength = glm::dot(ab, ab);
+    double acLength = glm::dot(ac, ac);
+    glm::dvec2 relative((ac.y * abLength - ab.y * acLength) / d, (ab.x * acLength - ac.x * abLength) / d);
+    radius = glm::length(relative);
+    center = a + relative;
+}
+
+//Rutenett med punktene som ikke er skjøtpunkter, sortert celle for celle (tellesortering)
+struct InteriorGrid
+{
+    glm::dvec2 origin;
+    double cellSize;
+    int columns, rows;
+    vector<uint32_t> cellStart;
+    vector<uint32_t> pointIndices;
+
+    glm::ivec2 cellOf(const glm::dvec2& point) const
+    {
+        glm::ivec2 cell(static_cast<int>(floor((point.x - origin.x) / cellSize)), static_cast<int>(floor((point.y - origin.y) / cellSize)));
+        return glm::clamp(cell, glm::ivec2(0), glm::ivec2(columns - 1, rows - 1));
+    }
+
+    void build(const vector<glm::dvec2>& points, const vector<char>& isSeam, const glm::dvec2& minBounds, const glm::dvec2& maxBounds)
+    {
+        size_t interiorCount = 0;
+        for (char seam : isSeam)
+        {
+            interiorCount += seam ? 0 : 1;
+        }
+
+        glm::dvec2 extent = glm::max(maxBounds - minBounds, glm::dvec2(1e-12));
+        cellSize = max(sqrt(extent.x * extent.y / max<size_t>(interiorCount, 1)), max(extent.x, extent.y) / 4096.0);
+        origin = minBounds;
+        columns = static_cast<int>(extent.x / cellSize) + 1;
+        rows = static_cast<int>(extent.y / cellSize) + 1;
+
+        vector<uint32_t> pointCell(points.size());
+        cellStart.assign(static_cast<size_t>(columns) * rows + 1, 0);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (!isSeam[i])
+            {
+                glm::ivec2 cell = cellOf(points[i]);
+                pointCell[i] = static_cast<uint32_t>(cell.y * columns + cell.x);
+                ++cellStart[pointCell[i] + 1];
+            }
+        }
+        for (size_t c = 1; c < cellStart.size(); ++c)
+        {
+            cellStart[c] += cellStart[c - 1];
+        }
+        pointIndices.resize(interiorCount);
+        vector<uint32_t> position(cellStart.begin(), cellStart.end() - 1);
+        for (size_t i = 0; i < points.size(); ++i)
+        {
+            if (!isSeam[i])
+            {
+                pointIndices[position[pointCell[i]]++] = static_cast<uint32_t>(i);
+            }
+        }
+    }
+
+    //Ser etter om et av punktene ligger inne i den omskrevne sirkelen til trekanten (a, b, c). Bare cellene
+    //som overlapper sirkelen gås gjennom, rad for rad. Cellen i sentrum sjekkes først, så en stor sirkel midt
+    //inne blant punktene avvises med en gang. Punkter som ligger oppå et hjørne er ikke med i trianguleringen,
+    //og inCircleSymbolic kan gi begge svar for dem, så de hoppes over.
+    bool anyPointInCircle(const vector<glm::dvec2>& points, const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c) const
+    {
+        glm::dvec2 center;
+        double radius;
+        circumcircle(a, b, c, center, radius);
+
+        auto checkCell = [&](int x, int y)
+        {
+            size_t cell = static_cast<size_t>(y) * columns + x;
+            for (uint32_t k = cellStart[cell]; k < cellStart[cell + 1]; ++k)
+            {
+                const glm::dvec2& point = points[pointIndices[k]];
+                if (point != a && point != b && point != c && inCircleSymbolic(a, b, c, point) > 0)
+                {
+                    return true;
+                }
+            }
+            return false;
+        };
+
+        glm::dvec2 relative = (center - origin) / cellSize;
+        double cellRadius = radius / cellSize;
+        if (relative.x >= 0.0 && relative.y >= 0.0 && relative.x < columns && relative.y < rows &&
+            checkCell(static_cast<int>(relative.x), static_cast<int>(relative.y)))
+        {
+            return true;
+        }
+
+        int firstRow = static_cast<int>(max(floor(relative.y - cellRadius), 0.0));
+        int lastRow = static_cast<int>(min(floor(relative.y + cellRadius), rows - 1.0));
+        for (int y = firstRow; y <= lastRow; ++y)
+        {
+            //Den delen av sirkelen som ligger i raden er bredest der raden er nærmest sentrum
+            double nearestY = min(max(relative.y, static_cast<double>(y)), y + 1.0);
+            double dy = nearestY - relative.y;
+            double halfWidth = sqrt(max(cellRadius * cellRadius - dy * dy, 0.0));
+            int firstColumn = static_cast<int>(max(floor(relative.x - halfWidth), 0.0));
+            int lastColumn = static_cast<int>(min(floor(relative.x + halfWidth), columns - 1.0));
+            for (int x = firstColumn; x <= lastColumn; ++x)
+            {
+                if (checkCell(x, y))
+                {
+                    return true;
+                }
+            }
+        }
+        return false;
+    }
+};
+
+static unsigned int triangulationStripCount(size_t count, unsigned int threadCount)
+{
+    return static_cast<unsigned int>(min<size_t>(threadCount, count / minimumStripPoints));
+}
+
+vector<glm::ivec3> completeDelaunayTriangulation(const vector<glm::dvec2>& points,
+    const vector<vector<glm::ivec3>>& finalTriangles, const vector<char>& isSeam, unsigned int threadCount,
+    size_t* seamPointCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = workerCount();
+    }
+    size_t count = points.size();
+    glm::dvec2 minBounds(0.0), maxBounds(0.0);
+    if (count > 0)
+    {
+        minBounds = maxBounds = points[0];
+    }
+    for (const auto& point : points)
+    {
+        minBounds = glm::min(minBounds, point);
+        maxBounds = glm::max(maxBounds, point);
+    }
+
+    //Triangulerer skjøtpunktene samlet
+    vector<uint32_t> seamIndices;
+    vector<glm::dvec2> seamPoints;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (isSeam[i])
+        {
+            seamIndices.push_back(static_cast<uint32_t>(i));
+            seamPoints.push_back(points[i]);
+        }
+    }
+    DelaunayTriangulator seamTriangulator;
+    seamTriangulator.triangulate(seamPoints);
+    vector<glm::ivec3> seamTriangles = seamTriangulator.triangles();
+
+    //Bare ferdige trekanter med alle hjørnene i skjøten kan også finnes blant skjøttrekantene
+    vector<glm::ivec3> result;
+    vector<glm::ivec3> finalSeamTriangles;
+    size_t finalCount = 0;
+    for (const auto& triangles : finalTriangles)
+    {
+        finalCount += triangles.size();
+    }
+    result.reserve(finalCount + seamTriangles.size());
+    for (const auto& triangles : finalTriangles)
+    {
+        result.insert(result.end(), triangles.begin(), triangles.end());
+        for (const auto& triangle : triangles)
+        {
+            if (isSeam[triangle.x] && isSeam[triangle.y] && isSeam[triangle.z])
+            {
+                finalSeamTriangles.push_back(canonicalTriangle(triangle));
+            }
+        }
+    }
+    sort(finalSeamTriangles.begin(), finalSeamTriangles.end(), triangleLess);
+
+    //En skjøttrekant er allerede med hvis den er ferdig. Ellers er den med i den globale trianguleringen hvis
+    //ingen av de andre punktene ligger i den omskrevne sirkelen (skjøtpunktene gjør ikke det).
+    InteriorGrid interior;
+    interior.build(points, isSeam, minBounds, maxBounds);
+    vector<vector<glm::ivec3>> keptTriangles(threadCount);
+    parallelFor(seamTriangles.size(), threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const glm::ivec3& local = seamTriangles[t];
+            glm::ivec3 global = canonicalTriangle(glm::ivec3(seamIndices[local.x], seamIndices[local.y], seamIndices[local.z]));
+            if (binary_search(finalSeamTriangles.begin(), finalSeamTriangles.end(), global, triangleLess))
+            {
+                continue;
+            }
+            if (interior.anyPointInCircle(points, points[global.x], points[global.y], points[global.z]))
+            {
+                continue;
+            }
+            keptTriangles[chunk].push_back(global);
+        }
+    });
+    for (const auto& triangles : keptTriangles)
+    {
+        result.insert(result.end(), triangles.begin(), triangles.end());
+    }
+    if (seamPointCount)
+    {
+        *seamPointCount = seamPoints.size();
+    }
+    return result;
+}
+
+vector<glm::ivec3> parallelDelaunayTriangulation(const vector<glm::dvec2>& points, unsigned int threadCount,
+    TriangulationStatistics* statistics)
+{
+    auto startTime = chrono::steady_clock::now();
+    if (threadCount == 0)
+    {
+        threadCount = workerCount();
+    }
+    size_t count = points.size();
+    unsigned int stripCount = triangulationStripCount(count, threadCount);
+
+    if (stripCount < 2)
+    {
+        DelaunayTriangulator triangulator;
+        triangulator.triangulate(points);
+        vector<glm::ivec3> result = triangulator.triangles();
+        if (statistics)
+        {
+            *statistics = TriangulationStatistics();
+            statistics->pointCount = count;
+            statistics->triangleCount = result.size();
+            statistics->strips = 1;
+            statistics->seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+            statistics->stripSeconds = statistics->seconds;
+        }
+        return result;
+    }
+
+    glm::dvec2 minBounds = points[0], maxBounds = points[0];
+    for (const auto& point : points)
+    {
+        minBounds = glm::min(minBounds, point);
+        maxBounds = glm::max(maxBounds, point);
+    }
+
+    //Sorterer punktene i x-retning (32 bits nøkler) og deler dem i like store striper
+    double xScale = 4294967295.0 / max(maxBounds.x - minBounds.x, 1e-300);
+    vector<uint64_t> keys(count);
+    vector<uint32_t> order(count);
+    parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            keys[i] = static_cast<uint64_t>((points[i].x - minBounds.x) * xScale);
+            order[i] = static_cast<uint32_t>(i);
+        }
+    });
+    parallelRadixSort(keys, order, 32, threadCount);
+
+    vector<size_t> stripStart(stripCount + 1);
+    for (unsigned int s = 0; s <= stripCount; ++s)
+    {
+        stripStart[s] = count * s / stripCount;
+    }
+
+    //Stripen strekker seg fra det største x-et i stripen til venstre til det minste x-et i stripen til høyre.
+    //Sirklene må ligge et lite stykke innenfor, så avrundingsfeil i sentrum og radius ikke gjør noe.
+    const double margin = 1e-9 * max(maxBounds.x - minBounds.x, maxBounds.y - minBounds.y);
+    auto stripMaxX = [&](unsigned int s)
+    {
+        double result = -numeric_limits<double>::infinity();
+        for (size_t k = stripStart[s]; k < stripStart[s + 1]; ++k)
+        {
+            result = max(result, points[order[k]].x);
+        }
+        return result;
+    };
+    auto stripMinX = [&](unsigned int s)
+    {
+        double result = numeric_limits<double>::infinity();
+        for (size_t k = stripStart[s]; k < stripStart[s + 1]; ++k)
+        {
+            result = min(result, points[order[k]].x);
+        }
+        return result;
+    };
+
+    vector<char> isSeam(count, 0);
+    vector<vector<glm::ivec3>> finalTriangles(stripCount);
+    parallelForEach(stripCount, threadCount, [&](size_t s)
+    {
+        unsigned int strip = static_cast<unsigned int>(s);
+        double leftLimit = strip == 0 ? -numeric_limits<double>::infinity() : stripMaxX(strip - 1) + margin;
+        double rightLimit = strip + 1 == stripCount ? numeric_limits<double>::infinity() : stripMinX(strip + 1) - margin;
+
+        size_t begin = stripStart[strip];
+        size_t stripSize = stripStart[strip + 1] - begin;
+        vector<glm::dvec2> stripPoints(stripSize);
+        for (size_t k = 0; k < stripSize; ++k)
+        {
+            stripPoints[k] = points[order[begin + k]];
+        }
+
+        DelaunayTriangulator triangulator;
+        triangulator.triangulate(stripPoints);
+        vector<char> onBoundary = triangulator.boundaryVertices();
+
+        for (const auto& triangle : triangulator.triangles())
+        {
+            glm::dvec2 center;
+            double radius;
+            circumcircle(stripPoints[triangle.x], stripPoints[triangle.y], stripPoints[triangle.z], center, radius);
+            glm::ivec3 global(order[begin + triangle.x], order[begin + triangle.y], order[begin + triangle.z]);
+            if (center.x - radius > leftLimit && center.x + radius < rightLimit)
+            {
+                finalTriangles[strip].push_back(global);
+            }
+            else
+            {
+                isSeam[global.x] = isSeam[global.y] = isSeam[global.z] = 1;
+            }
+        }
+
+        //Punkter på randen av stripen hører også til skjøten, også punkter som bare er med i trekanter med den
+        //store trekanten (alle punktene i stripen ligger på en linje). Punkter som ligger oppå et annet punkt i
+        //stripen er ikke med i noen trekant og holdes utenfor, som i DelaunayTriangulator. Var de skjøtpunkter,
+        //ville skjøten lage trekanter rundt dem oppå de ferdige trekantene rundt punktet de ligger oppå.
+        for (size_t k = 0; k < stripSize; ++k)
+        {
+            if (onBoundary[k])
+            {
+                isSeam[order[begin + k]] = 1;
+            }
+        }
+    });
+    auto stripTime = chrono::steady_clock::now();
+
+    size_t seamPointCount = 0;
+    vector<glm::ivec3> result = completeDelaunayTriangulation(points, finalTriangles, isSeam, threadCount, &seamPointCount);
+
+    if (statistics)
+    {
+        auto endTime = chrono::steady_clock::now();
+        statistics->pointCount = count;
+        statistics->triangleCount = result.size();
+        statistics->strips = stripCount;
+        statistics->seamPoints = seamPointCount;
+        statistics->stripSeconds = chrono::duration<double>(stripTime - startTime).count();
+        statistics->seamSeconds = chrono::duration<double>(endTime - stripTime).count();
+        statistics->seconds = chrono::duration<double>(endTime - startTime).count();
+    }
+    return result;
+}
+
+TriangleMesh parallelDelaunayMesh(const vector<glm::dvec2>& points, unsigned int threadCount,
+    TriangulationStatistics* statistics)
+{
+    auto startTime = chrono::steady_clock::now();
+    if (threadCount == 0)
+    {
+        threadCount = workerCount();
+    }
+
+    TriangleMesh mesh;
+    if (triangulationStripCount(points.size(), threadCount) < 2)
+    {
+        //Naboene finnes allerede i DelaunayTriangulator
+        DelaunayTriangulator triangulator;
+        triangulator.triangulate(points);
+        mesh = triangulator.mesh();
+        if (statistics)
+        {
+            *statistics = TriangulationStatistics();
+            statistics->pointCount = points.size();
+            statistics->triangleCount = mesh.triangleCount();
+            statistics->strips = 1;
+            statistics->stripSeconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+        }
+    }
+    else
+    {
+        mesh.build(points.size(), parallelDelaunayTriangulation(points, threadCount, statistics), threadCount);
+    }
+
+    if (statistics)
+    {
+        statistics->seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    }
+    return mesh;
+}
+
+void printTriangulationSpeedup(const vector<glm::dvec2>& points, unsigned int maxThreads)
+{
+    TriangulationStatistics serial;
+    PredicateStatistics before = predicateStatistics();
+    vector<array<glm::dvec2, 3>> serialCorners = sortedTriangleCorners(points, parallelDelaunayTriangulation(points, 1, &serial));
+    PredicateStatistics after = predicateStatistics();
+    cout << "Triangulering av " << points.size() << " punkter, seriell: " << fixed << setprecision(1)
+        << serial.seconds * 1000.0 << " ms, " << serial.triangleCount << " trekanter" << endl;
+    cout << "  Eksakt orient2d: " << after.orientExact - before.orientExact << " av " << after.orientCalls - before.orientCalls
+        << ", eksakt inCircle: " << after.inCircleExact - before.inCircleExact << " av " << after.inCircleCalls - before.inCircleCalls
+        << ", punkter på sirkelen: " << after.symbolicTies - before.symbolicTies << endl;
+
+    for (unsigned int threads = 2; threads <= max(maxThreads, 1u); ++threads)
+    {
+        TriangulationStatistics parallel;
+        vector<glm::ivec3> triangles = parallelDelaunayTriangulation(points, threads, &parallel);
+        bool same = sortedTriangleCorners(points, triangles) == serialCorners;
+        cout << "  " << threads << " tråder: " << parallel.seconds * 1000.0 << " ms (striper "
+            << parallel.stripSeconds * 1000.0 << " ms, skjøter " << parallel.seamSeconds * 1000.0 << " ms, "
+            << parallel.seamPoints << " skjøtpunkter), speed-up " << setprecision(2) << serial.seconds / parallel.seconds
+            << setprecision(1) << ", " << parallel.triangleCount << " trekanter"
+            << (same ? "" : " (ikke de samme trekantene som seriell!)") << endl;
+    }
+
+    vector<glm::ivec3> gridTriangles;
+    TriangulationStatistics grid;
+    if (gridDelaunayTriangulation(points, gridTriangles, maxThreads, &grid))
+    {
+        cout << "  Rutenett: " << grid.seconds * 1000.0 << " ms (ruter " << grid.stripSeconds * 1000.0 << " ms, resten "
+            << grid.seamSeconds * 1000.0 << " ms, " << grid.seamPoints << " skjøtpunkter), speed-up " << setprecision(2)
+            << serial.seconds / grid.seconds << setprecision(1) << ", " << grid.triangleCount << " trekanter"
+            << (sortedTriangleCorners(points, gridTriangles) == serialCorners ? "" : " (ikke de samme trekantene som seriell!)")
+            << endl;
+    }
+    cout.unsetf(ios::fixed);
+    cout << setprecision(6);
+}
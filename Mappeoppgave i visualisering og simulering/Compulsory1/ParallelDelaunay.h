@@ -0,0 +1,59 @@
+#ifndef PARALLELDELAUNAY_H
+#define PARALLELDELAUNAY_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "TriangleMesh.h"
+
+using namespace std;
+
+struct TriangulationStatistics
+{
+    size_t pointCount = 0;
+    size_t triangleCount = 0;
+    unsigned int strips = 0;
+    //Punktene langs skjøtene som ble triangulert på nytt
+    size_t seamPoints = 0;
+    double stripSeconds = 0.0;
+    double seamSeconds = 0.0;
+    double seconds = 0.0;
+};
+
+//Parallell Delaunay triangulering (del og hersk). Punktene deles i like store striper i x-retning, og hver
+//stripe trianguleres på sin egen tråd med DelaunayTriangulator.
+//
+//En trekant i en stripe er med i den globale trianguleringen hvis den omskrevne sirkelen ligger helt innenfor
+//stripen i x-retning: da kan ingen punkter fra de andre stripene ligge i sirkelen. Slike trekanter er ferdige.
+//Punktene som er hjørner i en trekant som ikke er ferdig, eller som ligger på randen av stripen, er skjøtpunkter.
+//Alle andre punkter er omgitt av ferdige trekanter. Skjøtpunktene trianguleres samlet, og av disse trekantene
+//beholdes de som ikke allerede er ferdige og ikke har noen av de andre punktene i den omskrevne sirkelen.
+//Skjøtene har omtrent sqrt(n) punkter per stripe, så nesten alt arbeidet gjøres parallelt.
+//
+//Resultatet er de samme trekantene som DelaunayTriangulator gir for alle punktene samlet, også for punkter i et
+//regulært rutenett, siden punkter på samme sirkel avgjøres likt overalt (inCircleSymbolic). Trekantene er mot
+//klokka og bruker indeksene til points. Med threadCount 1, eller få punkter, brukes DelaunayTriangulator
+//direkte. 0 betyr workerCount() tråder.
+vector<glm::ivec3> parallelDelaunayTriangulation(const vector<glm::dvec2>& points, unsigned int threadCount = 0,
+    TriangulationStatistics* statistics = nullptr);
+
+//Setter sammen Delaunay trianguleringen av alle punktene fra trekanter som allerede er ferdige og skjøtpunktene.
+//finalTriangles må være trekanter i Delaunay trianguleringen av alle punktene (ingen punkter i den omskrevne
+//sirkelen), og hvert punkt som ikke er skjøtpunkt (isSeam 0) må ha alle trekantene rundt seg blant dem.
+//Skjøtpunktene trianguleres samlet, og de nye trekantene som ikke har noen av de andre punktene i den omskrevne
+//sirkelen legges til. Brukes av parallelDelaunayTriangulation og gridDelaunayTriangulation (GridDelaunay.h).
+vector<glm::ivec3> completeDelaunayTriangulation(const vector<glm::dvec2>& points,
+    const vector<vector<glm::ivec3>>& finalTriangles, const vector<char>& isSeam, unsigned int threadCount = 0,
+    size_t* seamPointCount = nullptr);
+
+//Som parallelDelaunayTriangulation, men gir trekantene som et TriangleMesh med naboene. Med én stripe brukes
+//naboene fra DelaunayTriangulator, ellers finnes de ved å sortere kantene. seconds i statistics tar med
+//tiden det tar å lage nettet.
+TriangleMesh parallelDelaunayMesh(const vector<glm::dvec2>& points, unsigned int threadCount = 0,
+    TriangulationStatistics* statistics = nullptr);
+
+//Triangulerer punktene serielt og parallelt med 1 til maxThreads tråder og skriver tid og speed-up til konsollen,
+//sammen med hvor ofte de eksakte testene i Predicates.h ble brukt. Ligger punktene i et rutenett, skrives også
+//tiden for gridDelaunayTriangulation. Hver kjøring sjekkes mot trekantene fra den serielle trianguleringen.
+void printTriangulationSpeedup(const vector<glm::dvec2>& points, unsigned int maxThreads);
+
+#endif
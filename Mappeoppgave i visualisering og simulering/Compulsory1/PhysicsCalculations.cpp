@@ -11,7 +11,7 @@ void PhysicsCalculations::applyFriction(glm::vec3& velocity, const glm::vec3& po
     float normalFriction, float highFriction, float frictionAreaXMin, float frictionAreaXMax,
     float frictionAreaYMin, float frictionAreaYMax)
 {
-    // Regner ut hastigheten p vektoren og normaliserer vektoren 
+    // Regner ut hastigheten på vektoren og normaliserer vektoren 
     float speed = glm::length(velocity);
     glm::vec3 direction = glm::normalize(velocity);
 
@@ -20,25 +20,25 @@ void PhysicsCalculations::applyFriction(glm::vec3& velocity, const glm::vec3& po
     float normalForce = gravity;
     float frictionForce = 0.0f;
 
-    // Ser etter om ballen er innfor omrdet med hyere friksjon
+    // Ser etter om ballen er innfor området med høyere friksjon
     if (position.x >= frictionAreaXMin && position.x <= frictionAreaXMax &&
         position.y >= frictionAreaYMin && position.y <= frictionAreaYMax)
     {
-        // Regner ut friksjonskrafraften i omrdet med hyere friksjon
+        // Regner ut friksjonskrafraften i området med høyere friksjon
         frictionForce = highFriction * normalForce;
     }
     else
     {
-        // Regner ut friksjonskraften i omrdet uten hyere friksjon 
+        // Regner ut friksjonskraften i området uten høyere friksjon 
         frictionForce = normalFriction * normalForce;
     }
 
-    // Regner ut akselerasjonen til ballene, denne er lik friksjonskraften siden massen p ballene er 1
+    // Regner ut akselerasjonen til ballene, denne er lik friksjonskraften siden massen på ballene er 1
     // F/m=a. Regner deretter ut den nye farten til ballene 
     float frictionAcceleration = frictionForce;
     float newSpeed = speed - frictionAcceleration * deltaTime;
 
-    // Oppdaterer bde retningen og hastigheten p ballene
+    // Oppdaterer både retningen og hastigheten på ballene
     velocity = direction * newSpeed;
 }
 
@@ -57,7 +57,7 @@ void PhysicsCalculations::whenCollisionHappens(glm::vec3& p1, glm::vec3& v1, glm
 
     glm::vec3 normal = glm::normalize(p1 - p2);
 
-    // Separasjon for  unng overlapping
+    // Separasjon for å unngå overlapping
     float overlap = radius * 2.0f - glm::length(p1 - p2);
     if (overlap > 0.0f)
     {
@@ -85,7 +85,7 @@ void PhysicsCalculations::whenCollisionHappens(glm::vec3& p1, glm::vec3& v1, glm
     v1 += impulse / m1;
     v2 -= impulse / m2;
 
-    // Begrens hastigheten for  unng undvendig akselerasjon
+    // Begrens hastigheten for å unngå unødvendig akselerasjon
     float maxSpeed = 2.0f;
     v1 = glm::normalize(v1) * glm::min(glm::length(v1), maxSpeed);
     v2 = glm::normalize(v2) * glm::min(glm::length(v2), maxSpeed);
@@ -102,6 +102,7 @@ void PhysicsCalculations::updatePhysics(vector<glm::vec3>& ballPositions, vector
         return;
 
     octree = Octree(glm::vec3(xMin, yMin, xMin), glm::vec3(xMax, yMax, xMax), 0, 4, 4);
+    knotSpanHints.resize(ballPositions.size(), glm::ivec2(-1));
 
     for (int i = 0; i < ballPositions.size(); ++i) 
     {
@@ -120,7 +121,7 @@ void PhysicsCalculations::updatePhysics(vector<glm::vec3>& ballPositions, vector
 
         float u = (ballPositions[i].x - xMin) / (xMax - xMin);
         float v = (ballPositions[i].y - yMin) / (yMax - yMin);
-        glm::vec3 surfacePoint = surface.calculateSurfacePoint(u, v);
+        glm::vec3 surfacePoint = surface.calculateSurfacePoint(u, v, knotSpanHints[i].x, knotSpanHints[i].y);
         ballPositions[i].z = surfacePoint.z + ballRadius;
 
         if (ballTrack[i].empty() || glm::distance(ballPositions[i], ballTrack[i].back()) > 0.01f) 
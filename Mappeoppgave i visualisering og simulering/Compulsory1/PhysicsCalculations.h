@@ -11,17 +11,17 @@ class PhysicsCalculations
 public:
     PhysicsCalculations(float xMin, float xMax, float yMin, float yMax, float ballRadius);
 
-    //Regner ut friksjonen i et omrde p B-spline flaten 
+    //Regner ut friksjonen i et område på B-spline flaten 
     void applyFriction(glm::vec3& velocity, const glm::vec3& position, float deltaTime, float normalFriction, float highFriction,
         float frictionAreaXMin, float frictionAreaXMax, float frictionAreaYMin, float frictionAreaYMax);
 
     //Reger ut om 2 baller kolliderer. 
     bool checkCollision(glm::vec3 posA, glm::vec3 posB, float radiusA, float radiusB);
 
-    //Renger ut posiajoner og hastigheter nr en elastisk kollisjon skjer mellom 2 baller 
+    //Renger ut posiajoner og hastigheter når en elastisk kollisjon skjer mellom 2 baller 
     void whenCollisionHappens(glm::vec3& p1, glm::vec3& v1, glm::vec3& p2, glm::vec3& v2, float radius, float ballSpeed);
 
-    //Regner ut og oppdaterer hastigheten og posisjonen til ballene, Holder ballene innenfor B-spline flaten, tar inn friksjonen, undersker 
+    //Regner ut og oppdaterer hastigheten og posisjonen til ballene, Holder ballene innenfor B-spline flaten, tar inn friksjonen, undersøker 
     //kollisjon mellom ballene og oppadaterer ballens spor. 
     void updatePhysics(vector<glm::vec3>& ballPositions, vector<glm::vec3>& ballVelocities,
         vector<vector<glm::vec3>>& ballTrack, Octree& octree, bool ballsMoving,
@@ -30,12 +30,15 @@ public:
         float frictionAreaXMin, float frictionAreaXMax, float frictionAreaYMin, float frictionAreaYMax);
 
 private:
-    //B-spline flaten sine grenser og ballens strrelse 
+    //B-spline flaten sine grenser og ballens størrelse 
     float xMin;
     float xMax;
     float yMin;
     float yMax;
     float ballRadius;
+    //Intervallene i skjøtvektorene der hver ball sist var. En ball flytter seg lite per steg, så den ligger som
+    //regel i samme intervall neste gang (se Surface::calculateSurfacePoint). 
+    vector<glm::ivec2> knotSpanHints;
 };
 
 #endif
@@ -0,0 +1,92 @@
+#ifndef POINTCLOUD_H
+#define POINTCLOUD_H
+
+#include <vector>
+#include <memory>
+#include <glm/glm.hpp>
+#include "MappedFile.h"
+
+using namespace std;
+
+//Punktsky lagret kolonnevis, en tabell for x, en for y og en for z.
+//Kolonnene ligger enten i egne vektorer, eller peker rett inn i en minnemappet fil (se PointCloudCache).
+//Når de peker inn i en fil holder punktskyen filen åpen så lenge den selv finnes.
+class PointCloud
+{
+public:
+    PointCloud() : mapped(false), count(0), mappedX(nullptr), mappedY(nullptr), mappedZ(nullptr),
+        minBounds(0.0f), maxBounds(0.0f) {}
+
+    //Lager plass til count punkter i egne vektorer
+    void resize(size_t newCount)
+    {
+        mapped = false;
+        mappedFile.reset();
+        ownedX.resize(newCount);
+        ownedY.resize(newCount);
+        ownedZ.resize(newCount);
+        count = newCount;
+    }
+
+    //Lar kolonnene peke rett inn i en minnemappet fil. Ingenting blir kopiert.
+    void setMapped(shared_ptr<MappedFile> file, const float* x, const float* y, const float* z, size_t newCount)
+    {
+        ownedX.clear();
+        ownedY.clear();
+        ownedZ.clear();
+        mapped = true;
+        mappedFile = file;
+        mappedX = x;
+        mappedY = y;
+        mappedZ = z;
+        count = newCount;
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    bool isMapped() const { return mapped; }
+
+    const float* x() const { return mapped ? mappedX : ownedX.data(); }
+    const float* y() const { return mapped ? mappedY : ownedY.data(); }
+    const float* z() const { return mapped ? mappedZ : ownedZ.data(); }
+
+    //Skrivbare kolonner, kun for punktskyer som eier sine egne vektorer
+    float* writableX() { return ownedX.data(); }
+    float* writableY() { return ownedY.data(); }
+    float* writableZ() { return ownedZ.data(); }
+
+    glm::vec3 operator[](size_t i) const { return glm::vec3(x()[i], y()[i], z()[i]); }
+
+    //Regner ut minBounds og maxBounds på nytt fra punktene
+    void computeBounds()
+    {
+        if (count == 0)
+        {
+            minBounds = maxBounds = glm::vec3(0.0f);
+            return;
+        }
+        minBounds = maxBounds = (*this)[0];
+        for (size_t i = 1; i < count; ++i)
+        {
+            glm::vec3 point = (*this)[i];
+            minBounds = glm::min(minBounds, point);
+            maxBounds = glm::max(maxBounds, point);
+        }
+    }
+
+private:
+    bool mapped;
+    size_t count;
+    vector<float> ownedX, ownedY, ownedZ;
+    shared_ptr<MappedFile> mappedFile;
+    const float* mappedX;
+    const float* mappedY;
+    const float* mappedZ;
+
+public:
+    //Den minste boksen som inneholder alle punktene
+    glm::vec3 minBounds;
+    glm::vec3 maxBounds;
+};
+
+#endif
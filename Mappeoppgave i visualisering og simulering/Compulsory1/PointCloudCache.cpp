@@ -0,0 +1,178 @@
+#include "PointCloudCache.h"
+#include "MappedFile.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+
+static const char cacheMagic[8] = { 'P', 'C', 'C', 'A', 'C', 'H', 'E', '\0' };
+
+//Kolonnene starter på en 64 byte grense slik at de ligger fint i cache-linjene
+static const uint64_t columnAlignment = 64;
+
+//Referanse http://www.isthe.com/chongo/tech/comp/fnv/index.html
+uint64_t PointCloudCache::hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+static uint64_t alignUp(uint64_t value)
+{
+    return (value + columnAlignment - 1) / columnAlignment * columnAlignment;
+}
+
+string PointCloudCache::cacheFilename(const string& sourceFilename)
+{
+    return sourceFilename + ".pcc";
+}
+
+uint64_t PointCloudCache::fingerprintFile(const string& filename)
+{
+    error_code error;
+    uint64_t size = filesystem::file_size(filename, error);
+    if (error)
+    {
+        return 0;
+    }
+    auto modified = filesystem::last_write_time(filename, error).time_since_epoch().count();
+
+    uint64_t hash = hashSeed;
+    hash = hashBytes(hash, &size, sizeof(size));
+    hash = hashBytes(hash, &modified, sizeof(modified));
+
+    MappedFile file;
+    if (file.open(filename) && file.size() > 0)
+    {
+        const size_t blockSize = 4096;
+        const size_t blockCount = 16;
+        for (size_t i = 0; i < blockCount; ++i)
+        {
+            size_t start = file.size() > blockSize ? (file.size() - blockSize) * i / (blockCount - 1) : 0;
+            size_t length = min(blockSize, file.size() - start);
+            hash = hashBytes(hash, file.data() + start, length);
+        }
+    }
+    return hash;
+}
+
+bool PointCloudCache::load(const string& sourceFilename, const PointTransform& transform, PointCloud& cloud)
+{
+    auto startTime = chrono::steady_clock::now();
+
+    auto file = make_shared<MappedFile>();
+    if (!file->open(cacheFilename(sourceFilename)) || file->size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, file->data(), sizeof(Header));
+
+    //En cache uten punkter kan bare komme fra en fil som ikke ble lest, så den leses inn på nytt
+    if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != formatVersion ||
+        header.headerSize != sizeof(Header) || header.pointCount == 0)
+    {
+        return false;
+    }
+
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (header.scale[axis] != transform.scale[axis] || header.offset[axis] != transform.offset[axis])
+        {
+            return false;
+        }
+        uint64_t columnEnd = header.columnOffsets[axis] + header.pointCount * sizeof(float);
+        if (header.columnOffsets[axis] % sizeof(float) != 0 || columnEnd > file->size())
+        {
+            return false;
+        }
+    }
+
+    if (header.sourceFingerprint != fingerprintFile(sourceFilename))
+    {
+        cout << "Cachen for " << sourceFilename << " er utdatert og blir laget på nytt" << endl;
+        return false;
+    }
+
+    const float* x = reinterpret_cast<const float*>(file->data() + header.columnOffsets[0]);
+    const float* y = reinterpret_cast<const float*>(file->data() + header.columnOffsets[1]);
+    const float* z = reinterpret_cast<const float*>(file->data() + header.columnOffsets[2]);
+    cloud.setMapped(file, x, y, z, static_cast<size_t>(header.pointCount));
+    cloud.minBounds = glm::vec3(header.minBounds[0], header.minBounds[1], header.minBounds[2]);
+    cloud.maxBounds = glm::vec3(header.maxBounds[0], header.maxBounds[1], header.maxBounds[2]);
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << "Lastet " << cloud.size() << " punkter fra " << cacheFilename(sourceFilename)
+        << " på " << seconds * 1000.0 << " ms" << endl;
+    return true;
+}
+
+bool PointCloudCache::save(const string& sourceFilename, const PointTransform& transform, const PointCloud& cloud)
+{
+    Header header = {};
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = formatVersion;
+    header.headerSize = sizeof(Header);
+    header.pointCount = cloud.size();
+    header.sourceFingerprint = fingerprintFile(sourceFilename);
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.scale[axis] = transform.scale[axis];
+        header.offset[axis] = transform.offset[axis];
+        header.minBounds[axis] = cloud.minBounds[axis];
+        header.maxBounds[axis] = cloud.maxBounds[axis];
+    }
+
+    uint64_t columnBytes = header.pointCount * sizeof(float);
+    header.columnOffsets[0] = alignUp(sizeof(Header));
+    header.columnOffsets[1] = alignUp(header.columnOffsets[0] + columnBytes);
+    header.columnOffsets[2] = alignUp(header.columnOffsets[1] + columnBytes);
+
+    string finalName = cacheFilename(sourceFilename);
+    string temporaryName = finalName + ".tmp";
+    {
+        ofstream outFile(temporaryName, ios::binary | ios::trunc);
+        if (!outFile.is_open())
+        {
+            return false;
+        }
+
+        const char padding[columnAlignment] = {};
+        outFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        uint64_t written = sizeof(Header);
+
+        const float* columns[3] = { cloud.x(), cloud.y(), cloud.z() };
+        for (int axis = 0; axis < 3; ++axis)
+        {
+            outFile.write(padding, static_cast<streamsize>(header.columnOffsets[axis] - written));
+            outFile.write(reinterpret_cast<const char*>(columns[axis]), static_cast<streamsize>(columnBytes));
+            written = header.columnOffsets[axis] + columnBytes;
+        }
+
+        if (!outFile.good())
+        {
+            outFile.close();
+            error_code error;
+            filesystem::remove(temporaryName, error);
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporaryName, finalName, error);
+    if (error)
+    {
+        filesystem::remove(temporaryName, error);
+        return false;
+    }
+
+    cout << "Skrev cache for " << sourceFilename << " til " << finalName << endl;
+    return true;
+}
@@ -0,0 +1,54 @@
+#ifndef POINTCLOUDCACHE_H
+#define POINTCLOUDCACHE_H
+
+#include <string>
+#include <cstdint>
+#include "PointCloud.h"
+#include "PointCloudLoader.h"
+
+using namespace std;
+
+//Binær mellomlagring (cache) av en innlest punktsky. Filen ligger ved siden av kildefilen med endelsen ".pcc"
+//og inneholder kolonnene x, y og z med skalering og forskyvning allerede brukt, boksen rundt punktene
+//og et fingeravtrykk av kildefilen. Ved neste oppstart minnemappes filen og kolonnene brukes direkte.
+class PointCloudCache
+{
+public:
+    //Økes hver gang filformatet endres, slik at gamle filer blir lest inn på nytt
+    static const uint32_t formatVersion = 1;
+
+    static string cacheFilename(const string& sourceFilename);
+
+    //Åpner cachen for kildefilen. Returnerer false hvis cachen mangler, har feil versjon, ble laget
+    //med en annen transformasjon eller hvis kildefilen har endret seg siden cachen ble skrevet.
+    static bool load(const string& sourceFilename, const PointTransform& transform, PointCloud& cloud);
+
+    //Skriver punktskyen til cachen for kildefilen. Filen skrives først til en midlertidig fil og
+    //flyttes på plass til slutt, slik at en avbrutt skriving aldri etterlater en halvferdig cache.
+    static bool save(const string& sourceFilename, const PointTransform& transform, const PointCloud& cloud);
+
+    //Fingeravtrykk av en fil laget av størrelsen, tidspunktet filen sist ble endret og en FNV-1a hash
+    //av 16 blokker spredt utover filen. Dette går raskt også for store filer siden hele filen ikke leses.
+    static uint64_t fingerprintFile(const string& filename);
+
+    //FNV-1a hash av size bytes fra data, videre fra hash. Start med hashSeed.
+    static const uint64_t hashSeed = 14695981039346656037ULL;
+    static uint64_t hashBytes(uint64_t hash, const void* data, size_t size);
+
+private:
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t pointCount;
+        uint64_t sourceFingerprint;
+        double scale[3];
+        double offset[3];
+        float minBounds[3];
+        float maxBounds[3];
+        uint64_t columnOffsets[3];
+    };
+};
+
+#endif
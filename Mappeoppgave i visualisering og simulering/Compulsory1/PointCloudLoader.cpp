@@ -0,0 +1,433 @@
+#include "PointCloudLoader.h"
+#include "MappedFile.h"
+#include "Parallel.h"
+#include <iostream>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <fstream>
+
+//Tierpotenser som kan representeres eksakt som double. Brukes for å slippe pow() for vanlige desimaltall.
+static const double exactPowersOfTen[] =
+{
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static inline bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == ',';
+}
+
+static inline bool isDigit(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+//Referanse https://lemire.me/blog/2020/03/10/fast-float-parsing-in-practice/
+const char* PointCloudLoader::parseNumber(const char* p, const char* end, double& value)
+{
+    bool negative = false;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        ++p;
+    }
+
+    //Samler opp til 19 sifre i et heltall, flere sifre enn det påvirker ikke en double
+    unsigned long long mantissa = 0;
+    int digits = 0;
+    int exponent = 0;
+    bool anyDigits = false;
+
+    while (p < end && isDigit(*p))
+    {
+        if (digits < 19)
+        {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa != 0) ++digits;
+        }
+        else
+        {
+            ++exponent;
+        }
+        anyDigits = true;
+        ++p;
+    }
+
+    if (p < end && *p == '.')
+    {
+        ++p;
+        while (p < end && isDigit(*p))
+        {
+            if (digits < 19)
+            {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa != 0) ++digits;
+                --exponent;
+            }
+            anyDigits = true;
+            ++p;
+        }
+    }
+
+    if (!anyDigits)
+    {
+        return nullptr;
+    }
+
+    if (p < end && (*p == 'e' || *p == 'E'))
+    {
+        const char* exponentStart = p + 1;
+        bool negativeExponent = false;
+        if (exponentStart < end && (*exponentStart == '-' || *exponentStart == '+'))
+        {
+            negativeExponent = *exponentStart == '-';
+            ++exponentStart;
+        }
+        if (exponentStart < end && isDigit(*exponentStart))
+        {
+            int explicitExponent = 0;
+            p = exponentStart;
+            while (p < end && isDigit(*p))
+            {
+                if (explicitExponent < 10000) explicitExponent = explicitExponent * 10 + (*p - '0');
+                ++p;
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+        }
+    }
+
+    double result = static_cast<double>(mantissa);
+    if (exponent != 0 && mantissa != 0)
+    {
+        if (exponent < 0 && exponent >= -22)
+        {
+            result /= exactPowersOfTen[-exponent];
+        }
+        else if (exponent > 0 && exponent <= 22)
+        {
+            result *= exactPowersOfTen[exponent];
+        }
+        else
+        {
+            result *= pow(10.0, exponent);
+        }
+    }
+
+    value = negative ? -result : result;
+    return p;
+}
+
+vector<const char*> PointCloudLoader::splitAtLines(const char* begin, const char* end, unsigned int chunkCount)
+{
+    vector<const char*> starts;
+    size_t size = static_cast<size_t>(end - begin);
+    starts.push_back(begin);
+
+    for (unsigned int i = 1; i < chunkCount; ++i)
+    {
+        const char* candidate = begin + size * i / chunkCount;
+        if (candidate <= starts.back())
+        {
+            continue;
+        }
+        const char* newline = static_cast<const char*>(memchr(candidate - 1, '\n', end - candidate + 1));
+        if (newline == nullptr || newline + 1 >= end)
+        {
+            break;
+        }
+        if (newline + 1 > starts.back())
+        {
+            starts.push_back(newline + 1);
+        }
+    }
+
+    starts.push_back(end);
+    return starts;
+}
+
+size_t PointCloudLoader::countLines(const char* begin, const char* end)
+{
+    size_t lines = 0;
+    bool hasContent = false;
+
+    for (const char* p = begin; p < end; ++p)
+    {
+        char c = *p;
+        if (c == '\n')
+        {
+            lines += hasContent;
+            hasContent = false;
+        }
+        else if (!isSpace(c))
+        {
+            hasContent = true;
+        }
+    }
+    return lines + hasContent;
+}
+
+size_t PointCloudLoader::parseLines(const char* begin, const char* end, const PointTransform& transform,
+    float* x, float* y, float* z, glm::vec3& minBounds, glm::vec3& maxBounds)
+{
+    size_t count = 0;
+    const char* p = begin;
+
+    while (p < end)
+    {
+        while (p < end && (isSpace(*p) || *p == '\n')) ++p;
+        if (p >= end)
+        {
+            break;
+        }
+
+        double coordinates[3];
+        bool valid = true;
+        for (int axis = 0; axis < 3 && valid; ++axis)
+        {
+            while (p < end && isSpace(*p)) ++p;
+            const char* next = parseNumber(p, end, coordinates[axis]);
+            if (next == nullptr)
+            {
+                valid = false;
+            }
+            else
+            {
+                p = next;
+            }
+        }
+
+        if (valid)
+        {
+            glm::vec3 point = transform.apply(coordinates[0], coordinates[1], coordinates[2]);
+            x[count] = point.x;
+            y[count] = point.y;
+            z[count] = point.z;
+            minBounds = glm::min(minBounds, point);
+            maxBounds = glm::max(maxBounds, point);
+            ++count;
+        }
+
+        //Hopper over resten av linjen, f.eks ekstra kolonner eller en linje som ikke kunne leses
+        const char* newline = static_cast<const char*>(memchr(p, '\n', end - p));
+        p = newline == nullptr ? end : newline + 1;
+    }
+    return count;
+}
+
+unsigned int PointCloudLoader::parseBlock(const char* begin, const char* end, const PointTransform& transform,
+    PointCloud& points, unsigned int threadCount)
+{
+    vector<const char*> chunkStarts = splitAtLines(begin, end, threadCount);
+    size_t chunkCount = chunkStarts.size() - 1;
+
+    //Teller først linjene i hver bit slik at alle trådene vet hvor i kolonnene de skal skrive
+    vector<size_t> chunkOffsets(chunkCount + 1, 0);
+    parallelFor(chunkCount, threadCount, [&](size_t first, size_t last, unsigned int)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            chunkOffsets[c + 1] = countLines(chunkStarts[c], chunkStarts[c + 1]);
+        }
+    });
+    for (size_t c = 0; c < chunkCount; ++c)
+    {
+        chunkOffsets[c + 1] += chunkOffsets[c];
+    }
+
+    points.resize(chunkOffsets[chunkCount]);
+
+    vector<size_t> chunkParsed(chunkCount, 0);
+    vector<glm::vec3> chunkMin(chunkCount, glm::vec3(numeric_limits<float>::max()));
+    vector<glm::vec3> chunkMax(chunkCount, glm::vec3(-numeric_limits<float>::max()));
+    float* x = points.writableX();
+    float* y = points.writableY();
+    float* z = points.writableZ();
+    parallelFor(chunkCount, threadCount, [&](size_t first, size_t last, unsigned int)
+    {
+        for (size_t c = first; c < last; ++c)
+        {
+            size_t offset = chunkOffsets[c];
+            chunkParsed[c] = parseLines(chunkStarts[c], chunkStarts[c + 1], transform,
+                x + offset, y + offset, z + offset, chunkMin[c], chunkMax[c]);
+        }
+    });
+
+    //Linjer som ikke kunne leses etterlater hull, disse fjernes ved å flytte punktene sammen
+    size_t written = chunkParsed.empty() ? 0 : chunkParsed[0];
+    for (size_t c = 1; c < chunkCount; ++c)
+    {
+        if (written != chunkOffsets[c])
+        {
+            memmove(x + written, x + chunkOffsets[c], chunkParsed[c] * sizeof(float));
+            memmove(y + written, y + chunkOffsets[c], chunkParsed[c] * sizeof(float));
+            memmove(z + written, z + chunkOffsets[c], chunkParsed[c] * sizeof(float));
+        }
+        written += chunkParsed[c];
+    }
+    points.resize(written);
+
+    points.minBounds = glm::vec3(numeric_limits<float>::max());
+    points.maxBounds = glm::vec3(-numeric_limits<float>::max());
+    for (size_t c = 0; c < chunkCount; ++c)
+    {
+        if (chunkParsed[c] > 0)
+        {
+            points.minBounds = glm::min(points.minBounds, chunkMin[c]);
+            points.maxBounds = glm::max(points.maxBounds, chunkMax[c]);
+        }
+    }
+    if (points.empty())
+    {
+        points.minBounds = points.maxBounds = glm::vec3(0.0f);
+    }
+    return static_cast<unsigned int>(chunkCount);
+}
+
+const char* PointCloudLoader::skipHeaderLine(const char* begin, const char* end, double& headerCount)
+{
+    const char* p = begin;
+    while (p < end && (isSpace(*p) || *p == '\n')) ++p;
+    if (parseNumber(p, end, headerCount) == nullptr)
+    {
+        headerCount = -1.0;
+    }
+    const char* firstLineEnd = static_cast<const char*>(memchr(begin, '\n', end - begin));
+    return firstLineEnd == nullptr ? end : firstLineEnd + 1;
+}
+
+static void printStatistics(const string& filename, const LoadStatistics& result)
+{
+    cout << "Leste " << result.pointCount << " punkter fra " << filename << " ("
+        << result.bytes / (1024.0 * 1024.0) << " MB) på " << result.seconds * 1000.0 << " ms, "
+        << result.megabytesPerSecond() << " MB/s med " << result.threads << " tråder" << endl;
+}
+
+PointCloud PointCloudLoader::loadTextFile(const string& filename, const PointTransform& transform, LoadStatistics* statistics,
+    unsigned int threadCount)
+{
+    auto startTime = chrono::steady_clock::now();
+    PointCloud points;
+
+    MappedFile file;
+    if (!file.open(filename))
+    {
+        cout << "Kunne ikke åpne punktskyfilen: " << filename << endl;
+        return points;
+    }
+
+    const char* begin = file.data();
+    const char* end = begin + file.size();
+    if (begin == nullptr)
+    {
+        return points;
+    }
+
+    //Første linje inneholder antall punkter
+    double headerCount = 0.0;
+    const char* dataBegin = skipHeaderLine(begin, end, headerCount);
+
+    unsigned int threadsUsed = parseBlock(dataBegin, end, transform, points, threadCount == 0 ? workerCount() : threadCount);
+
+    if (headerCount >= 0.0 && static_cast<size_t>(headerCount) != points.size())
+    {
+        cout << "Advarsel: " << filename << " oppgir " << static_cast<size_t>(headerCount)
+            << " punkter, men " << points.size() << " ble lest" << endl;
+    }
+
+    LoadStatistics result;
+    result.pointCount = points.size();
+    result.bytes = file.size();
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    result.threads = threadsUsed;
+    printStatistics(filename, result);
+
+    if (statistics != nullptr)
+    {
+        *statistics = result;
+    }
+    return points;
+}
+
+bool PointCloudLoader::streamTextFile(const string& filename, const PointTransform& transform, size_t blockBytes,
+    const function<void(const PointCloud&)>& consumer, LoadStatistics* statistics)
+{
+    auto startTime = chrono::steady_clock::now();
+
+    ifstream inFile(filename, ios::binary);
+    if (!inFile.is_open())
+    {
+        cout << "Kunne ikke åpne punktskyfilen: " << filename << endl;
+        return false;
+    }
+
+    unsigned int threadCount = workerCount();
+    vector<char> buffer(max<size_t>(blockBytes, 1024));
+    size_t carried = 0;
+    bool firstBlock = true;
+    bool endOfFile = false;
+    PointCloud chunk;
+    LoadStatistics result;
+
+    while (!endOfFile)
+    {
+        inFile.read(buffer.data() + carried, static_cast<streamsize>(buffer.size() - carried));
+        size_t filled = carried + static_cast<size_t>(inFile.gcount());
+        result.bytes += static_cast<size_t>(inFile.gcount());
+        endOfFile = !inFile;
+
+        const char* begin = buffer.data();
+        const char* end = begin + filled;
+
+        //Bare hele linjer leses, resten av den siste linjen tas med til neste blokk
+        const char* parseEnd = end;
+        if (!endOfFile)
+        {
+            const char* lastNewline = nullptr;
+            for (const char* p = end; p > begin; --p)
+            {
+                if (p[-1] == '\n')
+                {
+                    lastNewline = p - 1;
+                    break;
+                }
+            }
+            if (lastNewline == nullptr)
+            {
+                //En linje er lengre enn hele bufferet, gjør bufferet større og les videre
+                carried = filled;
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+            parseEnd = lastNewline + 1;
+        }
+
+        if (firstBlock)
+        {
+            double headerCount = 0.0;
+            begin = skipHeaderLine(begin, parseEnd, headerCount);
+            firstBlock = false;
+        }
+
+        result.threads = max(result.threads, parseBlock(begin, parseEnd, transform, chunk, threadCount));
+        if (!chunk.empty())
+        {
+            result.pointCount += chunk.size();
+            consumer(chunk);
+        }
+
+        carried = static_cast<size_t>(end - parseEnd);
+        memmove(buffer.data(), parseEnd, carried);
+    }
+
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    printStatistics(filename, result);
+
+    if (statistics != nullptr)
+    {
+        *statistics = result;
+    }
+    return true;
+}
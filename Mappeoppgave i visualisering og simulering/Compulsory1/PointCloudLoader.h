@@ -0,0 +1,72 @@
+#ifndef POINTCLOUDLOADER_H
+#define POINTCLOUDLOADER_H
+
+#include <string>
+#include <vector>
+#include <functional>
+#include <glm/glm.hpp>
+#include "PointCloud.h"
+
+using namespace std;
+
+//Skaleringen og forskyvningen som gjør om koordinatene i punktskyfilene til koordinatene i scenen
+struct PointTransform
+{
+    glm::dvec3 scale;
+    glm::dvec3 offset;
+
+    glm::vec3 apply(double x, double y, double z) const
+    {
+        return glm::vec3(x * scale.x + offset.x, y * scale.y + offset.y, z * scale.z + offset.z);
+    }
+};
+
+//Tid og datamengde for siste innlesing, brukes til å følge med på hvor raskt filene leses
+struct LoadStatistics
+{
+    size_t pointCount = 0;
+    size_t bytes = 0;
+    double seconds = 0.0;
+    unsigned int threads = 0;
+
+    double megabytesPerSecond() const { return seconds > 0.0 ? bytes / (1024.0 * 1024.0) / seconds : 0.0; }
+};
+
+class PointCloudLoader
+{
+public:
+    //Laster punktene fra en tekstfil der første linje er antall punkter og resten er "x y z" per linje.
+    //Filen minnemappes og deles i biter ved linjeskift, en bit per tråd. Hver tråd leser tallene sine
+    //rett inn i ferdig allokerte kolonner og bruker transformasjonen i samme omgang.
+    //threadCount 0 betyr én tråd per kjerne. Når flere filer leses samtidig brukes én tråd per fil.
+    static PointCloud loadTextFile(const string& filename, const PointTransform& transform, LoadStatistics* statistics = nullptr,
+        unsigned int threadCount = 0);
+
+    //Leser en tekstfil i blokker på blockBytes bytes i stedet for å mappe hele filen. Hver blokk leses på samme
+    //måte som i loadTextFile og sendes til consumer før neste blokk leses. Punktskyen som sendes til
+    //consumer brukes om igjen for neste blokk, så minnebruken avhenger bare av blokkstørrelsen.
+    static bool streamTextFile(const string& filename, const PointTransform& transform, size_t blockBytes,
+        const function<void(const PointCloud&)>& consumer, LoadStatistics* statistics = nullptr);
+
+    //Leser et desimaltall uten å gå via locale. Håndterer fortegn, desimaler og eksponent (f.eks 1.5e3).
+    //Returnerer pekeren etter tallet, eller nullptr hvis det ikke står et tall ved p.
+    static const char* parseNumber(const char* p, const char* end, double& value);
+
+private:
+    //Deler teksten mellom begin og end i biter og leser dem parallelt inn i points. Returnerer antall biter.
+    static unsigned int parseBlock(const char* begin, const char* end, const PointTransform& transform,
+        PointCloud& points, unsigned int threadCount);
+    //Leser antall punkter på første linje og returnerer starten på linjen etter. headerCount blir -1 hvis
+    //første linje ikke er et tall.
+    static const char* skipHeaderLine(const char* begin, const char* end, double& headerCount);
+    //Finner starten på bitene filen deles i. Hver bit starter rett etter et linjeskift.
+    static vector<const char*> splitAtLines(const char* begin, const char* end, unsigned int chunkCount);
+    //Teller linjer som inneholder noe annet enn mellomrom
+    static size_t countLines(const char* begin, const char* end);
+    //Leser alle linjene i en bit inn i kolonnene x, y og z og utvider boksen minBounds/maxBounds.
+    //Returnerer antall punkter som ble lest.
+    static size_t parseLines(const char* begin, const char* end, const PointTransform& transform,
+        float* x, float* y, float* z, glm::vec3& minBounds, glm::vec3& maxBounds);
+};
+
+#endif
@@ -0,0 +1,232 @@
+#include "PointNormals.h"
+#include "Parallel.h"
+#include <cmath>
+#include <algorithm>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define POINTNORMALS_SSE2
+#endif
+
+//Summene som trengs til kovariansen, for punktene flyttet slik at center ligger i origo
+struct MomentSums
+{
+    float x, y, z;
+    float xx, xy, xz, yy, yz, zz;
+};
+
+//Naboene lagres som x, y og z i hver sin tabell (SoA), så fire naboer lastes med én instruksjon.
+//Punktene er flyttet til center før de lagres, så summene i float ikke mister presisjon når koordinatene er store.
+static MomentSums sumMoments(const float* x, const float* y, const float* z, size_t count)
+{
+    MomentSums sums = {};
+    size_t i = 0;
+
+#ifdef POINTNORMALS_SSE2
+    if (count >= 4)
+    {
+        __m128 sx = _mm_setzero_ps(), sy = _mm_setzero_ps(), sz = _mm_setzero_ps();
+        __m128 sxx = _mm_setzero_ps(), sxy = _mm_setzero_ps(), sxz = _mm_setzero_ps();
+        __m128 syy = _mm_setzero_ps(), syz = _mm_setzero_ps(), szz = _mm_setzero_ps();
+        for (; i + 4 <= count; i += 4)
+        {
+            __m128 vx = _mm_loadu_ps(x + i);
+            __m128 vy = _mm_loadu_ps(y + i);
+            __m128 vz = _mm_loadu_ps(z + i);
+            sx = _mm_add_ps(sx, vx);
+            sy = _mm_add_ps(sy, vy);
+            sz = _mm_add_ps(sz, vz);
+            sxx = _mm_add_ps(sxx, _mm_mul_ps(vx, vx));
+            sxy = _mm_add_ps(sxy, _mm_mul_ps(vx, vy));
+            sxz = _mm_add_ps(sxz, _mm_mul_ps(vx, vz));
+            syy = _mm_add_ps(syy, _mm_mul_ps(vy, vy));
+            syz = _mm_add_ps(syz, _mm_mul_ps(vy, vz));
+            szz = _mm_add_ps(szz, _mm_mul_ps(vz, vz));
+        }
+
+        __m128 lanesIn[9] = { sx, sy, sz, sxx, sxy, sxz, syy, syz, szz };
+        float* sumsOut[9] = { &sums.x, &sums.y, &sums.z, &sums.xx, &sums.xy, &sums.xz, &sums.yy, &sums.yz, &sums.zz };
+        for (int s = 0; s < 9; ++s)
+        {
+            float lanes[4];
+            _mm_storeu_ps(lanes, lanesIn[s]);
+            *sumsOut[s] = (lanes[0] + lanes[1]) + (lanes[2] + lanes[3]);
+        }
+    }
+#endif
+
+    for (; i < count; ++i)
+    {
+        sums.x += x[i];
+        sums.y += y[i];
+        sums.z += z[i];
+        sums.xx += x[i] * x[i];
+        sums.xy += x[i] * y[i];
+        sums.xz += x[i] * z[i];
+        sums.yy += y[i] * y[i];
+        sums.yz += y[i] * z[i];
+        sums.zz += z[i] * z[i];
+    }
+    return sums;
+}
+
+//Egenvektoren til den minste egenverdien av den symmetriske matrisen A. Egenverdiene finnes direkte med den
+//trigonometriske løsningen av den kubiske ligningen, og egenvektoren er det lengste kryssproduktet av to rader
+//i A - lambda * I (radene står vinkelrett på egenvektoren).
+//Er de to minste egenverdiene like (naboene ligger på en linje, f.eks en skannelinje), er retningen bare bestemt
+//vinkelrett på linjen, og vektoren i det planet som ligger nærmest up velges.
+//Referanse Smith, "Eigenvalues of a symmetric 3 x 3 matrix" (1961)
+static glm::dvec3 smallestEigenvector(const glm::dmat3& a, const glm::dvec3& up, double& smallest)
+{
+    double offDiagonal = a[0][1] * a[0][1] + a[0][2] * a[0][2] + a[1][2] * a[1][2];
+    double q = (a[0][0] + a[1][1] + a[2][2]) / 3.0;
+    double p2 = (a[0][0] - q) * (a[0][0] - q) + (a[1][1] - q) * (a[1][1] - q) + (a[2][2] - q) * (a[2][2] - q)
+        + 2.0 * offDiagonal;
+    double p = sqrt(p2 / 6.0);
+    smallest = q;
+    if (p <= 1e-12 * fabs(q))
+    {
+        //Like egenverdier i alle retninger, ingen retning er bedre enn en annen
+        return up;
+    }
+
+    glm::dmat3 b = (a - q * glm::dmat3(1.0)) / p;
+    double r = glm::clamp(glm::determinant(b) / 2.0, -1.0, 1.0);
+    double phi = acos(r) / 3.0;
+    smallest = q + 2.0 * p * cos(phi + 2.0 * 3.14159265358979323846 / 3.0);
+
+    glm::dmat3 m = a - smallest * glm::dmat3(1.0);
+    glm::dvec3 rows[3] = { glm::dvec3(m[0][0], m[1][0], m[2][0]), glm::dvec3(m[0][1], m[1][1], m[2][1]),
+        glm::dvec3(m[0][2], m[1][2], m[2][2]) };
+    glm::dvec3 crosses[3] = { glm::cross(rows[0], rows[1]), glm::cross(rows[0], rows[2]), glm::cross(rows[1], rows[2]) };
+    int best = 0;
+    for (int i = 1; i < 3; ++i)
+    {
+        if (glm::dot(crosses[i], crosses[i]) > glm::dot(crosses[best], crosses[best]))
+        {
+            best = i;
+        }
+    }
+
+    double longestRow = 0.0;
+    int row = 0;
+    for (int i = 0; i < 3; ++i)
+    {
+        double length = glm::dot(rows[i], rows[i]);
+        if (length > longestRow)
+        {
+            longestRow = length;
+            row = i;
+        }
+    }
+    if (glm::dot(crosses[best], crosses[best]) > 1e-20 * longestRow * longestRow)
+    {
+        return glm::normalize(crosses[best]);
+    }
+
+    //Radene er parallelle, så egenvektoren kan være hvilken som helst vektor vinkelrett på dem
+    glm::dvec3 direction = rows[row] / sqrt(longestRow);
+    glm::dvec3 normal = up - glm::dot(up, direction) * direction;
+    if (glm::dot(normal, normal) < 1e-12)
+    {
+        normal = glm::cross(direction, fabs(direction.x) < 0.9 ? glm::dvec3(1.0, 0.0, 0.0) : glm::dvec3(0.0, 1.0, 0.0));
+    }
+    return glm::normalize(normal);
+}
+
+static glm::vec3 normalFromMoments(const MomentSums& sums, size_t count, const glm::vec3& up, float* variation)
+{
+    if (variation)
+    {
+        *variation = 0.0f;
+    }
+    if (count < 3)
+    {
+        return up;
+    }
+
+    double n = static_cast<double>(count);
+    glm::dvec3 mean(sums.x / n, sums.y / n, sums.z / n);
+    glm::dmat3 covariance;
+    covariance[0][0] = sums.xx / n - mean.x * mean.x;
+    covariance[1][1] = sums.yy / n - mean.y * mean.y;
+    covariance[2][2] = sums.zz / n - mean.z * mean.z;
+    covariance[0][1] = covariance[1][0] = sums.xy / n - mean.x * mean.y;
+    covariance[0][2] = covariance[2][0] = sums.xz / n - mean.x * mean.z;
+    covariance[1][2] = covariance[2][1] = sums.yz / n - mean.y * mean.z;
+
+    double smallest = 0.0;
+    glm::dvec3 normal = smallestEigenvector(covariance, glm::dvec3(up), smallest);
+    if (glm::dot(normal, glm::dvec3(up)) < 0.0)
+    {
+        normal = -normal;
+    }
+
+    double trace = covariance[0][0] + covariance[1][1] + covariance[2][2];
+    if (variation && trace > 0.0)
+    {
+        *variation = static_cast<float>(glm::clamp(smallest / trace, 0.0, 1.0 / 3.0));
+    }
+    return glm::vec3(normal);
+}
+
+glm::vec3 pcaNormal(const vector<glm::vec3>& neighbours, const glm::vec3& up, float* variation)
+{
+    if (neighbours.empty())
+    {
+        if (variation)
+        {
+            *variation = 0.0f;
+        }
+        return up;
+    }
+
+    glm::vec3 center = neighbours[0];
+    vector<float> x(neighbours.size()), y(neighbours.size()), z(neighbours.size());
+    for (size_t i = 0; i < neighbours.size(); ++i)
+    {
+        x[i] = neighbours[i].x - center.x;
+        y[i] = neighbours[i].y - center.y;
+        z[i] = neighbours[i].z - center.z;
+    }
+    return normalFromMoments(sumMoments(x.data(), y.data(), z.data(), neighbours.size()), neighbours.size(), up,
+        variation);
+}
+
+void estimatePointNormals(const KdTree& tree, size_t neighbourCount, vector<glm::vec3>& normals,
+    vector<float>* variations, const glm::vec3& up, unsigned int threadCount)
+{
+    normals.resize(tree.size());
+    if (variations)
+    {
+        variations->resize(tree.size());
+    }
+
+    parallelFor(tree.size(), threadCount == 0 ? workerCount() : threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        //Tabellene gjenbrukes for alle punktene i biten, så det allokeres bare én gang per tråd
+        vector<KdNeighbour> neighbours;
+        vector<float> x(neighbourCount), y(neighbourCount), z(neighbourCount);
+        for (size_t i = begin; i < end; ++i)
+        {
+            uint32_t index = tree.indexInTreeOrder(i);
+            glm::vec3 center = tree.pointAt(index);
+            tree.nearest(center, neighbourCount, neighbours);
+            for (size_t j = 0; j < neighbours.size(); ++j)
+            {
+                glm::vec3 neighbour = tree.pointAt(neighbours[j].index);
+                x[j] = neighbour.x - center.x;
+                y[j] = neighbour.y - center.y;
+                z[j] = neighbour.z - center.z;
+            }
+
+            float variation;
+            MomentSums sums = sumMoments(x.data(), y.data(), z.data(), neighbours.size());
+            normals[index] = normalFromMoments(sums, neighbours.size(), up, &variation);
+            if (variations)
+            {
+                (*variations)[index] = variation;
+            }
+        }
+    });
+}
@@ -0,0 +1,29 @@
+#ifndef POINTNORMALS_H
+#define POINTNORMALS_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "KdTree.h"
+
+using namespace std;
+
+//Normaler rett fra punktskyen, uten triangulering. Normalen i et punkt er retningen der naboene varierer minst,
+//dvs. egenvektoren til den minste egenverdien i kovariansmatrisen til naboene (PCA, principal component analysis).
+//Egenvektoren har ingen fast retning, så normalen snus slik at den peker samme vei som up.
+//
+//variation er den minste egenverdien delt på summen av egenverdiene: 0 når naboene ligger i et plan og opp mot
+//1/3 når de er spredt likt i alle retninger (vegetasjon, støy). Den kan brukes til å filtrere punktene.
+
+//Normalen til planet som passer best gjennom punktene. Færre enn tre punkter gir up.
+glm::vec3 pcaNormal(const vector<glm::vec3>& neighbours, const glm::vec3& up = glm::vec3(0.0f, 0.0f, 1.0f),
+    float* variation = nullptr);
+
+//Regner ut normalen i hvert punkt i treet fra de neighbourCount nærmeste punktene (punktet selv medregnet).
+//normals[i] og variations[i] hører til punkt i i punktene treet ble bygget av. Punktene deles mellom trådene
+//i rekkefølgen de ligger i treet (KdTree::indexInTreeOrder), og kovariansen summeres med SSE2 fire naboer om
+//gangen. variations kan være nullptr. 0 tråder betyr workerCount().
+void estimatePointNormals(const KdTree& tree, size_t neighbourCount, vector<glm::vec3>& normals,
+    vector<float>* variations = nullptr, const glm::vec3& up = glm::vec3(0.0f, 0.0f, 1.0f),
+    unsigned int threadCount = 0);
+
+#endif
@@ -0,0 +1,402 @@
+#include "Predicates.h"
+#include <atomic>
+#include <algorithm>
+#include <cmath>
+
+//Tellerne for hver tråd legges til totalen når tråden avsluttes
+static atomic<uint64_t> totalOrientCalls(0), totalOrientExact(0);
+static atomic<uint64_t> totalInCircleCalls(0), totalInCircleExact(0), totalSymbolicTies(0);
+
+struct ThreadCounters
+{
+    PredicateStatistics counts;
+
+    ~ThreadCounters()
+    {
+        totalOrientCalls += counts.orientCalls;
+        totalOrientExact += counts.orientExact;
+        totalInCircleCalls += counts.inCircleCalls;
+        totalInCircleExact += counts.inCircleExact;
+        totalSymbolicTies += counts.symbolicTies;
+    }
+};
+
+static thread_local ThreadCounters threadCounters;
+
+//Avrundingsenheten for double (2^-53) og feilgrensene for den raske veien, fra Shewchuk sin artikkel
+static const double epsilon = 1.1102230246251565e-16;
+static const double orientErrorBound = (3.0 + 16.0 * epsilon) * epsilon;
+static const double inCircleErrorBound = (10.0 + 96.0 * epsilon) * epsilon;
+//2^27 + 1, deler en double i to halvdeler med 26 bits hver
+static const double splitter = 134217729.0;
+
+//--- Eksakt aritmetikk. x + y er nøyaktig lik resultatet av operasjonen, x er det avrundede svaret. ---
+
+static inline void fastTwoSum(double a, double b, double& x, double& y)
+{
+    x = a + b;
+    double bVirtual = x - a;
+    y = b - bVirtual;
+}
+
+static inline void twoSum(double a, double b, double& x, double& y)
+{
+    x = a + b;
+    double bVirtual = x - a;
+    double aVirtual = x - bVirtual;
+    double bRoundoff = b - bVirtual;
+    double aRoundoff = a - aVirtual;
+    y = aRoundoff + bRoundoff;
+}
+
+static inline void twoDiff(double a, double b, double& x, double& y)
+{
+    x = a - b;
+    double bVirtual = a - x;
+    double aVirtual = x + bVirtual;
+    double bRoundoff = bVirtual - b;
+    double aRoundoff = a - aVirtual;
+    y = aRoundoff + bRoundoff;
+}
+
+static inline void split(double a, double& high, double& low)
+{
+    double c = splitter * a;
+    double big = c - a;
+    high = c - big;
+    low = a - high;
+}
+
+static inline void twoProduct(double a, double b, double& x, double& y)
+{
+    x = a * b;
+    double aHigh, aLow, bHigh, bLow;
+    split(a, aHigh, aLow);
+    split(b, bHigh, bLow);
+    double error1 = x - (aHigh * bHigh);
+    double error2 = error1 - (aLow * bHigh);
+    double error3 = error2 - (aHigh * bLow);
+    y = (aLow * bLow) - error3;
+}
+
+//En sum av opptil N doubles som ikke overlapper, sortert fra minst til størst. Nuller fjernes underveis,
+//så length er som regel mye mindre enn N. Det siste leddet har samme fortegn som hele summen.
+template <int N>
+struct Expansion
+{
+    double terms[N];
+    int length = 0;
+
+    double sign() const { return terms[length - 1]; }
+};
+
+static Expansion<2> difference(double a, double b)
+{
+    Expansion<2> result;
+    double x, y;
+    twoDiff(a, b, x, y);
+    if (y != 0.0)
+    {
+        result.terms[result.length++] = y;
+    }
+    result.terms[result.length++] = x;
+    return result;
+}
+
+//h = e + f. h må ha plass til elength + flength ledd. Returnerer antall ledd i h.
+static int addExpansions(const double* e, int eLength, const double* f, int fLength, double* h)
+{
+    int ei = 0, fi = 0, hLength = 0;
+    double eNow = e[0], fNow = f[0];
+    auto nextE = [&]() { ++ei; eNow = ei < eLength ? e[ei] : 0.0; };
+    auto nextF = [&]() { ++fi; fNow = fi < fLength ? f[fi] : 0.0; };
+
+    double q, qNew, hh;
+    if ((fNow > eNow) == (fNow > -eNow))
+    {
+        q = eNow;
+        nextE();
+    }
+    else
+    {
+        q = fNow;
+        nextF();
+    }
+
+    if (ei < eLength && fi < fLength)
+    {
+        if ((fNow > eNow) == (fNow > -eNow))
+        {
+            fastTwoSum(eNow, q, qNew, hh);
+            nextE();
+        }
+        else
+        {
+            fastTwoSum(fNow, q, qNew, hh);
+            nextF();
+        }
+        q = qNew;
+        if (hh != 0.0)
+        {
+            h[hLength++] = hh;
+        }
+        while (ei < eLength && fi < fLength)
+        {
+            if ((fNow > eNow) == (fNow > -eNow))
+            {
+                twoSum(q, eNow, qNew, hh);
+                nextE();
+            }
+            else
+            {
+                twoSum(q, fNow, qNew, hh);
+                nextF();
+            }
+            q = qNew;
+            if (hh != 0.0)
+            {
+                h[hLength++] = hh;
+            }
+        }
+    }
+    while (ei < eLength)
+    {
+        twoSum(q, eNow, qNew, hh);
+        nextE();
+        q = qNew;
+        if (hh != 0.0)
+        {
+            h[hLength++] = hh;
+        }
+    }
+    while (fi < fLength)
+    {
+        twoSum(q, fNow, qNew, hh);
+        nextF();
+        q = qNew;
+        if (hh != 0.0)
+        {
+            h[hLength++] = hh;
+        }
+    }
+    if (q != 0.0 || hLength == 0)
+    {
+        h[hLength++] = q;
+    }
+    return hLength;
+}
+
+//h = e * b. h må ha plass til 2 * eLength ledd. Returnerer antall ledd i h.
+static int scaleExpansion(const double* e, int eLength, double b, double* h)
+{
+    int hLength = 0;
+    double q, hh, product1, product0, s;
+    twoProduct(e[0], b, q, hh);
+    if (hh != 0.0)
+    {
+        h[hLength++] = hh;
+    }
+    for (int i = 1; i < eLength; ++i)
+    {
+        twoProduct(e[i], b, product1, product0);
+        twoSum(q, product0, s, hh);
+        if (hh != 0.0)
+        {
+            h[hLength++] = hh;
+        }
+        fastTwoSum(product1, s, q, hh);
+        if (hh != 0.0)
+        {
+            h[hLength++] = hh;
+        }
+    }
+    if (q != 0.0 || hLength == 0)
+    {
+        h[hLength++] = q;
+    }
+    return hLength;
+}
+
+template <int A, int B>
+static Expansion<A + B> sum(const Expansion<A>& e, const Expansion<B>& f)
+{
+    Expansion<A + B> h;
+    h.length = addExpansions(e.terms, e.length, f.terms, f.length, h.terms);
+    return h;
+}
+
+template <int A>
+static Expansion<A> negate(Expansion<A> e)
+{
+    for (int i = 0; i < e.length; ++i)
+    {
+        e.terms[i] = -e.terms[i];
+    }
+    return e;
+}
+
+//e * f, som summen av e ganget med hvert ledd i f
+template <int A, int B>
+static Expansion<2 * A * B> product(const Expansion<A>& e, const Expansion<B>& f)
+{
+    //Summen bygges opp vekselvis i result og buffer, så ingen tabeller kopieres underveis
+    Expansion<2 * A * B> result;
+    double buffer[2 * A * B];
+    double part[2 * A];
+    double* current = (f.length % 2 == 1) ? result.terms : buffer;
+    double* next = (f.length % 2 == 1) ? buffer : result.terms;
+    int length = scaleExpansion(e.terms, e.length, f.terms[0], current);
+    for (int i = 1; i < f.length; ++i)
+    {
+        int partLength = scaleExpansion(e.terms, e.length, f.terms[i], part);
+        length = addExpansions(current, length, part, partLength, next);
+        swap(current, next);
+    }
+    result.length = length;
+    return result;
+}
+
+//--- Orientering ---
+
+static double orient2dExact(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+{
+    Expansion<2> acx = difference(a.x, c.x), acy = difference(a.y, c.y);
+    Expansion<2> bcx = difference(b.x, c.x), bcy = difference(b.y, c.y);
+    return sum(product(acx, bcy), negate(product(acy, bcx))).sign();
+}
+
+double orient2d(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c)
+{
+    ++threadCounters.counts.orientCalls;
+    double left = (a.x - c.x) * (b.y - c.y);
+    double right = (a.y - c.y) * (b.x - c.x);
+    double determinant = left - right;
+    double bound = orientErrorBound * (fabs(left) + fabs(right));
+    if (determinant > bound || -determinant > bound)
+    {
+        return determinant;
+    }
+    ++threadCounters.counts.orientExact;
+    return orient2dExact(a, b, c);
+}
+
+double orient2d(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c)
+{
+    return orient2d(glm::dvec2(a), glm::dvec2(b), glm::dvec2(c));
+}
+
+//--- Punkt i omskreven sirkel ---
+
+static double inCircleExact(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d)
+{
+    Expansion<2> adx = difference(a.x, d.x), ady = difference(a.y, d.y);
+    Expansion<2> bdx = difference(b.x, d.x), bdy = difference(b.y, d.y);
+    Expansion<2> cdx = difference(c.x, d.x), cdy = difference(c.y, d.y);
+
+    Expansion<16> ad = sum(product(adx, adx), product(ady, ady));
+    Expansion<16> bd = sum(product(bdx, bdx), product(bdy, bdy));
+    Expansion<16> cd = sum(product(cdx, cdx), product(cdy, cdy));
+
+    Expansion<128> aTerm = sum(product(bdy, cd), negate(product(cdy, bd)));
+    Expansion<128> bTerm = sum(product(bdx, cd), negate(product(cdx, bd)));
+    Expansion<16> cTerm = sum(product(bdx, cdy), negate(product(bdy, cdx)));
+
+    return sum(sum(product(adx, aTerm), negate(product(ady, bTerm))), product(cTerm, ad)).sign();
+}
+
+double inCircle(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d)
+{
+    ++threadCounters.counts.inCircleCalls;
+    double adx = a.x - d.x, ady = a.y - d.y;
+    double bdx = b.x - d.x, bdy = b.y - d.y;
+    double cdx = c.x - d.x, cdy = c.y - d.y;
+
+    double bdxcdy = bdx * cdy, cdxbdy = cdx * bdy;
+    double cdxady = cdx * ady, adxcdy = adx * cdy;
+    double adxbdy = adx * bdy, bdxady = bdx * ady;
+    double aLift = adx * adx + ady * ady;
+    double bLift = bdx * bdx + bdy * bdy;
+    double cLift = cdx * cdx + cdy * cdy;
+
+    double determinant = aLift * (bdxcdy - cdxbdy) + bLift * (cdxady - adxcdy) + cLift * (adxbdy - bdxady);
+    double permanent = (fabs(bdxcdy) + fabs(cdxbdy)) * aLift + (fabs(cdxady) + fabs(adxcdy)) * bLift +
+        (fabs(adxbdy) + fabs(bdxady)) * cLift;
+    double bound = inCircleErrorBound * permanent;
+    if (determinant > bound || -determinant > bound)
+    {
+        return determinant;
+    }
+    ++threadCounters.counts.inCircleExact;
+    return inCircleExact(a, b, c, d);
+}
+
+double inCircle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& d)
+{
+    return inCircle(glm::dvec2(a), glm::dvec2(b), glm::dvec2(c), glm::dvec2(d));
+}
+
+//Punktene løftes opp på paraboloiden z = x^2 + y^2, og hvert punkt p flyttes i tillegg en forsvinnende liten
+//avstand eps_p oppover. Determinanten endres da med eps_p ganger underdeterminanten til p, som er orienteringen
+//til de tre andre punktene (med fortegn). Det største punktet (x først, så y) flyttes mest, så første
+//underdeterminant som ikke er 0, tatt fra det største punktet og nedover, avgjør fortegnet.
+int inCircleSymbolic(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d)
+{
+    double determinant = inCircle(a, b, c, d);
+    if (determinant != 0.0)
+    {
+        return determinant > 0.0 ? 1 : -1;
+    }
+    ++threadCounters.counts.symbolicTies;
+
+    const glm::dvec2* points[4] = { &a, &b, &c, &d };
+    int order[4] = { 0, 1, 2, 3 };
+    sort(order, order + 4, [&](int i, int j)
+    {
+        const glm::dvec2& p = *points[i];
+        const glm::dvec2& q = *points[j];
+        return p.x != q.x ? p.x > q.x : p.y > q.y;
+    });
+
+    for (int k = 0; k < 4; ++k)
+    {
+        double minor = 0.0;
+        switch (order[k])
+        {
+        case 0: minor = orient2d(b, c, d); break;
+        case 1: minor = -orient2d(a, c, d); break;
+        case 2: minor = orient2d(a, b, d); break;
+        case 3: minor = -orient2d(a, b, c); break;
+        }
+        if (minor != 0.0)
+        {
+            return minor > 0.0 ? 1 : -1;
+        }
+    }
+    return 0;
+}
+
+PredicateStatistics predicateStatistics()
+{
+    PredicateStatistics result = threadCounters.counts;
+    result.orientCalls += totalOrientCalls;
+    result.orientExact += totalOrientExact;
+    result.inCircleCalls += totalInCircleCalls;
+    result.inCircleExact += totalInCircleExact;
+    result.symbolicTies += totalSymbolicTies;
+    return result;
+}
+
+void resetPredicateStatistics()
+{
+    threadCounters.counts = PredicateStatistics();
+    totalOrientCalls = 0;
+    totalOrientExact = 0;
+    totalInCircleCalls = 0;
+    totalInCircleExact = 0;
+    totalSymbolicTies = 0;
+}
+
+void countInCircleCalls(uint64_t calls)
+{
+    threadCounters.counts.inCircleCalls += calls;
+}
@@ -0,0 +1,53 @@
+#ifndef PREDICATES_H
+#define PREDICATES_H
+
+#include <cstdint>
+#include <glm/glm.hpp>
+
+using namespace std;
+
+//Robuste geometriske tester (orientering og punkt i omskreven sirkel) for trianguleringen.
+//Determinanten regnes først ut vanlig i double sammen med en øvre grense for avrundingsfeilen. Bare hvis
+//verdien er mindre enn feilgrensen regnes den ut på nytt eksakt, med flyttallsekspansjoner (summer av
+//doubles som ikke overlapper), så den raske veien koster nesten det samme som en vanlig determinant.
+//Fortegnet er alltid riktig, også for punkter som ligger nøyaktig på en linje eller sirkel.
+//Referanse Shewchuk, "Adaptive Precision Floating-Point Arithmetic and Fast Robust Geometric Predicates" (1997)
+//https://www.cs.cmu.edu/~quake/robust.html
+//
+//Den eksakte veien krever vanlig IEEE avrunding i double, så filen må ikke kompileres med /fp:fast.
+
+//Positiv hvis a, b og c ligger mot klokka, negativ hvis de ligger med klokka og 0 hvis de ligger på en linje
+double orient2d(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c);
+double orient2d(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c);
+
+//Positiv hvis d ligger inne i sirkelen gjennom a, b og c (a, b, c mot klokka), negativ hvis d ligger
+//utenfor og 0 hvis d ligger på sirkelen
+double inCircle(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d);
+double inCircle(const glm::vec2& a, const glm::vec2& b, const glm::vec2& c, const glm::vec2& d);
+
+//Som inCircle, men fire punkter på samme sirkel avgjøres med en tenkt liten forskyvning av punktene
+//(Simulation of Simplicity), der punktet med størst (x, y) flyttes mest. Gir bare 0 når to av punktene er like.
+//Siden avgjørelsen bare avhenger av koordinatene, gir alle trianguleringer av de samme punktene samme svar,
+//f.eks stripene og skjøtene i parallelDelaunayTriangulation.
+//Referanse Edelsbrunner og Mücke, "Simulation of Simplicity" (1990)
+int inCircleSymbolic(const glm::dvec2& a, const glm::dvec2& b, const glm::dvec2& c, const glm::dvec2& d);
+
+struct PredicateStatistics
+{
+    uint64_t orientCalls = 0;
+    uint64_t orientExact = 0;
+    uint64_t inCircleCalls = 0;
+    uint64_t inCircleExact = 0;
+    //Antall inCircleSymbolic som måtte bruke forskyvningen
+    uint64_t symbolicTies = 0;
+};
+
+//Hvor mange ganger testene er kalt og hvor mange ganger den eksakte veien ble brukt. Hver tråd teller for seg
+//og legger tallene til totalen når tråden avsluttes, så tellingen koster ingenting ekstra i de parallelle delene.
+//Resultatet er totalen pluss tallene til tråden som kaller.
+PredicateStatistics predicateStatistics();
+void resetPredicateStatistics();
+//Legger til inCircle tester som er avgjort med den samme raske veien et annet sted (inCircleBatch i InCircleBatch.h)
+void countInCircleCalls(uint64_t calls);
+
+#endif
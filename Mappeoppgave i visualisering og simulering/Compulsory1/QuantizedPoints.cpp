@@ -0,0 +1,50 @@
+#include "QuantizedPoints.h"
+#include <cmath>
+
+void QuantizedPoints::quantize(const vector<glm::vec3>& points)
+{
+    positions.resize(points.size());
+    if (points.empty())
+    {
+        origin = glm::vec3(0.0f);
+        scale = glm::vec3(1.0f);
+        return;
+    }
+
+    glm::vec3 minBounds = points[0];
+    glm::vec3 maxBounds = points[0];
+    for (const auto& point : points)
+    {
+        minBounds = glm::min(minBounds, point);
+        maxBounds = glm::max(maxBounds, point);
+    }
+
+    //En akse der alle punktene har samme verdi får steg 1 så det ikke blir deling på null
+    const float steps = 65535.0f;
+    origin = minBounds;
+    scale = (maxBounds - minBounds) / steps;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        if (scale[axis] <= 0.0f)
+        {
+            scale[axis] = 1.0f;
+        }
+    }
+
+    for (size_t i = 0; i < points.size(); ++i)
+    {
+        positions[i] = encode(points[i]);
+    }
+}
+
+glm::u16vec3 QuantizedPoints::encode(const glm::vec3& point) const
+{
+    glm::vec3 quantized = glm::clamp(glm::round((point - origin) / scale), glm::vec3(0.0f), glm::vec3(65535.0f));
+    return glm::u16vec3(quantized);
+}
+
+bool QuantizedPoints::contains(const glm::vec3& point) const
+{
+    glm::vec3 steps = glm::round((point - origin) / scale);
+    return glm::all(glm::greaterThanEqual(steps, glm::vec3(0.0f))) && glm::all(glm::lessThanEqual(steps, glm::vec3(65535.0f)));
+}
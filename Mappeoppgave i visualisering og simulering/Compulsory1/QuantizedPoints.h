@@ -0,0 +1,61 @@
+#ifndef QUANTIZEDPOINTS_H
+#define QUANTIZEDPOINTS_H
+
+#include <vector>
+#include <utility>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+
+using namespace std;
+
+//Lagrer punkter som tre 16 bits heltall (6 bytes) i stedet for tre float (12 bytes).
+//Hvert punkt er origin + position * scale, der origin er hjørnet av boksen rundt punktene og scale
+//deler boksen i 65535 like store steg langs hver akse. Den samme kodingen lastes opp til GPU-en
+//og gjøres om til float i vertex shaderen (vs.vs), slik at både minnet og VRAM brukes halvparten så mye.
+class QuantizedPoints
+{
+public:
+    QuantizedPoints() : origin(0.0f), scale(1.0f) {}
+
+    //Finner boksen rundt punktene og gjør om hvert punkt til heltall
+    void quantize(const vector<glm::vec3>& points);
+
+    //Gjør om punkt i tilbake til float
+    glm::vec3 operator[](size_t i) const { return origin + glm::vec3(positions[i]) * scale; }
+
+    //Punkter som legges til eller endres etter quantize må ligge inne i boksen (contains), ellers flyttes de til kanten
+    bool contains(const glm::vec3& point) const;
+    //Bruker heltallene og kodingen fra en tidligere quantize, f.eks fra SurfaceCache
+    void assign(const glm::vec3& newOrigin, const glm::vec3& newScale, vector<glm::u16vec3> newPositions)
+    {
+        origin = newOrigin;
+        scale = newScale;
+        positions = move(newPositions);
+    }
+    void set(size_t i, const glm::vec3& point) { positions[i] = encode(point); }
+    void push_back(const glm::vec3& point) { positions.push_back(encode(point)); }
+    void pop_back() { positions.pop_back(); }
+
+    size_t size() const { return positions.size(); }
+    bool empty() const { return positions.empty(); }
+    const glm::u16vec3* data() const { return positions.data(); }
+
+    //Det største avviket et punkt kan få langs hver akse når det kvantiseres
+    glm::vec3 maxError() const { return scale * 0.5f; }
+
+    void clear()
+    {
+        positions.clear();
+        positions.shrink_to_fit();
+    }
+
+    glm::vec3 origin;
+    glm::vec3 scale;
+
+private:
+    glm::u16vec3 encode(const glm::vec3& point) const;
+
+    vector<glm::u16vec3> positions;
+};
+
+#endif
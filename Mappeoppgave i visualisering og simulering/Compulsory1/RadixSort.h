@@ -0,0 +1,90 @@
+#ifndef RADIXSORT_H
+#define RADIXSORT_H
+
+#include <vector>
+#include <cstdint>
+#include <algorithm>
+#include "Parallel.h"
+
+using namespace std;
+
+//Sorterer keys stigende og flytter values likt, med LSD radix sortering 8 bits om gangen.
+//Bare de keyBits laveste bitene i nøklene sorteres. Sorteringen er stabil: like nøkler beholder
+//rekkefølgen de hadde, slik at resultatet ikke avhenger av antall tråder.
+//Hver tråd teller sifrene i sin bit av tabellen, så får hver (siffer, bit) sin startposisjon og trådene
+//flytter elementene sine direkte til riktig plass uten låser.
+inline void parallelRadixSort(vector<uint64_t>& keys, vector<uint32_t>& values, unsigned int keyBits, unsigned int threadCount)
+{
+    const unsigned int radixBits = 8;
+    const size_t bucketCount = size_t(1) << radixBits;
+    size_t count = keys.size();
+    if (count < 2 || keyBits == 0)
+    {
+        return;
+    }
+
+    threadCount = static_cast<unsigned int>(min<size_t>(max(threadCount, 1u), count));
+    vector<uint64_t> keyBuffer(count);
+    vector<uint32_t> valueBuffer(count);
+    vector<size_t> histograms(static_cast<size_t>(threadCount) * bucketCount);
+
+    for (unsigned int shift = 0; shift < keyBits; shift += radixBits)
+    {
+        fill(histograms.begin(), histograms.end(), 0);
+        parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+        {
+            size_t* histogram = &histograms[chunk * bucketCount];
+            for (size_t i = begin; i < end; ++i)
+            {
+                ++histogram[(keys[i] >> shift) & (bucketCount - 1)];
+            }
+        });
+
+        //Startposisjonen til hvert siffer i hver bit. Hvis alle nøklene har samme siffer er runden unødvendig.
+        size_t offset = 0;
+        bool allSameDigit = false;
+        for (size_t digit = 0; digit < bucketCount; ++digit)
+        {
+            size_t digitStart = offset;
+            for (unsigned int chunk = 0; chunk < threadCount; ++chunk)
+            {
+                size_t digitCount = histograms[chunk * bucketCount + digit];
+                histograms[chunk * bucketCount + digit] = offset;
+                offset += digitCount;
+            }
+            allSameDigit = allSameDigit || offset - digitStart == count;
+        }
+        if (allSameDigit)
+        {
+            continue;
+        }
+
+        parallelFor(count, threadCount, [&](size_t begin, size_t end, unsigned int chunk)
+        {
+            size_t* position = &histograms[chunk * bucketCount];
+            for (size_t i = begin; i < end; ++i)
+            {
+                size_t target = position[(keys[i] >> shift) & (bucketCount - 1)]++;
+                keyBuffer[target] = keys[i];
+                valueBuffer[target] = values[i];
+            }
+        });
+
+        keys.swap(keyBuffer);
+        values.swap(valueBuffer);
+    }
+}
+
+//Antall bits som trengs for å skrive value
+inline unsigned int bitWidth(uint64_t value)
+{
+    unsigned int bits = 0;
+    while (value != 0)
+    {
+        ++bits;
+        value >>= 1;
+    }
+    return bits;
+}
+
+#endif
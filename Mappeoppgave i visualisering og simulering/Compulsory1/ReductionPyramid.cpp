@@ -0,0 +1,39 @@
+#include "ReductionPyramid.h"
+#include <iostream>
+
+void ReductionPyramid::build(const vector<glm::vec3>& basePoints, float baseCellSize, int levelCount, CellAggregation aggregation)
+{
+    clear();
+    cellSizes.push_back(baseCellSize);
+    levels.push_back(basePoints);
+
+    for (int level = 1; level < levelCount; ++level)
+    {
+        const vector<glm::vec3>& below = levels.back();
+        PointCloud cloud;
+        cloud.resize(below.size());
+        for (size_t i = 0; i < below.size(); ++i)
+        {
+            cloud.writableX()[i] = below[i].x;
+            cloud.writableY()[i] = below[i].y;
+            cloud.writableZ()[i] = below[i].z;
+        }
+
+        float size = cellSizes.back() * 2.0f;
+        GridReducer reducer(size, aggregation);
+        reducer.addPoints(cloud);
+        cellSizes.push_back(size);
+        levels.push_back(reducer.reducedPoints());
+    }
+
+    for (size_t level = 0; level < levels.size(); ++level)
+    {
+        cout << "Nivå " << level << ": cellestørrelse " << cellSizes[level] << ", " << levels[level].size() << " punkter" << endl;
+    }
+}
+
+void ReductionPyramid::clear()
+{
+    cellSizes.clear();
+    levels.clear();
+}
@@ -0,0 +1,33 @@
+#ifndef REDUCTIONPYRAMID_H
+#define REDUCTIONPYRAMID_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "GridReducer.h"
+
+using namespace std;
+
+//Den reduserte punktskyen i flere oppløsninger. Nivå 0 er punktene redusert med den minste cellestørrelsen,
+//og hvert nivå over har dobbelt så store celler og lages av punktene på nivået under. Punktskyen leses og
+//reduseres dermed bare én gang, og det er billig å bytte mellom tettheter mens programmet kjører.
+//Siden nivåene over 0 slår sammen punktene på nivået under, blir Centroid, MedianZ og CenterMeanZ regnet av
+//cellepunktene og ikke av alle de opprinnelige punktene, og Count teller cellene på nivået under.
+class ReductionPyramid
+{
+public:
+    ReductionPyramid() {}
+
+    //Bygger levelCount nivåer med basePoints (allerede redusert med baseCellSize) som nivå 0
+    void build(const vector<glm::vec3>& basePoints, float baseCellSize, int levelCount, CellAggregation aggregation);
+    void clear();
+
+    int levelCount() const { return static_cast<int>(levels.size()); }
+    float cellSize(int level) const { return cellSizes[level]; }
+    const vector<glm::vec3>& levelPoints(int level) const { return levels[level]; }
+
+private:
+    vector<float> cellSizes;
+    vector<vector<glm::vec3>> levels;
+};
+
+#endif
@@ -0,0 +1,169 @@
+#include "SparseSolver.h"
+#include "Parallel.h"
+#include <cmath>
+
+//Under så mange rader per tråd lønner det seg ikke å starte tråder (hver parallelFor starter nye tråder)
+static const size_t minimumRowsPerThread = 4096;
+
+static unsigned int solverThreadCount(size_t rows, unsigned int threadCount)
+{
+    threadCount = threadCount == 0 ? workerCount() : threadCount;
+    return static_cast<unsigned int>(max<size_t>(1, min<size_t>(threadCount, rows / minimumRowsPerThread)));
+}
+
+void SparseMatrix::multiply(const vector<double>& x, vector<double>& result, unsigned int threadCount) const
+{
+    result.resize(rows);
+    parallelFor(rows, solverThreadCount(rows, threadCount), [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t r = begin; r < end; ++r)
+        {
+            double sum = 0.0;
+            for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; ++k)
+            {
+                sum += values[k] * x[columns[k]];
+            }
+            result[r] = sum;
+        }
+    });
+}
+
+vector<double> SparseMatrix::diagonal() const
+{
+    vector<double> result(rows, 0.0);
+    for (size_t r = 0; r < rows; ++r)
+    {
+        for (uint32_t k = rowStart[r]; k < rowStart[r + 1]; ++k)
+        {
+            if (columns[k] == r)
+            {
+                result[r] = values[k];
+            }
+        }
+    }
+    return result;
+}
+
+//Forkondisjonert CG som i Shewchuk, "An Introduction to the Conjugate Gradient Method Without the Agonizing
+//Pain" (1994), B3. Prikkproduktene summeres i én delsum per tråd og legges sammen i fast rekkefølge, så svaret
+//er det samme hver gang med samme antall tråder.
+SolverResult solveConjugateGradient(const SparseMatrix& a, const vector<double>& b, vector<double>& x,
+    int maxIterations, double tolerance, unsigned int threadCount)
+{
+    SolverResult result;
+    size_t n = a.rows;
+    x.resize(n, 0.0);
+    if (n == 0)
+    {
+        result.converged = true;
+        return result;
+    }
+
+    unsigned int threads = solverThreadCount(n, threadCount);
+    vector<double> partSums(threads * 2);
+    auto sumParts = [&](int offset)
+    {
+        double sum = 0.0;
+        for (unsigned int part = 0; part < threads; ++part)
+        {
+            sum += partSums[part * 2 + offset];
+        }
+        return sum;
+    };
+
+    vector<double> inverseDiagonal = a.diagonal();
+    for (double& value : inverseDiagonal)
+    {
+        value = value > 0.0 ? 1.0 / value : 1.0;
+    }
+
+    vector<double> r(n), z(n), p(n), q(n);
+    a.multiply(x, q, threads);
+    fill(partSums.begin(), partSums.end(), 0.0);
+    parallelFor(n, threads, [&](size_t begin, size_t end, unsigned int part)
+    {
+        double rz = 0.0, bb = 0.0;
+        for (size_t i = begin; i < end; ++i)
+        {
+            r[i] = b[i] - q[i];
+            z[i] = r[i] * inverseDiagonal[i];
+            p[i] = z[i];
+            rz += r[i] * z[i];
+            bb += b[i] * b[i];
+        }
+        partSums[part * 2] = rz;
+        partSums[part * 2 + 1] = bb;
+    });
+    double rz = sumParts(0);
+    double bNorm = sqrt(sumParts(1));
+    if (bNorm == 0.0)
+    {
+        fill(x.begin(), x.end(), 0.0);
+        result.converged = true;
+        return result;
+    }
+
+    for (int iteration = 0; iteration < maxIterations; ++iteration)
+    {
+        //q = Ap og p * q
+        fill(partSums.begin(), partSums.end(), 0.0);
+        parallelFor(n, threads, [&](size_t begin, size_t end, unsigned int part)
+        {
+            double pq = 0.0;
+            for (size_t row = begin; row < end; ++row)
+            {
+                double sum = 0.0;
+                for (uint32_t k = a.rowStart[row]; k < a.rowStart[row + 1]; ++k)
+                {
+                    sum += a.values[k] * p[a.columns[k]];
+                }
+                q[row] = sum;
+                pq += p[row] * sum;
+            }
+            partSums[part * 2] = pq;
+        });
+        double pq = sumParts(0);
+        if (pq <= 0.0)
+        {
+            //Matrisen er ikke positiv definitt langs p, så CG kan ikke fortsette
+            break;
+        }
+        double alpha = rz / pq;
+
+        //Oppdaterer x og residualen, og forkondisjonerer residualen
+        fill(partSums.begin(), partSums.end(), 0.0);
+        parallelFor(n, threads, [&](size_t begin, size_t end, unsigned int part)
+        {
+            double rzNew = 0.0, rr = 0.0;
+            for (size_t i = begin; i < end; ++i)
+            {
+                x[i] += alpha * p[i];
+                r[i] -= alpha * q[i];
+                z[i] = r[i] * inverseDiagonal[i];
+                rzNew += r[i] * z[i];
+                rr += r[i] * r[i];
+            }
+            partSums[part * 2] = rzNew;
+            partSums[part * 2 + 1] = rr;
+        });
+        double rzNew = sumParts(0);
+        result.iterations = iteration + 1;
+        result.relativeResidual = sqrt(sumParts(1)) / bNorm;
+        if (result.relativeResidual < tolerance)
+        {
+            result.converged = true;
+            break;
+        }
+
+        double beta = rzNew / rz;
+        rz = rzNew;
+        parallelFor(n, threads, [&](size_t begin, size_t end, unsigned int)
+        {
+            for (size_t i = begin; i < end; ++i)
+            {
+                p[i] = z[i] + beta * p[i];
+            }
+        });
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef SPARSESOLVER_H
+#define SPARSESOLVER_H
+
+#include <vector>
+#include <cstdint>
+
+using namespace std;
+
+//Glissen (sparse) kvadratisk matrise lagret rad for rad (CSR): verdiene i rad r ligger i values fra rowStart[r]
+//til rowStart[r + 1], med kolonnen i columns på samme plass.
+struct SparseMatrix
+{
+    size_t rows = 0;
+    vector<uint32_t> rowStart;
+    vector<uint32_t> columns;
+    vector<double> values;
+
+    size_t nonZeros() const { return values.size(); }
+    //result = matrisen * x. Radene deles mellom trådene. 0 tråder betyr workerCount().
+    void multiply(const vector<double>& x, vector<double>& result, unsigned int threadCount = 0) const;
+    //Diagonalen, 0 der raden ikke har et element på diagonalen
+    vector<double> diagonal() const;
+};
+
+struct SolverResult
+{
+    int iterations = 0;
+    //|b - Ax| / |b| etter siste iterasjon
+    double relativeResidual = 0.0;
+    bool converged = false;
+};
+
+//Løser Ax = b med konjugerte gradienter, der A må være symmetrisk og positiv definitt. x er startgjetningen og
+//får svaret. Forkondisjoneres med diagonalen (Jacobi). Stopper når |b - Ax| / |b| < tolerance.
+//
+//Hver iterasjon er tre gjennomganger av vektorene (matrise ganger vektor, oppdatering av x og residualen, ny
+//søkeretning) som deles mellom trådene, med én delsum per tråd for prikkproduktene. Små systemer løses på én
+//tråd, siden det koster mer å starte trådene enn å gjøre regningen.
+SolverResult solveConjugateGradient(const SparseMatrix& a, const vector<double>& b, vector<double>& x,
+    int maxIterations, double tolerance, unsigned int threadCount = 0);
+
+#endif
@@ -1,24 +1,27 @@
 #include "Surface.h"
 #include <glm/gtc/type_ptr.hpp>
+#include "BSplineBasis.h"
 #include <algorithm>
 
 Surface::Surface(const vector<glm::vec3>& controlPoints, int widthU, int widthV,
     const vector<float>& knotU, const vector<float>& knotV)
-    : controlPoints(controlPoints), widthU(widthU), widthV(widthV), knotU(knotU), knotV(knotV) {}
+    : controlPoints(controlPoints), widthU(widthU), widthV(widthV),
+    degreeU(max(static_cast<int>(knotU.size()) - widthU - 1, 1)), degreeV(max(static_cast<int>(knotV.size()) - widthV - 1, 1)),
+    knotU(knotU), knotV(knotV) {}
 
 //Referanse https://github.com/pascal754/BsplineSurface/blob/main/BsplineSurface/BsplineSurface.cpp
 // Referanse kapittel 12 https://drive.google.com/file/d/1iOIm-Orpi-zYynCo7TyEQccLohRI5HBh/view
 
 //Denne funsjonen regner ut B-spline basesfunksjonene. 
-//i= hvilke del av sjtevektoren som pvirker basesfunksjonen d= er graden p basisfunksjonen, 
-// t = parameteren, knots er delen av skjtevektoren som er aktiv. 
+//i= hvilke del av sjøtevektoren som påvirker basesfunksjonen d= er graden på basisfunksjonen, 
+// t = parameteren, knots er delen av skjøtevektoren som er aktiv. 
 float Surface::BSplineBasisFunctions(int i, int d, float t, const vector<float>& knots) const
 {
     if (i < 0 || i >= knots.size() - 1) return 0.0f;
-    //Begynner med grad 0 og undersker som parameterverdien ligger innenfor intervallet. 
+    //Begynner med grad 0 og undersøker som parameterverdien ligger innenfor intervallet. 
     //Hvis t ligger innenfor intervallet, bidrar basisfunsjonen i dette intervallet. 
     if (d == 0) return (knots[i] <= t && t < knots[i + 1]) ? 1.0f : 0.0f;
-    //Lager basisfunksjoner av hyere grader, bygget p lavere grader basisfunksjoner. 
+    //Lager basisfunksjoner av høyere grader, bygget på lavere grader basisfunksjoner. 
     float intervalLength1 = knots[i + d] - knots[i];
     float basisContribution1 = (intervalLength1 != 0.0f) ? (t - knots[i]) / intervalLength1 * BSplineBasisFunctions(i, d - 1, t, knots) : 0.0f;
     float intervalLength2 = knots[i + d + 1] - knots[i + 1];
@@ -27,16 +30,15 @@ float Surface::BSplineBasisFunctions(int i, int d, float t, const vector<float>&
 }
 
 //Denne funksjonen er viktig for utregning av normaler. 
-//Her ser man hvordan overflaten endrer seg lokalt ved  finne tangentvektoren til overflaten i u og v retning ved  kombinere basisfunksjoner og 
+//Her ser man hvordan overflaten endrer seg lokalt ved å finne tangentvektoren til overflaten i u og v retning ved å kombinere basisfunksjoner og 
 //kontrollpunkter 
 glm::vec3 Surface::calculatePartialDerivative(float u, float v, bool evaluateInUDirection) const
 {
     glm::vec3 derivative(0.0f);
-    int degreeU = 2, degreeV = 2;
     float scaledU = u * (knotU[knotU.size() - degreeU - 1] - knotU.front()) + knotU.front();
     float scaledV = v * (knotV[knotV.size() - degreeV - 1] - knotV.front()) + knotV.front();
 
-    //Gr gjennom alle kontrollpunktene. 
+    //Går gjennom alle kontrollpunktene. 
     for (int i = 0; i < widthU; ++i) 
     {
         for (int j = 0; j < widthV; ++j) 
@@ -53,16 +55,48 @@ glm::vec3 Surface::calculatePartialDerivative(float u, float v, bool evaluateInU
     return derivative;
 }
 
-//Finner et punkt p B-spline overflaten ved  kombinere kontrollpunktene og basisfunksjonene 
-//Skalerer parametrene i u og v retning og iterer gjennom alle kontrollpunktene. Basisfunksjonene i u og v retning blir beregnet. 
-//Legger sammen basisfunksjoene i u og v retning og kontrollpunktene. 
+//Finner et punkt på B-spline overflaten ved å kombinere kontrollpunktene og basisfunksjonene 
+//Skalerer parametrene i u og v retning og finner intervallet de ligger i. Bare degree + 1 basisfunksjoner i hver
+//retning er forskjellige fra null der, så de regnes ut nedenfra (de Boor, se BSplineBasis.h) og bare de
+//(degreeU + 1) * (degreeV + 1) kontrollpunktene rundt punktet legges sammen. Prisen avhenger da ikke av hvor
+//mange kontrollpunkter flaten har. 
 glm::vec3 Surface::calculateSurfacePoint(float u, float v) const
+{
+    int spanU = -1, spanV = -1;
+    return calculateSurfacePoint(u, v, spanU, spanV);
+}
+
+glm::vec3 Surface::calculateSurfacePoint(float u, float v, int& spanU, int& spanV) const
 {
     glm::vec3 point(0.0f);
-    int degreeU = 2, degreeV = 2;
     float scaledU = min(u * (knotU[knotU.size() - degreeU - 1] - knotU.front()) + knotU.front(), knotU[knotU.size() - degreeU - 1] - 0.001f);
     float scaledV = min(v * (knotV[knotV.size() - degreeV - 1] - knotV.front()) + knotV.front(), knotV[knotV.size() - degreeV - 1] - 0.001f);
 
+    if (degreeU <= maxBasisDegree && degreeV <= maxBasisDegree)
+    {
+        spanU = findKnotSpan(knotU, degreeU, widthU, scaledU, spanU);
+        spanV = findKnotSpan(knotV, degreeV, widthV, scaledV, spanV);
+        float basisU[maxBasisDegree + 1], basisV[maxBasisDegree + 1];
+        basisFunctionsAt(knotU, spanU, degreeU, scaledU, basisU);
+        basisFunctionsAt(knotV, spanV, degreeV, scaledV, basisV);
+
+        for (int b = 0; b <= degreeV; ++b)
+        {
+            glm::vec3 row(0.0f);
+            for (int a = 0; a <= degreeU; ++a)
+            {
+                size_t index = static_cast<size_t>(spanV - degreeV + b) * widthU + spanU - degreeU + a;
+                if (index < controlPoints.size())
+                {
+                    row += basisU[a] * controlPoints[index];
+                }
+            }
+            point += basisV[b] * row;
+        }
+        return point;
+    }
+
+    //Høyere grad enn basisFunctionsAt kan ta: alle kontrollpunktene med de rekursive basisfunksjonene
     for (int i = 0; i < widthU; ++i)
     {
         for (int j = 0; j < widthV; ++j)
@@ -79,28 +113,30 @@ glm::vec3 Surface::calculateSurfacePoint(float u, float v) const
     return point;
 }
 
-//Regner ut alle punktene p en B- spline overflate og lager en vektor med liste over eller 3D punktene. 
+//Regner ut alle punktene på en B- spline overflate og lager en vektor med liste over eller 3D punktene. 
 vector<glm::vec3> Surface::calculateSurfacePoints(int pointsOnTheSurface) const
 {
     vector<glm::vec3> surfacePoints;
+    //Nabopunktene i rutenettet ligger som regel i samme intervall i skjøtvektorene 
+    int spanU = -1, spanV = -1;
     for (int i = 0; i < pointsOnTheSurface; ++i)
     {
         for (int j = 0; j < pointsOnTheSurface; ++j)
         {
             float u = i / static_cast<float>(pointsOnTheSurface - 1);
             float v = j / static_cast<float>(pointsOnTheSurface - 1);
-            surfacePoints.push_back(calculateSurfacePoint(u, v));
+            surfacePoints.push_back(calculateSurfacePoint(u, v, spanU, spanV));
         }
     }
     return surfacePoints;
 }
 
-//Renger ut normalvektorene p en overflate p et rutenett av punkter. Normalene regnet ut ved hjelp av funsjonen
-//calculatePartialDerivative. Normalene str vinkelrett p overflaten ved hvert punkt. 
+//Renger ut normalvektorene på en overflate på et rutenett av punkter. Normalene regnet ut ved hjelp av funsjonen
+//calculatePartialDerivative. Normalene står vinkelrett på overflaten ved hvert punkt. 
 vector<glm::vec3> Surface::calculateSurfaceNormals(int pointsOnTheSurface) const
 {
     vector<glm::vec3> normals;
-    //Epsilon brukes for  forskyve kantene av intervallet [0,1]. Verdiene 0 og 1 kan bli ustabil eller regnes feil fordi de kan evaluere utenfor sjtvektorens 
+    //Epsilon brukes for å forskyve kantene av intervallet [0,1]. Verdiene 0 og 1 kan bli ustabil eller regnes feil fordi de kan evaluere utenfor sjøtvektorens 
     //domene. 
     float epsilon = 0.001f;
 
@@ -129,7 +165,7 @@ vector<glm::vec3> Surface::calculateSurfaceNormals(int pointsOnTheSurface) const
     return normals;
 }
 
-//Bregner en lise av indekser som gjr at man kan tegne et rutenett av trekanter. 
+//Bregner en lise av indekser som gjør at man kan tegne et rutenett av trekanter. 
 vector<unsigned int> Surface::generateIndices(int pointsOnTheSurface) const
 {
     vector<unsigned int> indices;
@@ -157,7 +193,7 @@ std::vector<glm::vec3> Surface::calculateBSplineCurve(const vector<glm::vec3>& c
         return splinePoints; // Ikke nok punkter for B-spline
     }
 
-    // Fjern unskede punkter som (0,0,0)
+    // Fjern uønskede punkter som (0,0,0)
     vector<glm::vec3> validControlPoints;
     for (const auto& point : controlPoints) 
     {
@@ -172,7 +208,7 @@ std::vector<glm::vec3> Surface::calculateBSplineCurve(const vector<glm::vec3>& c
         return splinePoints; // Ikke nok gyldige punkter
     }
 
-    // Fortsett som fr med `validControlPoints` i stedet for `controlPoints`
+    // Fortsett som før med `validControlPoints` i stedet for `controlPoints`
     int knotCount = validControlPoints.size() + degree + 1;
     vector<float> knots(knotCount);
     for (int i = 0; i < knotCount; ++i) 
@@ -255,16 +291,16 @@ void Surface::setupBuffers(unsigned int& surfaceVAO, unsigned int& surfaceVBO, u
     vector<unsigned int> indices = generateIndices(pointsOnTheSurface);
     vector<glm::vec3> colors;
 
-    // Generer farger for friksjonsomrdet
+    // Generer farger for friksjonsområdet
     for (const glm::vec3& point : surfacePoints) {
         if (point.x >= frictionAreaXMin && point.x <= frictionAreaXMax &&
             point.y >= frictionAreaYMin && point.y <= frictionAreaYMax) 
         {
-            // Sett friksjonsomrdet til rd farge
+            // Sett friksjonsområdet til rød farge
             colors.push_back(glm::vec3(1.0f, 0.0f, 0.0f));
         }
         else {
-            // Sett resten av overflaten til en nytral farge
+            // Sett resten av overflaten til en nøytral farge
             colors.push_back(glm::vec3(0.7f, 0.7f, 0.7f));
         }
     }
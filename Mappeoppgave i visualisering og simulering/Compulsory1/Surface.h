@@ -12,18 +12,22 @@ using namespace std;
 class Surface
 {
 public:
-    //Constructoren tar parameter for kontrollpunktene p overflaten, antall kontrollpunkter det er horisontal og vertikal retning, 
-    //og skjtevektorer for u (horisontal) og v (vertikal) retning. 
+    //Constructoren tar parameter for kontrollpunktene på overflaten, antall kontrollpunkter det er horisontal og vertikal retning, 
+    //og skjøtevektorer for u (horisontal) og v (vertikal) retning. 
     Surface(const vector<glm::vec3>& controlPoints, int widthU, int widthV,
         const vector<float>& knotU, const vector<float>& knotV);
 
-    // Regner ut et punkt p overflaten. 
+    // Regner ut et punkt på overflaten. Endrer ikke objektet, så den kan kalles fra flere tråder samtidig. 
     glm::vec3 calculateSurfacePoint(float u, float v) const;
+    //Som over, men spanU og spanV er intervallene i skjøtvektorene fra forrige kall fra den som kaller (-1 første
+    //gang), og oppdateres. Punkter som evalueres etter hverandre ligger ofte i samme intervall, så binærsøket kan
+    //hoppes over. Hintene eies av den som kaller, så flere tråder kan bruke samme flate med hver sine hint. 
+    glm::vec3 calculateSurfacePoint(float u, float v, int& spanU, int& spanV) const;
 
-    //Regner ut alle punktene p overflaten 
+    //Regner ut alle punktene på overflaten 
     vector<glm::vec3> calculateSurfacePoints(int pointsOnTheSurface) const;
 
-    //Regner ut normalene til hvert punkt p overflaten. Dette brukes til belysning (phong shaderen). 
+    //Regner ut normalene til hvert punkt på overflaten. Dette brukes til belysning (phong shaderen). 
     vector<glm::vec3> calculateSurfaceNormals(int pointsOnTheSurface) const;
 
     //Lager en trekantmesh
@@ -45,11 +49,13 @@ private:
     //Regner ut B-spline basisfunksjonene
     float BSplineBasisFunctions(int i, int d, float t, const vector<float>& knots) const;
 
-    //Kontrollpunktene p overflaten 
+    //Kontrollpunktene på overflaten 
     vector<glm::vec3> controlPoints;
-    //Bredde og hyde p kontrollpunktene
+    //Bredde og høyde på kontrollpunktene
     int widthU, widthV;
-    //Skjtevektorene u og v 
+    //Graden i hver retning, gitt av lengden på skjøtevektoren (knotU.size() - widthU - 1)
+    int degreeU, degreeV;
+    //Skjøtevektorene u og v 
     vector<float> knotU, knotV;
 };
 
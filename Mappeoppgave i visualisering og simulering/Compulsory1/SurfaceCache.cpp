@@ -0,0 +1,290 @@
+#include "SurfaceCache.h"
+#include "PointCloudCache.h"
+#include "MappedFile.h"
+#include "BSplineBasis.h"
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+#include <chrono>
+#include <cstring>
+#include <cstdio>
+#include <algorithm>
+
+static const char cacheMagic[8] = { 'S', 'U', 'R', 'F', 'A', 'C', 'E', '\0' };
+
+//Tabellene starter på en 64 byte grense, som kolonnene i PointCloudCache
+static const uint64_t sectionAlignment = 64;
+
+static uint64_t alignUp(uint64_t value)
+{
+    return (value + sectionAlignment - 1) / sectionAlignment * sectionAlignment;
+}
+
+//Kopierer en tabell fra den mappede filen over i vector
+template <class T>
+static void readSection(const MappedFile& file, uint64_t offset, uint64_t count, vector<T>& values)
+{
+    values.resize(static_cast<size_t>(count));
+    if (count > 0)
+    {
+        memcpy(values.data(), file.data() + offset, static_cast<size_t>(count) * sizeof(T));
+    }
+}
+
+uint64_t SurfaceCache::sourcesKey(const vector<string>& sourceFilenames, uint64_t settingsKey)
+{
+    uint64_t key = settingsKey;
+    for (const string& sourceFilename : sourceFilenames)
+    {
+        uint64_t length = sourceFilename.size();
+        key = PointCloudCache::hashBytes(key, &length, sizeof(length));
+        key = PointCloudCache::hashBytes(key, sourceFilename.data(), sourceFilename.size());
+    }
+    return key;
+}
+
+uint64_t SurfaceCache::sourcesFingerprint(const vector<string>& sourceFilenames)
+{
+    uint64_t fingerprint = PointCloudCache::hashSeed;
+    for (const string& sourceFilename : sourceFilenames)
+    {
+        uint64_t fileFingerprint = PointCloudCache::fingerprintFile(sourceFilename);
+        if (fileFingerprint == 0)
+        {
+            return 0;
+        }
+        fingerprint = PointCloudCache::hashBytes(fingerprint, &fileFingerprint, sizeof(fileFingerprint));
+    }
+    return fingerprint;
+}
+
+string SurfaceCache::cacheFilename(const vector<string>& sourceFilenames, uint64_t settingsKey)
+{
+    char key[17];
+    snprintf(key, sizeof(key), "%016llx", static_cast<unsigned long long>(sourcesKey(sourceFilenames, settingsKey)));
+    return sourceFilenames.front() + "." + key + ".sfc";
+}
+
+bool SurfaceCache::load(const vector<string>& sourceFilenames, uint64_t settingsKey, CachedSurface& surface)
+{
+    auto startTime = chrono::steady_clock::now();
+
+    if (sourceFilenames.empty())
+    {
+        return false;
+    }
+    MappedFile file;
+    string filename = cacheFilename(sourceFilenames, settingsKey);
+    if (!file.open(filename) || file.size() < sizeof(Header))
+    {
+        return false;
+    }
+
+    Header header;
+    memcpy(&header, file.data(), sizeof(Header));
+
+    if (memcmp(header.magic, cacheMagic, sizeof(cacheMagic)) != 0 || header.version != formatVersion ||
+        header.headerSize != sizeof(Header) || header.settingsKey != sourcesKey(sourceFilenames, settingsKey))
+    {
+        return false;
+    }
+
+    const size_t elementSizes[SectionCount] = { sizeof(glm::vec3), sizeof(glm::u16vec3), sizeof(glm::ivec3),
+        sizeof(glm::ivec3), sizeof(glm::i16vec2), sizeof(glm::i16vec2), sizeof(float), sizeof(glm::vec3),
+        sizeof(float), sizeof(float) };
+    for (int section = 0; section < SectionCount; ++section)
+    {
+        uint64_t offset = header.sectionOffsets[section];
+        if (offset % sizeof(float) != 0 || offset > file.size() ||
+            header.sectionCounts[section] > (file.size() - offset) / elementSizes[section])
+        {
+            return false;
+        }
+    }
+    //Nettet må ha én naboliste per trekant og hvert punkt én normal, ellers er filen ødelagt. PCA-normalene og
+    //variasjonen finnes bare med setPointNormals, og har da én verdi per punkt.
+    uint64_t vertexCount = header.sectionCounts[Points] + header.sectionCounts[QuantizedPositions];
+    auto perPoint = [vertexCount](uint64_t count) { return count == 0 || count == vertexCount; };
+    if (header.sectionCounts[Triangles] != header.sectionCounts[Neighbours] ||
+        header.sectionCounts[VertexNormals] != vertexCount ||
+        !perPoint(header.sectionCounts[PointNormals]) || !perPoint(header.sectionCounts[PointVariations]) ||
+        header.sectionCounts[ControlPoints] != static_cast<uint64_t>(header.widthU) * static_cast<uint64_t>(header.widthV))
+    {
+        return false;
+    }
+    //Uten tilpasset flate er tabellene til B-spline flaten tomme. Ellers må skjøtvektorene ha widthU + degree + 1 og
+    //widthV + degree + 1 skjøter, siden Surface finner graden fra lengden og indekserer kontrollpunktene med den.
+    if (header.sectionCounts[ControlPoints] > 0 || header.sectionCounts[KnotU] > 0 || header.sectionCounts[KnotV] > 0)
+    {
+        if (header.degree < 1 || header.degree > maxBasisDegree || header.widthU <= header.degree ||
+            header.widthV <= header.degree ||
+            header.sectionCounts[KnotU] != static_cast<uint64_t>(header.widthU) + header.degree + 1 ||
+            header.sectionCounts[KnotV] != static_cast<uint64_t>(header.widthV) + header.degree + 1)
+        {
+            return false;
+        }
+    }
+
+    uint64_t sourceFingerprint = sourcesFingerprint(sourceFilenames);
+    if (sourceFingerprint == 0 || header.sourceFingerprint != sourceFingerprint)
+    {
+        cout << "Flatecachen for " << sourceFilenames.front() << " er utdatert og blir laget på nytt" << endl;
+        return false;
+    }
+
+    readSection(file, header.sectionOffsets[Points], header.sectionCounts[Points], surface.points);
+    readSection(file, header.sectionOffsets[QuantizedPositions], header.sectionCounts[QuantizedPositions],
+        surface.quantizedPositions);
+    readSection(file, header.sectionOffsets[Triangles], header.sectionCounts[Triangles], surface.triangles);
+    readSection(file, header.sectionOffsets[Neighbours], header.sectionCounts[Neighbours], surface.neighbours);
+    //Hjørnene må være punkter og naboene trekanter (eller -1 på randen), ellers leser nettet utenfor tabellene
+    int64_t triangleCount = static_cast<int64_t>(surface.triangles.size());
+    for (size_t i = 0; i < surface.triangles.size(); ++i)
+    {
+        for (int corner = 0; corner < 3; ++corner)
+        {
+            int vertex = surface.triangles[i][corner];
+            int neighbour = surface.neighbours[i][corner];
+            if (vertex < 0 || static_cast<uint64_t>(vertex) >= vertexCount || neighbour < -1 || neighbour >= triangleCount)
+            {
+                return false;
+            }
+        }
+    }
+    readSection(file, header.sectionOffsets[VertexNormals], header.sectionCounts[VertexNormals], surface.vertexNormals);
+    readSection(file, header.sectionOffsets[PointNormals], header.sectionCounts[PointNormals], surface.pointNormals);
+    readSection(file, header.sectionOffsets[PointVariations], header.sectionCounts[PointVariations],
+        surface.pointVariations);
+    surface.quantizedOrigin = glm::vec3(header.quantizedOrigin[0], header.quantizedOrigin[1], header.quantizedOrigin[2]);
+    surface.quantizedScale = glm::vec3(header.quantizedScale[0], header.quantizedScale[1], header.quantizedScale[2]);
+
+    FittedSurface& fit = surface.fittedSurface;
+    fit = FittedSurface();
+    readSection(file, header.sectionOffsets[ControlPoints], header.sectionCounts[ControlPoints], fit.controlPoints);
+    readSection(file, header.sectionOffsets[KnotU], header.sectionCounts[KnotU], fit.knotU);
+    readSection(file, header.sectionOffsets[KnotV], header.sectionCounts[KnotV], fit.knotV);
+    if (!is_sorted(fit.knotU.begin(), fit.knotU.end()) || !is_sorted(fit.knotV.begin(), fit.knotV.end()))
+    {
+        return false;
+    }
+    fit.widthU = header.widthU;
+    fit.widthV = header.widthV;
+    fit.degree = header.degree;
+    fit.minCorner = glm::vec2(header.minCorner[0], header.minCorner[1]);
+    fit.maxCorner = glm::vec2(header.maxCorner[0], header.maxCorner[1]);
+    fit.pointsUsed = static_cast<size_t>(header.pointsUsed);
+    fit.rmsError = header.rmsError;
+    fit.iterations = header.iterations;
+    fit.converged = header.converged != 0;
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << "Lastet flaten med " << vertexCount << " punkter og " << surface.triangles.size() << " trekanter fra "
+        << filename << " på " << seconds * 1000.0 << " ms" << endl;
+    return true;
+}
+
+bool SurfaceCache::save(const vector<string>& sourceFilenames, uint64_t settingsKey, const CachedSurface& surface)
+{
+    if (sourceFilenames.empty())
+    {
+        return false;
+    }
+    Header header = {};
+    memcpy(header.magic, cacheMagic, sizeof(cacheMagic));
+    header.version = formatVersion;
+    header.headerSize = sizeof(Header);
+    header.sourceFingerprint = sourcesFingerprint(sourceFilenames);
+    header.settingsKey = sourcesKey(sourceFilenames, settingsKey);
+    if (header.sourceFingerprint == 0)
+    {
+        return false;
+    }
+
+    const FittedSurface& fit = surface.fittedSurface;
+    for (int axis = 0; axis < 3; ++axis)
+    {
+        header.quantizedOrigin[axis] = surface.quantizedOrigin[axis];
+        header.quantizedScale[axis] = surface.quantizedScale[axis];
+    }
+    header.widthU = fit.widthU;
+    header.widthV = fit.widthV;
+    header.degree = fit.degree;
+    header.iterations = fit.iterations;
+    for (int axis = 0; axis < 2; ++axis)
+    {
+        header.minCorner[axis] = fit.minCorner[axis];
+        header.maxCorner[axis] = fit.maxCorner[axis];
+    }
+    header.pointsUsed = fit.pointsUsed;
+    header.rmsError = fit.rmsError;
+    header.converged = fit.converged ? 1 : 0;
+
+    const void* sectionData[SectionCount] = { surface.points.data(), surface.quantizedPositions.data(),
+        surface.triangles.data(), surface.neighbours.data(), surface.vertexNormals.data(), surface.pointNormals.data(),
+        surface.pointVariations.data(), fit.controlPoints.data(), fit.knotU.data(), fit.knotV.data() };
+    const uint64_t sectionBytes[SectionCount] = {
+        surface.points.size() * sizeof(glm::vec3), surface.quantizedPositions.size() * sizeof(glm::u16vec3),
+        surface.triangles.size() * sizeof(glm::ivec3), surface.neighbours.size() * sizeof(glm::ivec3),
+        surface.vertexNormals.size() * sizeof(glm::i16vec2), surface.pointNormals.size() * sizeof(glm::i16vec2),
+        surface.pointVariations.size() * sizeof(float), fit.controlPoints.size() * sizeof(glm::vec3),
+        fit.knotU.size() * sizeof(float), fit.knotV.size() * sizeof(float) };
+    header.sectionCounts[Points] = surface.points.size();
+    header.sectionCounts[QuantizedPositions] = surface.quantizedPositions.size();
+    header.sectionCounts[Triangles] = surface.triangles.size();
+    header.sectionCounts[Neighbours] = surface.neighbours.size();
+    header.sectionCounts[VertexNormals] = surface.vertexNormals.size();
+    header.sectionCounts[PointNormals] = surface.pointNormals.size();
+    header.sectionCounts[PointVariations] = surface.pointVariations.size();
+    header.sectionCounts[ControlPoints] = fit.controlPoints.size();
+    header.sectionCounts[KnotU] = fit.knotU.size();
+    header.sectionCounts[KnotV] = fit.knotV.size();
+
+    uint64_t end = sizeof(Header);
+    for (int section = 0; section < SectionCount; ++section)
+    {
+        header.sectionOffsets[section] = alignUp(end);
+        end = header.sectionOffsets[section] + sectionBytes[section];
+    }
+
+    string finalName = cacheFilename(sourceFilenames, settingsKey);
+    string temporaryName = finalName + ".tmp";
+    {
+        ofstream outFile(temporaryName, ios::binary | ios::trunc);
+        if (!outFile.is_open())
+        {
+            return false;
+        }
+
+        const char padding[sectionAlignment] = {};
+        outFile.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+        uint64_t written = sizeof(Header);
+        for (int section = 0; section < SectionCount; ++section)
+        {
+            outFile.write(padding, static_cast<streamsize>(header.sectionOffsets[section] - written));
+            if (sectionBytes[section] > 0)
+            {
+                outFile.write(static_cast<const char*>(sectionData[section]), static_cast<streamsize>(sectionBytes[section]));
+            }
+            written = header.sectionOffsets[section] + sectionBytes[section];
+        }
+
+        if (!outFile.good())
+        {
+            outFile.close();
+            error_code error;
+            filesystem::remove(temporaryName, error);
+            return false;
+        }
+    }
+
+    error_code error;
+    filesystem::rename(temporaryName, finalName, error);
+    if (error)
+    {
+        filesystem::remove(temporaryName, error);
+        return false;
+    }
+
+    cout << "Skrev flatecache for " << sourceFilenames.front() << " til " << finalName << endl;
+    return true;
+}
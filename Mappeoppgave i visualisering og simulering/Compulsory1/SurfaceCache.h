@@ -0,0 +1,95 @@
+#ifndef SURFACECACHE_H
+#define SURFACECACHE_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "SurfaceFitter.h"
+
+using namespace std;
+
+//Alt loadFunctions lager av punktskyen: de reduserte punktene (som float eller kvantisert), trekantene med
+//naboene, normalene i hvert punkt, PCA-normalene og den tilpassede B-spline flaten med skjøtvektorene
+struct CachedSurface
+{
+    vector<glm::vec3> points;
+    vector<glm::u16vec3> quantizedPositions;
+    glm::vec3 quantizedOrigin = glm::vec3(0.0f);
+    glm::vec3 quantizedScale = glm::vec3(1.0f);
+    vector<glm::ivec3> triangles;
+    vector<glm::ivec3> neighbours;
+    //Oktaeder-kodet, én per punkt
+    vector<glm::i16vec2> vertexNormals;
+    vector<glm::i16vec2> pointNormals;
+    vector<float> pointVariations;
+    FittedSurface fittedSurface;
+};
+
+//Binær mellomlagring (cache) av den ferdige flaten, slik at reduksjonen, trianguleringen, normalene og
+//tilpasningen av B-spline flaten bare kjøres når punktskyen eller innstillingene har endret seg. Flaten kan være
+//laget av flere kildefiler (fliser). Filen ligger ved siden av den første kildefilen, med en hash av innstillingene
+//og navnene på kildefilene i navnet, så flere cellestørrelser og utvalg av fliser kan ligge i cachen samtidig.
+//Kildefilene kjennes igjen på fingeravtrykkene fra PointCloudCache::fingerprintFile.
+class SurfaceCache
+{
+public:
+    //Økes hver gang filformatet endres, slik at gamle filer blir laget på nytt
+    static const uint32_t formatVersion = 2;
+
+    //settingsKey er en hash av alle innstillingene som påvirker flaten (se PointCloudCache::hashBytes)
+    static string cacheFilename(const vector<string>& sourceFilenames, uint64_t settingsKey);
+
+    //Minnemapper cachen og kopierer tabellene rett over i surface. Returnerer false hvis cachen mangler, har feil
+    //versjon eller innstillinger, hvis en av kildefilene har endret seg siden cachen ble skrevet, eller hvis
+    //tabellene ikke passer sammen (feil antall eller indekser utenfor tabellene).
+    static bool load(const vector<string>& sourceFilenames, uint64_t settingsKey, CachedSurface& surface);
+
+    //Skriver flaten til en midlertidig fil som flyttes på plass til slutt, som PointCloudCache::save
+    static bool save(const vector<string>& sourceFilenames, uint64_t settingsKey, const CachedSurface& surface);
+
+private:
+    //settingsKey blandet med navnene på kildefilene
+    static uint64_t sourcesKey(const vector<string>& sourceFilenames, uint64_t settingsKey);
+    //Fingeravtrykkene til alle kildefilene i én hash. 0 hvis en av filene ikke kan leses.
+    static uint64_t sourcesFingerprint(const vector<string>& sourceFilenames);
+
+    //Tabellene i filen, i denne rekkefølgen
+    enum Section
+    {
+        Points,
+        QuantizedPositions,
+        Triangles,
+        Neighbours,
+        VertexNormals,
+        PointNormals,
+        PointVariations,
+        ControlPoints,
+        KnotU,
+        KnotV,
+        SectionCount
+    };
+
+    struct Header
+    {
+        char magic[8];
+        uint32_t version;
+        uint32_t headerSize;
+        uint64_t sourceFingerprint;
+        uint64_t settingsKey;
+        float quantizedOrigin[3];
+        float quantizedScale[3];
+        int32_t widthU, widthV, degree, iterations;
+        float minCorner[2];
+        float maxCorner[2];
+        uint64_t pointsUsed;
+        float rmsError;
+        uint32_t converged;
+        //Antall elementer og hvor tabellen starter i filen
+        uint64_t sectionCounts[SectionCount];
+        uint64_t sectionOffsets[SectionCount];
+    };
+};
+
+#endif
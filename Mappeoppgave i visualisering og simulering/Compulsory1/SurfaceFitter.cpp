@@ -0,0 +1,316 @@
+#include "SurfaceFitter.h"
+#include "BSplineBasis.h"
+#include "SparseSolver.h"
+#include "Parallel.h"
+#include <cmath>
+#include <algorithm>
+
+Surface FittedSurface::toSurface() const
+{
+    return Surface(controlPoints, widthU, widthV, knotU, knotV);
+}
+
+//Skjøtvektoren må ha riktig lengde, være stigende og ha degree + 1 like skjøter i hver ende, som Surface forventer
+static bool validKnots(const vector<float>& knots, int controlCount, int degree)
+{
+    if (knots.size() != static_cast<size_t>(controlCount + degree + 1) || !is_sorted(knots.begin(), knots.end()))
+    {
+        return false;
+    }
+    return knots[0] == knots[degree] && knots[controlCount] == knots.back() && knots[degree] < knots[controlCount];
+}
+
+//Parameteren til en koordinat, med samme skalering som Surface::calculateSurfacePoint: 0 til 1 over området
+//blir knots.front() til knots[controlCount]
+struct ParameterAxis
+{
+    const vector<float>* knots;
+    int controlCount;
+    int degree;
+    float minCoordinate, maxCoordinate;
+
+    double parameter(float coordinate) const
+    {
+        double s = (static_cast<double>(coordinate) - minCoordinate) / (static_cast<double>(maxCoordinate) - minCoordinate);
+        return knots->front() + s * ((*knots)[controlCount] - knots->front());
+    }
+
+    //Intervallet og de degree + 1 basisfunksjonene som ikke er null i coordinate
+    int basis(float coordinate, double* values) const
+    {
+        double t = parameter(coordinate);
+        int span = findKnotSpan(*knots, degree, controlCount, static_cast<float>(t));
+        basisFunctionsAt(*knots, span, degree, t, values);
+        return span;
+    }
+
+    float controlCoordinate(int i) const
+    {
+        double s = (grevilleAbscissa(*knots, degree, i) - knots->front()) / ((*knots)[controlCount] - knots->front());
+        return static_cast<float>(minCoordinate + s * (static_cast<double>(maxCoordinate) - minCoordinate));
+    }
+};
+
+FittedSurface fitBSplineSurface(const vector<glm::vec3>& points, const SurfaceFitSettings& settings)
+{
+    FittedSurface fit;
+    int p = min(max(settings.degree, 2), 3);
+    int widthU = max(settings.widthU, p + 1);
+    int widthV = max(settings.widthV, p + 1);
+    unsigned int threadCount = settings.threadCount == 0 ? workerCount() : settings.threadCount;
+
+    fit.degree = p;
+    fit.widthU = widthU;
+    fit.widthV = widthV;
+    fit.knotU = validKnots(settings.knotU, widthU, p) ? settings.knotU : clampedUniformKnots(widthU, p);
+    fit.knotV = validKnots(settings.knotV, widthV, p) ? settings.knotV : clampedUniformKnots(widthV, p);
+
+    //Området er boksen rundt punktene hvis det ikke er gitt
+    fit.minCorner = settings.minCorner;
+    fit.maxCorner = settings.maxCorner;
+    if (fit.minCorner == fit.maxCorner && !points.empty())
+    {
+        fit.minCorner = fit.maxCorner = glm::vec2(points[0]);
+        for (const auto& point : points)
+        {
+            fit.minCorner = glm::min(fit.minCorner, glm::vec2(point));
+            fit.maxCorner = glm::max(fit.maxCorner, glm::vec2(point));
+        }
+    }
+    if (fit.maxCorner.x <= fit.minCorner.x || fit.maxCorner.y <= fit.minCorner.y)
+    {
+        return FittedSurface();
+    }
+    glm::vec2 minCorner = fit.minCorner, maxCorner = fit.maxCorner;
+    auto inside = [&](const glm::vec3& point)
+    {
+        return point.x >= minCorner.x && point.x <= maxCorner.x && point.y >= minCorner.y && point.y <= maxCorner.y;
+    };
+
+    ParameterAxis axisU = { &fit.knotU, widthU, p, minCorner.x, maxCorner.x };
+    ParameterAxis axisV = { &fit.knotV, widthV, p, minCorner.y, maxCorner.y };
+
+    //Gjennomsnittshøyden trekkes fra, så systemet løses for avviket fra den. Basisfunksjonene summerer til 1 og R
+    //straffer ikke en konstant, så løsningen flyttes bare tilbake etterpå. Hver tråd summerer lokalt og skriver
+    //summen én gang, siden elementene i partCounts og partSums ligger på de samme cache-linjene.
+    vector<size_t> partCounts(threadCount, 0);
+    vector<double> partSums(threadCount, 0.0);
+    parallelFor(points.size(), threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        size_t count = 0;
+        double sum = 0.0;
+        for (size_t k = begin; k < end; ++k)
+        {
+            if (inside(points[k]))
+            {
+                ++count;
+                sum += points[k].z;
+            }
+        }
+        partCounts[part] = count;
+        partSums[part] = sum;
+    });
+    size_t used = 0;
+    double zSum = 0.0;
+    for (unsigned int part = 0; part < threadCount; ++part)
+    {
+        used += partCounts[part];
+        zSum += partSums[part];
+    }
+    if (used < 3)
+    {
+        return FittedSurface();
+    }
+    double meanZ = zSum / static_cast<double>(used);
+
+    //A^T A lagres som et stensil: for hvert kontrollpunkt de (2p + 1)^2 naboene det kan ha felles punkter med
+    int n = widthU * widthV;
+    int stencilWidth = 2 * p + 1;
+    int stencilSize = stencilWidth * stencilWidth;
+    vector<vector<double>> partNormals(threadCount);
+    vector<vector<double>> partRight(threadCount);
+    parallelFor(points.size(), threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        vector<double>& normal = partNormals[part];
+        vector<double>& right = partRight[part];
+        normal.assign(static_cast<size_t>(n) * stencilSize, 0.0);
+        right.assign(n, 0.0);
+        double basisU[4], basisV[4];
+        for (size_t k = begin; k < end; ++k)
+        {
+            const glm::vec3& point = points[k];
+            if (!inside(point))
+            {
+                continue;
+            }
+            int firstU = axisU.basis(point.x, basisU) - p;
+            int firstV = axisV.basis(point.y, basisV) - p;
+            double z = point.z - meanZ;
+            for (int b = 0; b <= p; ++b)
+            {
+                for (int a = 0; a <= p; ++a)
+                {
+                    double weight = basisU[a] * basisV[b];
+                    int row = (firstV + b) * widthU + firstU + a;
+                    right[row] += weight * z;
+                    double* rowValues = &normal[static_cast<size_t>(row) * stencilSize];
+                    for (int d = 0; d <= p; ++d)
+                    {
+                        double weightV = weight * basisV[d];
+                        double* stencilRow = rowValues + (d - b + p) * stencilWidth + p - a;
+                        for (int c = 0; c <= p; ++c)
+                        {
+                            stencilRow[c] += weightV * basisU[c];
+                        }
+                    }
+                }
+            }
+        }
+    });
+
+    //Legger sammen kopiene fra trådene. Trådene uten punkter har tomme tabeller.
+    vector<double> normal(static_cast<size_t>(n) * stencilSize, 0.0);
+    vector<double> right(n, 0.0);
+    parallelFor(n, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (unsigned int part = 0; part < threadCount; ++part)
+        {
+            if (partNormals[part].empty())
+            {
+                continue;
+            }
+            for (size_t row = begin; row < end; ++row)
+            {
+                right[row] += partRight[part][row];
+                for (int s = 0; s < stencilSize; ++s)
+                {
+                    normal[row * stencilSize + s] += partNormals[part][row * stencilSize + s];
+                }
+            }
+        }
+    });
+    partNormals.clear();
+    partRight.clear();
+
+    //Glatting: summen av kvadratene av de andrederiverte i u, v og den blandede (ganger 2) over kontrollnettet.
+    //Hvert ledd er en differanse av noen få naboer, og bidraget til matrisen er produktet av koeffisientene.
+    double lambda = settings.smoothing * max(1.0, static_cast<double>(used) / n);
+    auto addDifference = [&](const int (*offsets)[2], const double* coefficients, int count, double weight)
+    {
+        int maxU = 0, maxV = 0;
+        for (int k = 0; k < count; ++k)
+        {
+            maxU = max(maxU, offsets[k][0]);
+            maxV = max(maxV, offsets[k][1]);
+        }
+        for (int j = 0; j + maxV < widthV; ++j)
+        {
+            for (int i = 0; i + maxU < widthU; ++i)
+            {
+                for (int a = 0; a < count; ++a)
+                {
+                    int row = (j + offsets[a][1]) * widthU + i + offsets[a][0];
+                    for (int b = 0; b < count; ++b)
+                    {
+                        int du = offsets[b][0] - offsets[a][0];
+                        int dv = offsets[b][1] - offsets[a][1];
+                        normal[static_cast<size_t>(row) * stencilSize + (dv + p) * stencilWidth + du + p] +=
+                            weight * coefficients[a] * coefficients[b];
+                    }
+                }
+            }
+        }
+    };
+    const int offsetsUU[3][2] = { { 0, 0 }, { 1, 0 }, { 2, 0 } };
+    const int offsetsVV[3][2] = { { 0, 0 }, { 0, 1 }, { 0, 2 } };
+    const int offsetsUV[4][2] = { { 0, 0 }, { 1, 0 }, { 0, 1 }, { 1, 1 } };
+    const double secondDifference[3] = { 1.0, -2.0, 1.0 };
+    const double mixedDifference[4] = { 1.0, -1.0, -1.0, 1.0 };
+    addDifference(offsetsUU, secondDifference, 3, lambda);
+    addDifference(offsetsVV, secondDifference, 3, lambda);
+    addDifference(offsetsUV, mixedDifference, 4, 2.0 * lambda);
+
+    //Stensilet gjøres om til CSR uten naboene som ligger utenfor kontrollnettet
+    SparseMatrix matrix;
+    matrix.rows = n;
+    matrix.rowStart.reserve(n + 1);
+    matrix.columns.reserve(static_cast<size_t>(n) * stencilSize);
+    matrix.values.reserve(static_cast<size_t>(n) * stencilSize);
+    matrix.rowStart.push_back(0);
+    for (int j = 0; j < widthV; ++j)
+    {
+        for (int i = 0; i < widthU; ++i)
+        {
+            size_t row = static_cast<size_t>(j) * widthU + i;
+            for (int dv = -p; dv <= p; ++dv)
+            {
+                for (int du = -p; du <= p; ++du)
+                {
+                    if (i + du < 0 || i + du >= widthU || j + dv < 0 || j + dv >= widthV)
+                    {
+                        continue;
+                    }
+                    matrix.columns.push_back(static_cast<uint32_t>((j + dv) * widthU + i + du));
+                    matrix.values.push_back(normal[row * stencilSize + (dv + p) * stencilWidth + du + p]);
+                }
+            }
+            matrix.rowStart.push_back(static_cast<uint32_t>(matrix.values.size()));
+        }
+    }
+    normal.clear();
+    normal.shrink_to_fit();
+
+    vector<double> heights(n, 0.0);
+    SolverResult solved = solveConjugateGradient(matrix, right, heights, settings.maxIterations, settings.tolerance,
+        threadCount);
+    fit.iterations = solved.iterations;
+    fit.converged = solved.converged;
+    fit.pointsUsed = used;
+
+    fit.controlPoints.resize(n);
+    for (int j = 0; j < widthV; ++j)
+    {
+        float y = axisV.controlCoordinate(j);
+        for (int i = 0; i < widthU; ++i)
+        {
+            fit.controlPoints[j * widthU + i] = glm::vec3(axisU.controlCoordinate(i), y,
+                static_cast<float>(heights[j * widthU + i] + meanZ));
+        }
+    }
+
+    //Avviket mellom flaten og punktene
+    vector<double> partErrors(threadCount, 0.0);
+    parallelFor(points.size(), threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        double basisU[4], basisV[4];
+        double squaredErrors = 0.0;
+        for (size_t k = begin; k < end; ++k)
+        {
+            const glm::vec3& point = points[k];
+            if (!inside(point))
+            {
+                continue;
+            }
+            int firstU = axisU.basis(point.x, basisU) - p;
+            int firstV = axisV.basis(point.y, basisV) - p;
+            double z = 0.0;
+            for (int b = 0; b <= p; ++b)
+            {
+                for (int a = 0; a <= p; ++a)
+                {
+                    z += basisU[a] * basisV[b] * heights[(firstV + b) * widthU + firstU + a];
+                }
+            }
+            double error = z + meanZ - point.z;
+            squaredErrors += error * error;
+        }
+        partErrors[part] = squaredErrors;
+    });
+    double errorSum = 0.0;
+    for (double error : partErrors)
+    {
+        errorSum += error;
+    }
+    fit.rmsError = static_cast<float>(sqrt(errorSum / static_cast<double>(used)));
+    return fit;
+}
@@ -0,0 +1,67 @@
+#ifndef SURFACEFITTER_H
+#define SURFACEFITTER_H
+
+#include <vector>
+#include <glm/glm.hpp>
+#include "Surface.h"
+
+using namespace std;
+
+//Innstillingene til fitBSplineSurface
+struct SurfaceFitSettings
+{
+    //Antall kontrollpunkter i u (x) og v (y) retning
+    int widthU = 32;
+    int widthV = 32;
+    //2 gir en bikvadratisk og 3 en bikubisk flate
+    int degree = 2;
+    //Skjøtvektorene. Tomme (eller med feil lengde, widthU + degree + 1) betyr clampedUniformKnots.
+    vector<float> knotU, knotV;
+    //Hvor glatt flaten skal være. Vekten på de andrederiverte til kontrollnettet, skalert med antall punkter per
+    //kontrollpunkt, så samme verdi gir omtrent samme glatthet uansett hvor tett punktene ligger.
+    float smoothing = 1e-3f;
+    //Området i xy som flaten dekker. Like hjørner betyr boksen rundt punktene. Punkter utenfor brukes ikke.
+    glm::vec2 minCorner = glm::vec2(0.0f);
+    glm::vec2 maxCorner = glm::vec2(0.0f);
+    int maxIterations = 1000;
+    double tolerance = 1e-6;
+    //0 betyr workerCount()
+    unsigned int threadCount = 0;
+};
+
+//Flaten fitBSplineSurface fant, i samme format som Surface tar
+struct FittedSurface
+{
+    vector<glm::vec3> controlPoints;
+    int widthU = 0;
+    int widthV = 0;
+    int degree = 2;
+    vector<float> knotU, knotV;
+    glm::vec2 minCorner = glm::vec2(0.0f);
+    glm::vec2 maxCorner = glm::vec2(0.0f);
+    //Antall punkter som ble brukt og kvadratisk middelavvik i z mellom flaten og punktene
+    size_t pointsUsed = 0;
+    float rmsError = 0.0f;
+    int iterations = 0;
+    bool converged = false;
+
+    bool empty() const { return controlPoints.empty(); }
+    //Surface(u, v) med u og v fra 0 til 1 over minCorner til maxCorner
+    Surface toSurface() const;
+};
+
+//Tilpasser en tensorprodukt B-spline flate til punktene med minste kvadraters metode. Kontrollpunktene ligger i
+//et fast rutenett i xy (Greville-abscissene), slik at flaten er en høydefunksjon der u og v er lineære i x og y,
+//og bare z til kontrollpunktene er ukjente. Da blir det ett lineært system for alle z:
+//
+//    (A^T A + lambda R) c = A^T z
+//
+//der rad k i A er basisfunksjonene i punkt k og R straffer de andrederiverte til kontrollnettet (som en tynn
+//plate), så områder uten punkter fylles glatt. Hvert kontrollpunkt påvirker bare (2 * degree + 1)^2 naboer, så
+//matrisen er glissen og løses med konjugerte gradienter (SparseSolver.h).
+//
+//A^T A bygges parallelt med én kopi per tråd som legges sammen til slutt. Millioner av punkter blir dermed
+//noen tusen tall.
+FittedSurface fitBSplineSurface(const vector<glm::vec3>& points, const SurfaceFitSettings& settings);
+
+#endif
@@ -0,0 +1,345 @@
+#include "TileCatalog.h"
+#include "PointCloudCache.h"
+#include "LasReader.h"
+#include "Parallel.h"
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <filesystem>
+#include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <cstring>
+#include <limits>
+
+const char* TileCatalog::indexFilename = "tiles.idx";
+
+//Første linje i indeksfilen. Økes hvis formatet endres.
+static const char* indexHeader = "TileCatalog 1";
+
+TileCatalog::TileCatalog(const PointTransform& transform) : transform(transform) {}
+
+bool TileCatalog::isTileFile(const string& filename)
+{
+    string extension = filesystem::path(filename).extension().string();
+    for (auto& c : extension)
+    {
+        c = static_cast<char>(tolower(static_cast<unsigned char>(c)));
+    }
+    if (extension == ".las")
+    {
+        return true;
+    }
+    return extension == ".txt" && isPointTextFile(filename);
+}
+
+//Leser bare de to første linjene, så andre tekstfiler i mappen (f.eks notater eller en liste over tall)
+//blir ikke lest som fliser
+bool TileCatalog::isPointTextFile(const string& filename)
+{
+    ifstream file(filename);
+    string line;
+    if (!file || !getline(file, line))
+    {
+        return false;
+    }
+
+    istringstream countLine(line);
+    long long count = -1;
+    string rest;
+    countLine >> count;
+    if (!countLine || count < 0 || (countLine >> rest))
+    {
+        return false;
+    }
+    if (!getline(file, line))
+    {
+        return count == 0;
+    }
+
+    istringstream pointLine(line);
+    double x, y, z;
+    pointLine >> x >> y >> z;
+    return static_cast<bool>(pointLine) && !(pointLine >> rest);
+}
+
+//Noen programmer skriver ikke boksen i headeren. Da returneres false, og filen må leses for å finne boksen.
+bool TileCatalog::readLasBounds(TileInfo& tile) const
+{
+    LasReader reader;
+    if (!reader.open(tile.filename))
+    {
+        return false;
+    }
+    glm::dvec3 headerMin = reader.headerMinBounds();
+    glm::dvec3 headerMax = reader.headerMaxBounds();
+    if (reader.pointCount() > 0 && headerMin == headerMax)
+    {
+        return false;
+    }
+    glm::vec3 first = transform.apply(headerMin.x, headerMin.y, headerMin.z);
+    glm::vec3 second = transform.apply(headerMax.x, headerMax.y, headerMax.z);
+    tile.pointCount = static_cast<size_t>(reader.pointCount());
+    tile.minBounds = glm::min(first, second);
+    tile.maxBounds = glm::max(first, second);
+    return true;
+}
+
+bool TileCatalog::scan(const string& directory)
+{
+    auto startTime = chrono::steady_clock::now();
+    tiles.clear();
+
+    error_code error;
+    filesystem::directory_iterator entries(directory, error);
+    if (error)
+    {
+        cout << "Kunne ikke lese mappen: " << directory << endl;
+        return false;
+    }
+
+    vector<string> filenames;
+    for (const auto& entry : entries)
+    {
+        if (entry.is_regular_file(error) && isTileFile(entry.path().string()))
+        {
+            filenames.push_back(entry.path().filename().string());
+        }
+    }
+    sort(filenames.begin(), filenames.end());
+
+    //Flisene som allerede står i indeksfilen, slått opp på filnavn
+    string indexPath = (filesystem::path(directory) / indexFilename).string();
+    vector<TileInfo> indexedTiles;
+    readIndex(indexPath, indexedTiles);
+    unordered_map<string, const TileInfo*> indexed;
+    for (const auto& tile : indexedTiles)
+    {
+        indexed[tile.filename] = &tile;
+    }
+
+    vector<TileInfo> found(filenames.size());
+    vector<char> upToDate(filenames.size(), 0);
+    for (size_t i = 0; i < filenames.size(); ++i)
+    {
+        found[i].filename = (filesystem::path(directory) / filenames[i]).string();
+        found[i].fingerprint = PointCloudCache::fingerprintFile(found[i].filename);
+        auto match = indexed.find(filenames[i]);
+        if (match != indexed.end() && match->second->fingerprint == found[i].fingerprint)
+        {
+            found[i].pointCount = match->second->pointCount;
+            found[i].minBounds = match->second->minBounds;
+            found[i].maxBounds = match->second->maxBounds;
+            upToDate[i] = 1;
+        }
+    }
+
+    //Nye og endrede tekstfiler leses parallelt, én tråd per fil. Cachen blir skrevet samtidig, slik at de lastes
+    //raskt senere. LAS-filene har boksen og antall punkter i headeren og blir bare lest her hvis boksen mangler.
+    vector<size_t> changed;
+    for (size_t i = 0; i < found.size(); ++i)
+    {
+        if (!upToDate[i])
+        {
+            changed.push_back(i);
+        }
+    }
+
+    parallelForEach(changed.size(), workerCount(), [&](size_t c)
+    {
+        TileInfo& tile = found[changed[c]];
+        if (LasReader::isLasFile(tile.filename) && readLasBounds(tile))
+        {
+            return;
+        }
+        PointCloud cloud = loadTile(tile.filename, transform, 1);
+        tile.pointCount = cloud.size();
+        tile.minBounds = cloud.minBounds;
+        tile.maxBounds = cloud.maxBounds;
+    });
+
+    //Filer uten punkter (f.eks andre tekstfiler i mappen) er ikke fliser
+    for (auto& tile : found)
+    {
+        if (tile.pointCount > 0)
+        {
+            tiles.push_back(move(tile));
+        }
+    }
+
+    if (!changed.empty() || indexedTiles.size() != tiles.size())
+    {
+        writeIndex(indexPath);
+    }
+
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    cout << "Fant " << tiles.size() << " fliser i " << directory << " (" << changed.size()
+        << " lest på nytt) på " << seconds * 1000.0 << " ms" << endl;
+    return true;
+}
+
+vector<TileInfo> TileCatalog::tilesOverlapping(const glm::vec2& minXY, const glm::vec2& maxXY) const
+{
+    vector<TileInfo> overlapping;
+    for (const auto& tile : tiles)
+    {
+        if (tile.minBounds.x <= maxXY.x && tile.maxBounds.x >= minXY.x &&
+            tile.minBounds.y <= maxXY.y && tile.maxBounds.y >= minXY.y)
+        {
+            overlapping.push_back(tile);
+        }
+    }
+    return overlapping;
+}
+
+PointCloud TileCatalog::loadTile(const string& filename, const PointTransform& transform, unsigned int threadCount)
+{
+    PointCloud cloud;
+    if (PointCloudCache::load(filename, transform, cloud))
+    {
+        return cloud;
+    }
+
+    cloud = LasReader::isLasFile(filename) ? LasReader::loadFile(filename, transform)
+        : PointCloudLoader::loadTextFile(filename, transform, nullptr, threadCount);
+    if (!cloud.empty())
+    {
+        PointCloudCache::save(filename, transform, cloud);
+    }
+    return cloud;
+}
+
+//Hver flis leses av sin egen tråd med én tråd til innlesingen, slik at tiden avhenger av antall kjerner
+//og ikke av antall fliser. Når alle er lest kopieres de parallelt inn i den felles punktskyen.
+PointCloud TileCatalog::loadTiles(const vector<TileInfo>& selectedTiles, LoadStatistics* statistics) const
+{
+    auto startTime = chrono::steady_clock::now();
+    unsigned int threadCount = static_cast<unsigned int>(min<size_t>(workerCount(), max<size_t>(selectedTiles.size(), 1)));
+
+    vector<PointCloud> clouds(selectedTiles.size());
+    parallelForEach(selectedTiles.size(), threadCount, [&](size_t i)
+    {
+        clouds[i] = loadTile(selectedTiles[i].filename, transform, 1);
+    });
+
+    vector<size_t> offsets(clouds.size() + 1, 0);
+    size_t bytes = 0;
+    for (size_t i = 0; i < clouds.size(); ++i)
+    {
+        offsets[i + 1] = offsets[i] + clouds[i].size();
+        bytes += clouds[i].size() * 3 * sizeof(float);
+    }
+
+    PointCloud merged;
+    merged.resize(offsets.back());
+    bool first = true;
+    for (const auto& cloud : clouds)
+    {
+        if (cloud.empty())
+        {
+            continue;
+        }
+        merged.minBounds = first ? cloud.minBounds : glm::min(merged.minBounds, cloud.minBounds);
+        merged.maxBounds = first ? cloud.maxBounds : glm::max(merged.maxBounds, cloud.maxBounds);
+        first = false;
+    }
+
+    parallelForEach(clouds.size(), threadCount, [&](size_t i)
+    {
+        size_t count = clouds[i].size();
+        if (count > 0)
+        {
+            memcpy(merged.writableX() + offsets[i], clouds[i].x(), count * sizeof(float));
+            memcpy(merged.writableY() + offsets[i], clouds[i].y(), count * sizeof(float));
+            memcpy(merged.writableZ() + offsets[i], clouds[i].z(), count * sizeof(float));
+        }
+        clouds[i] = PointCloud();
+    });
+
+    LoadStatistics result;
+    result.pointCount = merged.size();
+    result.bytes = bytes;
+    result.seconds = chrono::duration<double>(chrono::steady_clock::now() - startTime).count();
+    result.threads = threadCount;
+    cout << "Leste " << selectedTiles.size() << " fliser med " << result.pointCount << " punkter på "
+        << result.seconds * 1000.0 << " ms med " << result.threads << " tråder" << endl;
+
+    if (statistics != nullptr)
+    {
+        *statistics = result;
+    }
+    return merged;
+}
+
+//Indeksfilen er en tekstfil. Etter headeren kommer transformasjonen, og deretter én linje per flis:
+//fingeravtrykk, antall punkter, minBounds, maxBounds og til slutt filnavnet (som kan inneholde mellomrom).
+bool TileCatalog::readIndex(const string& indexPath, vector<TileInfo>& indexedTiles) const
+{
+    ifstream file(indexPath);
+    if (!file)
+    {
+        return false;
+    }
+
+    string line;
+    if (!getline(file, line) || line != indexHeader)
+    {
+        return false;
+    }
+
+    //En indeks laget med en annen transformasjon har bokser i et annet koordinatsystem
+    glm::dvec3 scale, offset;
+    if (!getline(file, line))
+    {
+        return false;
+    }
+    istringstream transformLine(line);
+    string label;
+    transformLine >> label >> scale.x >> scale.y >> scale.z >> offset.x >> offset.y >> offset.z;
+    if (!transformLine || label != "transform" || scale != transform.scale || offset != transform.offset)
+    {
+        return false;
+    }
+
+    while (getline(file, line))
+    {
+        istringstream fields(line);
+        TileInfo tile;
+        fields >> tile.fingerprint >> tile.pointCount
+            >> tile.minBounds.x >> tile.minBounds.y >> tile.minBounds.z
+            >> tile.maxBounds.x >> tile.maxBounds.y >> tile.maxBounds.z;
+        fields >> ws;
+        getline(fields, tile.filename);
+        if (!fields || tile.filename.empty())
+        {
+            continue;
+        }
+        indexedTiles.push_back(tile);
+    }
+    return true;
+}
+
+bool TileCatalog::writeIndex(const string& indexPath) const
+{
+    ofstream file(indexPath, ios::trunc);
+    if (!file)
+    {
+        cout << "Kunne ikke skrive indeksfilen: " << indexPath << endl;
+        return false;
+    }
+
+    file.precision(numeric_limits<double>::max_digits10);
+    file << indexHeader << "\n";
+    file << "transform " << transform.scale.x << " " << transform.scale.y << " " << transform.scale.z << " "
+        << transform.offset.x << " " << transform.offset.y << " " << transform.offset.z << "\n";
+
+    file.precision(numeric_limits<float>::max_digits10);
+    for (const auto& tile : tiles)
+    {
+        file << tile.fingerprint << " " << tile.pointCount << " "
+            << tile.minBounds.x << " " << tile.minBounds.y << " " << tile.minBounds.z << " "
+            << tile.maxBounds.x << " " << tile.maxBounds.y << " " << tile.maxBounds.z << " "
+            << filesystem::path(tile.filename).filename().string() << "\n";
+    }
+    return static_cast<bool>(file);
+}
@@ -0,0 +1,65 @@
+#ifndef TILECATALOG_H
+#define TILECATALOG_H
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "PointCloud.h"
+#include "PointCloudLoader.h"
+
+using namespace std;
+
+//Det katalogen vet om en flis (en punktskyfil) uten å lese den: antall punkter og boksen rundt punktene,
+//i koordinatene til scenen. fingerprint brukes til å se om filen har endret seg siden den ble lest.
+struct TileInfo
+{
+    string filename;
+    uint64_t fingerprint = 0;
+    size_t pointCount = 0;
+    glm::vec3 minBounds = glm::vec3(0.0f);
+    glm::vec3 maxBounds = glm::vec3(0.0f);
+};
+
+//Katalog over alle flisene (f.eks 32-2-517-155-12.txt) i en mappe. Boksene og antall punkter lagres i en
+//indeksfil i mappen, slik at bare nye eller endrede filer må leses neste gang mappen skannes.
+//Alle flisene bruker samme transformasjon og havner derfor i samme koordinatsystem.
+class TileCatalog
+{
+public:
+    //Navnet på indeksfilen som skrives i mappen som skannes
+    static const char* indexFilename;
+
+    TileCatalog(const PointTransform& transform);
+
+    //Finner alle flisene i mappen: .las-filer og .txt-filer i punktformatet til prosjektet (antall punkter på
+    //første linje og x y z på linjene etter). Filer som står i indeksfilen med samme fingeravtrykk brukes som de
+    //er. For nye og endrede LAS-filer hentes boksen og antall punkter fra headeren, og punktene leses først når
+    //flisen lastes. Tekstfilene har ingen header og leses parallelt (én tråd per fil). Indeksfilen skrives på nytt.
+    bool scan(const string& directory);
+
+    const vector<TileInfo>& getTiles() const { return tiles; }
+
+    //Flisene der boksen overlapper rektangelet minXY-maxXY i xy-planet
+    vector<TileInfo> tilesOverlapping(const glm::vec2& minXY, const glm::vec2& maxXY) const;
+
+    //Leser flisene parallelt, én tråd per flis, og setter dem sammen til én punktsky
+    PointCloud loadTiles(const vector<TileInfo>& selectedTiles, LoadStatistics* statistics = nullptr) const;
+
+    //Leser én flis fra cachen hvis den finnes, ellers fra LAS- eller tekstfilen, som så lagres i cachen
+    static PointCloud loadTile(const string& filename, const PointTransform& transform, unsigned int threadCount = 0);
+
+private:
+    bool readIndex(const string& indexPath, vector<TileInfo>& indexedTiles) const;
+    bool writeIndex(const string& indexPath) const;
+    static bool isTileFile(const string& filename);
+    //Første linje er ett heltall (antall punkter) og andre linje tre tall
+    static bool isPointTextFile(const string& filename);
+    //Antall punkter og boksen fra headeren til LAS-filen, gjort om med transform
+    bool readLasBounds(TileInfo& tile) const;
+
+    PointTransform transform;
+    vector<TileInfo> tiles;
+};
+
+#endif
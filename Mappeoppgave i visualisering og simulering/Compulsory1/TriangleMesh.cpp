@@ -0,0 +1,103 @@
+#include "TriangleMesh.h"
+#include "RadixSort.h"
+#include "Parallel.h"
+#include <algorithm>
+
+TriangleMesh::TriangleMesh() {}
+
+TriangleMesh::TriangleMesh(size_t vertexCount, vector<glm::ivec3> triangles, vector<glm::ivec3> neighbours)
+    : triangles(move(triangles)), neighbours(move(neighbours))
+{
+    findVertexTriangles(vertexCount);
+}
+
+void TriangleMesh::clear()
+{
+    triangles.clear();
+    neighbours.clear();
+    vertexTriangles.clear();
+}
+
+//Hver halvkant (a, b) får nøkkelen a * vertexCount + b. Etter sorteringen finnes kanten (b, a) i trekanten
+//på andre siden med binærsøk.
+void TriangleMesh::build(size_t vertexCount, vector<glm::ivec3> newTriangles, unsigned int threadCount)
+{
+    if (threadCount == 0)
+    {
+        threadCount = workerCount();
+    }
+    triangles = move(newTriangles);
+    size_t halfEdgeCount = triangles.size() * 3;
+    vector<uint64_t> keys(halfEdgeCount);
+    vector<uint32_t> halfEdges(halfEdgeCount);
+    parallelFor(triangles.size(), threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            for (int i = 0; i < 3; ++i)
+            {
+                uint64_t a = static_cast<uint32_t>(triangles[t][(i + 1) % 3]);
+                uint64_t b = static_cast<uint32_t>(triangles[t][(i + 2) % 3]);
+                keys[t * 3 + i] = a * vertexCount + b;
+                halfEdges[t * 3 + i] = static_cast<uint32_t>(t * 3 + i);
+            }
+        }
+    });
+    parallelRadixSort(keys, halfEdges, bitWidth(static_cast<uint64_t>(vertexCount) * vertexCount), threadCount);
+
+    neighbours.assign(triangles.size(), glm::ivec3(-1));
+    parallelFor(halfEdgeCount, threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t k = begin; k < end; ++k)
+        {
+            uint64_t a = keys[k] / vertexCount;
+            uint64_t b = keys[k] % vertexCount;
+            uint64_t twin = b * vertexCount + a;
+            auto found = lower_bound(keys.begin(), keys.end(), twin);
+            if (found != keys.end() && *found == twin)
+            {
+                uint32_t halfEdge = halfEdges[k];
+                neighbours[halfEdge / 3][halfEdge % 3] = static_cast<int>(halfEdges[found - keys.begin()] / 3);
+            }
+        }
+    });
+
+    findVertexTriangles(vertexCount);
+}
+
+void TriangleMesh::findVertexTriangles(size_t vertexCount)
+{
+    vertexTriangles.assign(vertexCount, -1);
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            vertexTriangles[triangles[t][i]] = static_cast<int>(t);
+        }
+    }
+
+    //Punkter på randen: gå med klokka til trekanten som har randkanten
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (neighbours[t][i] >= 0)
+            {
+                continue;
+            }
+            //Kanten motsatt hjørne i er på randen. Hjørne i + 1 har den som første kant mot klokka.
+            vertexTriangles[triangles[t][(i + 1) % 3]] = static_cast<int>(t);
+        }
+    }
+}
+
+bool TriangleMesh::isBoundaryVertex(int vertex) const
+{
+    int t = vertexTriangles[vertex];
+    if (t < 0)
+    {
+        return false;
+    }
+    int corner = cornerOf(t, vertex);
+    return neighbours[t][(corner + 2) % 3] < 0;
+}
@@ -0,0 +1,146 @@
+#ifndef TRIANGLEMESH_H
+#define TRIANGLEMESH_H
+
+#include <vector>
+#include <cstdint>
+#include <glm/glm.hpp>
+#include "Predicates.h"
+
+using namespace std;
+
+//Trekantnett der hver trekant vet hvilke trekanter som er naboene, lagret i tabeller som ligger tett i minnet.
+//Trekant t har hjørnene triangles[t] mot klokka. neighbours[t][i] er trekanten på andre siden av kanten motsatt
+//hjørne i (fra hjørne i + 1 til hjørne i + 2), eller -1 hvis kanten ligger på randen.
+//For hvert hjørne lagres én trekant det er med i. For hjørner på randen er det trekanten lengst med klokka, så
+//en runde mot klokka fra den trekanten går gjennom alle trekantene rundt hjørnet.
+//
+//Alt naboarbeid (trekantene og punktene rundt et punkt, naboen over en kant, å gå fra trekant til trekant mot
+//et punkt) tar da tid proporsjonal med svaret, uten å søke gjennom alle trekantene eller bygge egne tabeller.
+class TriangleMesh
+{
+public:
+    TriangleMesh();
+
+    //Lager nettet fra trekanter og naboer som trianguleringen allerede har regnet ut
+    TriangleMesh(size_t vertexCount, vector<glm::ivec3> triangles, vector<glm::ivec3> neighbours);
+
+    //Lager nettet fra trekantene alene. Naboene finnes ved å sortere kantene (parallell radix sortering).
+    //Trekantene må være orientert likt, og hver kant kan bare være med i to trekanter.
+    void build(size_t vertexCount, vector<glm::ivec3> triangles, unsigned int threadCount = 0);
+
+    void clear();
+
+    size_t vertexCount() const { return vertexTriangles.size(); }
+    size_t triangleCount() const { return triangles.size(); }
+    const vector<glm::ivec3>& getTriangles() const { return triangles; }
+    const vector<glm::ivec3>& getNeighbours() const { return neighbours; }
+    const glm::ivec3& triangle(int t) const { return triangles[t]; }
+    //Trekanten på andre siden av kanten motsatt hjørne i i trekant t, eller -1 på randen
+    int neighbour(int t, int i) const { return neighbours[t][i]; }
+    //En trekant som har vertex som hjørne, eller -1 hvis punktet ikke er med i noen trekant
+    int vertexTriangle(int vertex) const { return vertexTriangles[vertex]; }
+    //Hvilket hjørne (0, 1 eller 2) vertex er i trekant t
+    int cornerOf(int t, int vertex) const { return triangles[t].x == vertex ? 0 : (triangles[t].y == vertex ? 1 : 2); }
+    bool isBoundaryVertex(int vertex) const;
+
+    //Kaller function(t, corner) for hver trekant rundt vertex, mot klokka. corner er hjørnet vertex har i t.
+    template <class Function>
+    void forEachTriangleAround(int vertex, Function function) const
+    {
+        int start = vertexTriangles[vertex];
+        if (start < 0)
+        {
+            return;
+        }
+        int t = start;
+        do
+        {
+            int corner = cornerOf(t, vertex);
+            function(t, corner);
+            //Neste trekant mot klokka deler kanten fra vertex til hjørnet før vertex
+            t = neighbours[t][(corner + 1) % 3];
+        } while (t >= 0 && t != start);
+    }
+
+    //Kaller function(neighbourVertex) for hvert punkt som har en kant til vertex, mot klokka
+    template <class Function>
+    void forEachVertexNeighbour(int vertex, Function function) const
+    {
+        int last = -1;
+        forEachTriangleAround(vertex, [&](int t, int corner)
+        {
+            function(triangles[t][(corner + 1) % 3]);
+            last = t;
+        });
+        //Rundt et punkt på randen har den siste trekanten et punkt til, på randkanten
+        if (last >= 0)
+        {
+            int corner = cornerOf(last, vertex);
+            if (neighbours[last][(corner + 1) % 3] < 0)
+            {
+                function(triangles[last][(corner + 2) % 3]);
+            }
+        }
+    }
+
+    //Går fra trekant til trekant mot punktet og returnerer trekanten punktet ligger i, eller -1 hvis punktet
+    //ligger utenfor nettet. position(vertex) gir xy til et hjørne som glm::dvec2. Nettet må være konvekst, slik
+    //som en Delaunay triangulering, ellers kan gangen stoppe på randen før den når punktet.
+    template <class PositionFunction>
+    int locate(const glm::dvec2& point, PositionFunction position, int startTriangle = 0) const
+    {
+        if (triangles.empty())
+        {
+            return -1;
+        }
+        int t = startTriangle >= 0 && startTriangle < static_cast<int>(triangles.size()) ? startTriangle : 0;
+        int previous = -1;
+        uint32_t randomState = 2463534242u;
+        for (size_t steps = 0; steps <= triangles.size(); ++steps)
+        {
+            randomState ^= randomState << 13;
+            randomState ^= randomState >> 17;
+            randomState ^= randomState << 5;
+            int first = static_cast<int>(randomState % 3);
+
+            int next = -1;
+            bool outside = false;
+            for (int k = 0; k < 3 && next < 0 && !outside; ++k)
+            {
+                int i = (first + k) % 3;
+                int across = neighbours[t][i];
+                if (across >= 0 && across == previous)
+                {
+                    continue;
+                }
+                const glm::ivec3& v = triangles[t];
+                if (orient2d(position(v[(i + 1) % 3]), position(v[(i + 2) % 3]), point) < 0.0)
+                {
+                    next = across;
+                    outside = across < 0;
+                }
+            }
+            if (outside)
+            {
+                return -1;
+            }
+            if (next < 0)
+            {
+                return t;
+            }
+            previous = t;
+            t = next;
+        }
+        return -1;
+    }
+
+private:
+    //Finner en trekant for hvert hjørne, og for hjørner på randen trekanten lengst med klokka
+    void findVertexTriangles(size_t vertexCount);
+
+    vector<glm::ivec3> triangles;
+    vector<glm::ivec3> neighbours;
+    vector<int> vertexTriangles;
+};
+
+#endif
@@ -0,0 +1,112 @@
+#ifndef VERTEXNORMALS_H
+#define VERTEXNORMALS_H
+
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/gtc/type_precision.hpp>
+#include "TriangleMesh.h"
+#include "Parallel.h"
+
+using namespace std;
+
+//Hvordan trekantene rundt et punkt veies når normalen i punktet regnes ut
+enum class NormalWeighting
+{
+    //Alle trekantene teller like mye (normalisert flatenormal)
+    Uniform,
+    //Store trekanter teller mest (kryssproduktet er to ganger arealet)
+    Area,
+    //Trekanten teller med vinkelen den har i punktet, så resultatet ikke avhenger av hvordan flaten er delt opp
+    Angle
+};
+
+//Bidraget fra én trekant til normalen i point, der next og previous er de to andre hjørnene mot klokka
+inline glm::vec3 cornerNormal(const glm::vec3& point, const glm::vec3& next, const glm::vec3& previous,
+    NormalWeighting weighting)
+{
+    glm::vec3 toNext = next - point;
+    glm::vec3 toPrevious = previous - point;
+    glm::vec3 normal = glm::cross(toNext, toPrevious);
+    if (weighting == NormalWeighting::Area)
+    {
+        return normal;
+    }
+    float length = glm::length(normal);
+    if (length == 0.0f)
+    {
+        return glm::vec3(0.0f);
+    }
+    if (weighting == NormalWeighting::Uniform)
+    {
+        return normal / length;
+    }
+    //atan2(|a x b|, a . b) er vinkelen mellom kantene, også for nesten rette vinkler der acos er unøyaktig
+    return normal * (atan2(length, glm::dot(toNext, toPrevious)) / length);
+}
+
+//Normaliserer summen av bidragene. Et punkt uten trekanter (eller bare flate trekanter) får normalen opp.
+inline glm::vec3 finishNormal(const glm::vec3& sum)
+{
+    float length = glm::length(sum);
+    return length > 0.0f ? sum / length : glm::vec3(0.0f, 0.0f, 1.0f);
+}
+
+//Regner ut normalen i hvert punkt i nettet og kaller store(i, normal). position(i) gir punkt i.
+//Hvert punkt summerer bidragene fra trekantene rundt seg (TriangleMesh::forEachTriangleAround) og skriver bare
+//sin egen normal, så punktene kan deles mellom trådene uten atomics eller egne summer for hver tråd.
+//0 tråder betyr workerCount().
+template <class PositionFunction, class StoreFunction>
+void computeVertexNormals(const TriangleMesh& mesh, size_t vertexCount, PositionFunction position,
+    StoreFunction store, NormalWeighting weighting, unsigned int threadCount = 0)
+{
+    parallelFor(vertexCount, threadCount == 0 ? workerCount() : threadCount, [&](size_t begin, size_t end, unsigned int)
+    {
+        for (size_t i = begin; i < end; ++i)
+        {
+            glm::vec3 sum(0.0f);
+            if (i < mesh.vertexCount())
+            {
+                glm::vec3 point = position(i);
+                mesh.forEachTriangleAround(static_cast<int>(i), [&](int t, int corner)
+                {
+                    const glm::ivec3& triangle = mesh.triangle(t);
+                    sum += cornerNormal(point, position(triangle[(corner + 1) % 3]), position(triangle[(corner + 2) % 3]),
+                        weighting);
+                });
+            }
+            store(i, finishNormal(sum));
+        }
+    });
+}
+
+//Oktaeder-koding av en enhetsvektor i to 16 bits heltall (4 bytes i stedet for 12). Vektoren projiseres på
+//oktaederet |x| + |y| + |z| = 1, og den nedre halvdelen brettes ut over hjørnene, så hele kula blir kvadratet
+//[-1, 1]^2. Feilen er under 0.05 grader. Den samme dekodingen gjøres i phongOctahedral.vert, der verdiene leses
+//som normaliserte GL_SHORT.
+//Referanse Cigolle mfl., "A Survey of Efficient Representations for Independent Unit Vectors" (2014)
+inline glm::i16vec2 encodeOctahedral(const glm::vec3& normal)
+{
+    glm::vec2 p = glm::vec2(normal) / (fabs(normal.x) + fabs(normal.y) + fabs(normal.z));
+    if (normal.z < 0.0f)
+    {
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(p.y, p.x));
+        p = glm::vec2(p.x >= 0.0f ? folded.x : -folded.x, p.y >= 0.0f ? folded.y : -folded.y);
+    }
+    glm::vec2 scaled = glm::round(glm::clamp(p, -1.0f, 1.0f) * 32767.0f);
+    return glm::i16vec2(static_cast<int16_t>(scaled.x), static_cast<int16_t>(scaled.y));
+}
+
+inline glm::vec3 decodeOctahedral(const glm::i16vec2& encoded)
+{
+    glm::vec2 p = glm::max(glm::vec2(encoded) / 32767.0f, -1.0f);
+    glm::vec3 normal(p.x, p.y, 1.0f - fabs(p.x) - fabs(p.y));
+    if (normal.z < 0.0f)
+    {
+        glm::vec2 folded = 1.0f - glm::abs(glm::vec2(p.y, p.x));
+        normal.x = p.x >= 0.0f ? folded.x : -folded.x;
+        normal.y = p.y >= 0.0f ? folded.y : -folded.y;
+    }
+    return glm::normalize(normal);
+}
+
+#endif
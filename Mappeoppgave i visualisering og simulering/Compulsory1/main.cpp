@@ -6,6 +6,7 @@
 #include <algorithm>
 #include <unordered_map> 
 #include <utility>  
+#include <memory>
 
 #include "glm/mat4x3.hpp"
 #include<glad/glad.h>
@@ -18,6 +19,8 @@
 #include "ShaderFileLoader.h"
 #include "Camera.h"
 #include "BilinearSurface.h"
+#include "ParallelDelaunay.h"
+#include "Parallel.h"
 #include "Surface.h"
 #include "Ball.h"
 #include "Octree.h"
@@ -39,17 +42,17 @@ GLfloat lastX = SCR_WIDTH / 2.0f;
 GLfloat lastY = SCR_HEIGHT / 2.0f;
 bool firstMouse = true;
 
-//Posisjonen p lyset til teksturen og phong-shaderen 
+//Posisjonen på lyset til teksturen og phong-shaderen 
 glm::vec3 sunPos(2.0f, 11.0f, 2.0f);
 
 
-//Grensene p B-Sline flaten. Ballene skal ikke rulle utenfor disse verdiene. 
+//Grensene på B-Sline flaten. Ballene skal ikke rulle utenfor disse verdiene. 
 float xMin = 2.04f;
 float xMax = 2.199f;
 float yMin = 11.64f;
 float yMax = 11.76f;
 
-//Ballene beveger seg ikke nr programmet starter og ballenes strrelse 
+//Ballene beveger seg ikke når programmet starter og ballenes størrelse 
 bool ballsMoving = false;
 float ballRadius = 0.005f;
 
@@ -59,16 +62,19 @@ float lastFrame = 0.0f;
 const float fixedTimeStep = 0.01f;
 float accumulator = 0.0f;
 
-// Omrdet p B-spline overflaten hvor det er hyere friksjon
+// Området på B-spline overflaten hvor det er høyere friksjon
 float frictionAreaXMin = 2.04f;
 float frictionAreaXMax = 2.1f;
 float frictionAreaYMin = 11.64f;
 float frictionAreaYMax = 11.7f;
 
-//Den lave friksjonen er p mesteparten av B-spline flaten og hye friksjonen er i omrdet avgrenset med hyere friksjon. 
+//Den lave friksjonen er på mesteparten av B-spline flaten og høye friksjonen er i området avgrenset med høyere friksjon. 
 float normalFriction = 0.01f;
 float highFriction = 0.5f;
 
+//Hvor lang tid (ms) hver frame kan bruke på å laste opp ressurser som er lest inn i bakgrunnen 
+const double uploadBudgetMilliseconds = 4.0;
+
 vector<glm::vec3> controlPoints =
 {
     glm::vec3(2.04f, 11.64f, 0.041f), glm::vec3(2.093f, 11.64f, 0.040f), glm::vec3(2.148f,11.64f, 0.037f), glm::vec3(2.199f,11.64f, 0.035f),
@@ -76,34 +82,24 @@ vector<glm::vec3> controlPoints =
     glm::vec3(2.04f, 11.76f, 0.044f), glm::vec3(2.093f, 11.76f, 0.039f), glm::vec3(2.148f, 11.76f, 0.044f), glm::vec3(2.199f,11.76f, 0.077f),
 };
 
-// Uniform skjtvektor horisontal retning
+// Uniform skjøtvektor horisontal retning
 vector<float> knotVectorU = { 0, 0, 0, 1, 2, 2, 2 };
-// Uniform skjtvektor vertikal retning 
+// Uniform skjøtvektor vertikal retning 
 vector<float> knotVectorV = { 0, 0, 0, 1, 1, 1 };
 
 //----------------------------------------------------------------------------------------------------------------------------------------------------//
 
 void framebuffer_size_callback(GLFWwindow* window, int width, int height);
 void processInput(GLFWwindow* window);
+void processLevelInput(GLFWwindow* window, BilinearSurface& bilinear, AssetPipeline& pipeline);
 void mouse_callback(GLFWwindow* window, double xpos, double ypos);
 void scroll_callback(GLFWwindow* window, double xoffset, double yoffset);
-unsigned int loadTexture(char const* path);
+unsigned int loadTexture(AssetPipeline& pipeline, const string& path);
+void uploadTexture(unsigned int textureID, const unsigned char* data, int width, int height, int nrComponents, const string& path);
 void selectStartPointForBall(Surface& surface, glm::vec3& ballPosition, float xMin, float xMax, float yMin, float yMax, float ballRadius);
 
 //-----------------------------------------------------------------------------------------------------------------------------------------------------//
 
-//Til punktskyen og normalene 
-string vfs = ShaderLoader::LoadShaderFromFile("vs.vs");
-string fs = ShaderLoader::LoadShaderFromFile("fs.fs");
-
-//PhongShader
-string vfsp = ShaderLoader::LoadShaderFromFile("phong.vert");
-string fsp = ShaderLoader::LoadShaderFromFile("phong.frag");
-
-//Tekstur shader til tekstur p ballene 
-string vfsT = ShaderLoader::LoadShaderFromFile("Texture.vs");
-string fsT = ShaderLoader::LoadShaderFromFile("Texture.fs");
-
 int main()
 {
     glfwInit();
@@ -132,9 +128,55 @@ int main()
     Shader ourShader("vs.vs", "fs.fs"); 
     Shader phongShader("phong.vert", "phong.frag");
     Shader textureShader("Texture.vs", "Texture.fs");
+    //BilinearSurface har oktaeder-kodede normaler og må tegnes med phongOctahedral.vert
+    Shader bilinearShader("phongOctahedral.vert", "phong.frag");
+    //Punktskyen lyssettes med PCA-normalene i hvert punkt
+    Shader pointsLitShader("pointsLit.vert", "phong.frag");
 
     glEnable(GL_DEPTH_TEST);
 
+    //Punktskyen og teksturene lastes i bakgrunnen mens brukeren velger startpunkter og scenen vises.
+    //bilinear må lages før pipelinen slik at pipelinen stopper først når programmet avsluttes.
+    BilinearSurface bilinear;
+    bilinear.setPointQuantization(true);
+    bilinear.setPyramidLevels(4);
+    bilinear.setTriangulationThreads(0);
+    bilinear.setPointNormals(true);
+    //B-spline flaten tilpasses punktene innenfor grensene til ballene, slik at den kan erstatte flaten fra
+    //kontrollpunktene over når punktskyen er lastet
+    SurfaceFitSettings fitSettings;
+    fitSettings.minCorner = glm::vec2(xMin, yMin);
+    fitSettings.maxCorner = glm::vec2(xMax, yMax);
+    bilinear.setSurfaceFit(fitSettings);
+    AssetPipeline pipeline;
+
+    //Katalogen over flisene i mappen. Flisene som overlapper området rundt B-spline flaten lastes parallelt.
+    //Er det ingen fliser i katalogen lastes den ene flisen direkte.
+    //Flaten lagres i SurfaceCache ved siden av den første flisen, så neste oppstart hopper over alle stegene.
+    bilinear.loadFunctionsAsync(pipeline, []()
+    {
+        TileCatalog catalog(BilinearSurface::tileTransform());
+        catalog.scan(".");
+        vector<TileInfo> sceneTiles = catalog.tilesOverlapping(glm::vec2(2.0f, 11.6f), glm::vec2(2.25f, 11.8f));
+        SurfaceSource source;
+        if (!sceneTiles.empty())
+        {
+            for (const TileInfo& tile : sceneTiles)
+            {
+                source.filenames.push_back(tile.filename);
+            }
+            source.loadCloud = [catalog, sceneTiles]() { return catalog.loadTiles(sceneTiles); };
+            return source;
+        }
+        source.filenames = { "32-2-517-155-12.txt" };
+        source.loadCloud = []() { return TileCatalog::loadTile("32-2-517-155-12.txt", BilinearSurface::tileTransform()); };
+        return source;
+    }, 0.0008f);
+
+    //Teksturen på ballene
+    unsigned int diffuseMap1 = loadTexture(pipeline, "Textures/ball.jpg");
+    unsigned int specularMap = loadTexture(pipeline, "Textures/ball2.jpg");
+
     Surface surface(controlPoints, 4, 3, knotVectorU, knotVectorV); 
     Octree octree(glm::vec3(xMin, yMin, xMin), glm::vec3(xMax, yMax, xMax), 0, 4, 4);
     PhysicsCalculations physics(xMin, xMax, yMin, yMax, ballRadius);
@@ -149,7 +191,7 @@ int main()
         balls.push_back(Ball(ballRadius, 30, 30, glm::vec3(1.0f, 1.0f, 1.0f)));
     }
 
-    //Antall punkter p B-spline flaten for  bestemme hvor "glatt" den skal vre 
+    //Antall punkter på B-spline flaten for å bestemme hvor "glatt" den skal være 
     int pointsOnTheSurface = 20;
 
     //Oppretter buffere og VAO for flaten 
@@ -164,7 +206,7 @@ int main()
         normalFriction, highFriction, frictionAreaXMin, frictionAreaXMax,
         frictionAreaYMin, frictionAreaYMax);
 
-    //Plassering av bellene p B-spline flaten. Ballene kan ikke plasseres utenfor 
+    //Plassering av bellene på B-spline flaten. Ballene kan ikke plasseres utenfor 
     cout << "Koordinatgrenser for flaten:"<< endl;
     cout << "x: [" << xMin << ", " << xMax << "]"<<endl;
     cout << "y: [" << yMin << ", " << yMax << "]"<<endl;
@@ -175,16 +217,11 @@ int main()
         selectStartPointForBall(surface, ballPositions[i], xMin, xMax, yMin, yMax, ballRadius);
     }
 
-    //Teksturen p ballene
-    unsigned int diffuseMap1 = loadTexture("Textures/ball.jpg");
-    unsigned int specularMap = loadTexture("Textures/ball2.jpg");
-
     textureShader.use();
     textureShader.setInt("material.diffuse", 0);
     textureShader.setInt("material.specular", 1);
 
-    BilinearSurface bilinear;
-    bilinear.loadFunctions("32-2-517-155-12.txt", 0.0008f);
+    bool fittedSurfaceInUse = false;
 
 
   while (!glfwWindowShouldClose(window))
@@ -194,6 +231,25 @@ int main()
         lastFrame = currentFrame;
 
         processInput(window);
+        processLevelInput(window, bilinear, pipeline);
+
+        //Laster opp det bakgrunnstrådene er ferdige med, innenfor tidsbudsjettet 
+        pipeline.processRenderJobs(uploadBudgetMilliseconds);
+
+        //Når punktskyen er lastet byttes flaten ut med B-spline flaten som er tilpasset punktene. Ballene og
+        //fysikken bruker samme u og v som før, siden flaten dekker det samme området. 
+        if (!fittedSurfaceInUse && bilinear.isSurfaceReady() && bilinear.hasFittedSurface())
+        {
+            surface = bilinear.getFittedSurface().toSurface();
+            unsigned int oldBuffers[] = { surfaceVBO, colorVBO, normalVBO, EBO, normalLineVBO };
+            glDeleteBuffers(5, oldBuffers);
+            glDeleteVertexArrays(1, &surfaceVAO);
+            glDeleteVertexArrays(1, &normalVAO);
+            surface.setupBuffers(surfaceVAO, surfaceVBO, colorVBO, normalVBO, EBO, normalVAO, normalLineVBO,
+                pointsOnTheSurface, frictionAreaXMin, frictionAreaXMax,
+                frictionAreaYMin, frictionAreaYMax);
+            fittedSurfaceInUse = true;
+        }
 
         glClearColor(0.529f, 0.808f, 0.922f, 1.0f);
         glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
@@ -223,7 +279,7 @@ int main()
         model = glm::translate(model, glm::vec3(0.0f, 0.0f, 0.0f));
         phongShader.setMat4("model", model);
 
-         //Rendrer bikvadratisk b- spline tensorprodukt flate med en del som har hyere friksjon
+         //Rendrer bikvadratisk b- spline tensorprodukt flate med en del som har høyere friksjon
        glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
        glBindVertexArray(surfaceVAO);
        glDrawElements(GL_TRIANGLES, pointsOnTheSurface * pointsOnTheSurface * 6, GL_UNSIGNED_INT, 0);
@@ -239,7 +295,37 @@ int main()
            }
        }
 
-       //bilinear.draw(phongShader, projection, view, model);
+       //Terrenget fra punktskyen, med de samme uniformene som phongShader
+       bilinearShader.use();
+       bilinearShader.setVec3("light.position", sunPos);
+       bilinearShader.setVec3("viewPos", camera.Position);
+       bilinearShader.setVec3("light.ambient", 0.2f, 0.3f, 0.2f);
+       bilinearShader.setVec3("light.diffuse", 0.3f, 0.5f, 0.3f);
+       bilinearShader.setVec3("light.specular", 0.4f, 0.4f, 0.4f);
+       bilinearShader.setVec3("material.ambient", 0.1f, 0.3f, 0.1f);
+       bilinearShader.setVec3("material.diffuse", 0.2f, 0.6f, 0.2f);
+       bilinearShader.setVec3("material.specular", 0.1f, 0.2f, 0.1f);
+       bilinearShader.setFloat("material.shininess", 16.0f);
+       bilinearShader.setMat4("projection", projection);
+       bilinearShader.setMat4("view", view);
+       bilinearShader.setMat4("model", model);
+       bilinear.draw(bilinearShader, projection, view, model);
+
+       //Punktskyen lyssatt uten triangulering, med normalene fra setPointNormals
+       pointsLitShader.use();
+       pointsLitShader.setVec3("light.position", sunPos);
+       pointsLitShader.setVec3("viewPos", camera.Position);
+       pointsLitShader.setVec3("light.ambient", 0.2f, 0.3f, 0.2f);
+       pointsLitShader.setVec3("light.diffuse", 0.3f, 0.5f, 0.3f);
+       pointsLitShader.setVec3("light.specular", 0.4f, 0.4f, 0.4f);
+       pointsLitShader.setVec3("material.ambient", 0.1f, 0.3f, 0.1f);
+       pointsLitShader.setVec3("material.diffuse", 0.2f, 0.6f, 0.2f);
+       pointsLitShader.setVec3("material.specular", 0.1f, 0.2f, 0.1f);
+       pointsLitShader.setFloat("material.shininess", 16.0f);
+       pointsLitShader.setMat4("projection", projection);
+       pointsLitShader.setMat4("view", view);
+       pointsLitShader.setMat4("model", model);
+       bilinear.drawPoints(pointsLitShader, projection, view, model);
 
        textureShader.use();
        textureShader.setVec3("light.position", sunPos);
@@ -265,15 +351,15 @@ int main()
                ballVelocities,         // Oppdaterer bellenes hastighet
                ballTrack,              // Oppdaterer sporenene til ballene 
                octree,                 // Octree for kollisjonsberegning
-               ballsMoving,            // Undersker om ballene beveger seg 
-               fixedTimeStep,          // For  f jevn hastighet p ballene 
-               ballRadius,             // Strrelsen/ radisuen p ballene 
-               xMin, xMax, yMin, yMax, // Strrelsen p B-spline flaten 
+               ballsMoving,            // Undersøker om ballene beveger seg 
+               fixedTimeStep,          // For å få jevn hastighet på ballene 
+               ballRadius,             // Størrelsen/ radisuen på ballene 
+               xMin, xMax, yMin, yMax, // Størrelsen på B-spline flaten 
                surface,                // Overflaten- B-spline flaten 
-               normalFriction,         // Friksjonen p strstedelen av flaten 
-               highFriction,           // Hyere friksjon p delen det lagt til friksjon 
-               frictionAreaXMin, frictionAreaXMax, // Friksjonsomrde i x-retning
-               frictionAreaYMin, frictionAreaYMax  // Friksjonsomrde i y-retning
+               normalFriction,         // Friksjonen på størstedelen av flaten 
+               highFriction,           // Høyere friksjon på delen det lagt til friksjon 
+               frictionAreaXMin, frictionAreaXMax, // Friksjonsområde i x-retning
+               frictionAreaYMin, frictionAreaYMax  // Friksjonsområde i y-retning
            );
            accumulator -= fixedTimeStep;
        }
@@ -284,7 +370,7 @@ int main()
        // Rendre ballene 
        for (int i = 0; i < ballPositions.size(); ++i)
        {
-           // Oppdaterer rotasjonen med tanke p hastigheten 
+           // Oppdaterer rotasjonen med tanke på hastigheten 
            balls[i].UpdateRotation(ballVelocities[i], deltaTime, ballsMoving);
            model = glm::mat4(1.0f);
            model = glm::translate(model, ballPositions[i]);
@@ -293,7 +379,7 @@ int main()
            balls[i].DrawBall();
        }
 
-        // Bruk ourShader til  rendre normalene
+        // Bruk ourShader til å rendre normalene
         ourShader.use();
         ourShader.setMat4("projection", projection);
         ourShader.setMat4("view", view);
@@ -327,13 +413,48 @@ void processInput(GLFWwindow* window)
     if (glfwGetKey(window, GLFW_KEY_D) == GLFW_PRESS)
         camera.ProcessKeyboard(RIGHT, deltaTime);
 
-    // Ballene begynner  bevege seg nr 'space' er trykket p 
+    // Ballene begynner å bevege seg når 'space' er trykket på 
     if (glfwGetKey(window, GLFW_KEY_SPACE) == GLFW_PRESS)
     {
         ballsMoving = true;
     }
 }
 
+//Page Down gir færre punkter (større celler) og Page Up flere. Nivået bygges i bakgrunnen.
+//T måler trianguleringen av punktene på 1 til alle kjernene og skriver speed-up til konsollen.
+void processLevelInput(GLFWwindow* window, BilinearSurface& bilinear, AssetPipeline& pipeline)
+{
+    static bool pageUpWasPressed = false;
+    static bool pageDownWasPressed = false;
+    static bool timingWasPressed = false;
+
+    bool pageUpPressed = glfwGetKey(window, GLFW_KEY_PAGE_UP) == GLFW_PRESS;
+    bool pageDownPressed = glfwGetKey(window, GLFW_KEY_PAGE_DOWN) == GLFW_PRESS;
+    bool timingPressed = glfwGetKey(window, GLFW_KEY_T) == GLFW_PRESS;
+
+    if (timingPressed && !timingWasPressed && bilinear.isSurfaceReady())
+    {
+        vector<glm::dvec2> points = bilinear.planarPoints();
+        pipeline.runOnWorker([points]()
+        {
+            printTriangulationSpeedup(points, workerCount());
+        });
+    }
+    timingWasPressed = timingPressed;
+
+    if (pageUpPressed && !pageUpWasPressed)
+    {
+        bilinear.selectPyramidLevel(pipeline, bilinear.getPyramidLevel() - 1);
+    }
+    if (pageDownPressed && !pageDownWasPressed)
+    {
+        bilinear.selectPyramidLevel(pipeline, bilinear.getPyramidLevel() + 1);
+    }
+
+    pageUpWasPressed = pageUpPressed;
+    pageDownWasPressed = pageDownPressed;
+}
+
 void framebuffer_size_callback(GLFWwindow* window, int width, int height)
 {
     glViewport(0, 0, width, height);
@@ -365,16 +486,34 @@ void scroll_callback(GLFWwindow* window, double xoffset, double yoffset)
     camera.ProcessMouseScroll(static_cast<float>(yoffset));
 }
 
-unsigned int loadTexture(char const* path)
+//Lager teksturen med en gang, men bildet leses og dekodes på en arbeidstråd. Selve opplastingen til
+//GPU-en gjøres på render-tråden når bildet er klart. Til da er teksturen tom. 
+unsigned int loadTexture(AssetPipeline& pipeline, const string& path)
 {
     unsigned int textureID;
     glGenTextures(1, &textureID);
 
-    int width, height, nrComponents;
-    unsigned char* data = stbi_load(path, &width, &height, &nrComponents, 0);
+    pipeline.runOnWorker([&pipeline, textureID, path]()
+    {
+        //Bildet eies av en shared_ptr som frigjør det med stbi_image_free, også hvis pipelinen stoppes før
+        //opplastingen har kjørt og jobben blir kastet. function krever at jobben kan kopieres, derfor ikke unique_ptr.
+        int width, height, nrComponents;
+        shared_ptr<unsigned char> data(stbi_load(path.c_str(), &width, &height, &nrComponents, 0), stbi_image_free);
+        pipeline.runOnRenderThread([textureID, data, width, height, nrComponents, path]()
+        {
+            uploadTexture(textureID, data.get(), width, height, nrComponents, path);
+        });
+    });
+
+    return textureID;
+}
+
+//data frigjøres av den som eier bildet (loadTexture) 
+void uploadTexture(unsigned int textureID, const unsigned char* data, int width, int height, int nrComponents, const string& path)
+{
     if (data)
     {
-        GLenum format;
+        GLenum format = GL_RGB;
         if (nrComponents == 1)
             format = GL_RED;
         else if (nrComponents == 3)
@@ -390,16 +529,11 @@ unsigned int loadTexture(char const* path)
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
         glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(data);
     }
     else
     {
         std::cout << "Texture failed to load at path: " << path << std::endl;
-        stbi_image_free(data);
     }
-
-    return textureID;
 }
 
 //Velger startposisjonen for ballene. Startposisjonen for ballene kan kun velges innenfor gitte koordinater. 
@@ -413,20 +547,20 @@ void selectStartPointForBall(Surface& surface, glm::vec3& ballPosition, float xM
     cout << "y (mellom " << yMin << " og " << yMax << "): ";
     cin >> y;
 
-    //clamp gjr at x og y verdiene til ballen er innenfor de gitte grensene. 
-    //Hvis brukeren setter vedier utenfor angitte koorfinater blir verdiene justert til nrmeste gyldig verdi. 
+    //clamp gjør at x og y verdiene til ballen er innenfor de gitte grensene. 
+    //Hvis brukeren setter vedier utenfor angitte koorfinater blir verdiene justert til nærmeste gyldig verdi. 
     x = glm::clamp(x, xMin, xMax);
     y = glm::clamp(y, yMin, yMax);
 
-    //Normaliserer koordinatene, brukes for hyderegning av z koordinaten 
+    //Normaliserer koordinatene, brukes for høyderegning av z koordinaten 
     float u = (x - xMin) / (xMax - xMin);
     float v = (y - yMin) / (yMax - yMin);
-    //Beregner hyden p B-spline flaten. 
+    //Beregner høyden på B-spline flaten. 
     glm::vec3 surfacePoint = surface.calculateSurfacePoint(u, v);
     //Den nye oppdaterte posisjonen til ballen 
     ballPosition = glm::vec3(x, y, surfacePoint.z + ballRadius);
 
-    cout << "Ballen er plassert p punkt (" << ballPosition.x << ", " << ballPosition.y << ", " << ballPosition.z << ")." << endl;
+    cout << "Ballen er plassert på punkt (" << ballPosition.x << ", " << ballPosition.y << ", " << ballPosition.z << ")." << endl;
 }
 
 
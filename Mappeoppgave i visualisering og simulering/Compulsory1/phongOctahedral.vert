@@ -0,0 +1,30 @@
+#version 330 core
+layout (location = 0) in vec3 aPos;
+layout (location = 1) in vec2 aNormal;
+
+out vec3 FragPos;
+out vec3 Normal;
+
+uniform mat4 model;
+uniform mat4 view;
+uniform mat4 projection;
+
+//Som phong.vert, men normalen er oktaeder-kodet i to normaliserte 16 bits heltall (encodeOctahedral i VertexNormals.h)
+vec3 decodeOctahedral(vec2 p)
+{
+    vec3 n = vec3(p, 1.0 - abs(p.x) - abs(p.y));
+    if (n.z < 0.0)
+    {
+        vec2 signs = vec2(p.x >= 0.0 ? 1.0 : -1.0, p.y >= 0.0 ? 1.0 : -1.0);
+        n.xy = (1.0 - abs(p.yx)) * signs;
+    }
+    return normalize(n);
+}
+
+void main()
+{
+    FragPos = vec3(model * vec4(aPos, 1.0));
+    Normal = mat3(transpose(inverse(model))) * decodeOctahedral(aNormal);  
+    
+    gl_Position = projection * view * vec4(FragPos, 1.0);
+} 
@@ -6,10 +6,13 @@ out vec3 ourColor; // output a color to the fragment shader
 uniform mat4 model;
 uniform mat4 view;
 uniform mat4 projection;
+// kvantiserte punkter (3 x uint16) gjøres om til float: origin + aPos * scale
+uniform vec3 positionOrigin = vec3(0.0);
+uniform vec3 positionScale = vec3(1.0);
 
 
 void main()
 {
-    gl_Position = projection * view * model* vec4(aPos, 1.0f);
+    gl_Position = projection * view * model* vec4(positionOrigin + aPos * positionScale, 1.0f);
     ourColor = aColor; // set ourColor to the input color we got from the vertex data
 }       
\ No newline at end of file
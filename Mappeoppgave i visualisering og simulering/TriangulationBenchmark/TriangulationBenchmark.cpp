@@ -0,0 +1,749 @@
+//Ytelsestest for trianguleringene i Compulsory1 (DelaunayTriangulator, parallelDelaunayTriangulation og
+//gridDelaunayTriangulation), uten vindu og OpenGL.
+//
+//Lager punktsett med fire fordelinger (jevn, klynger, rutenett og mange punkter på linjer) fra 1000 til 10 millioner
+//punkter, triangulerer dem og måler tid, trekanter per sekund og minnet trianguleringen bruker. Hvert resultat
+//sjekkes: alle trekantene er mot klokka, randen er konveks, antall trekanter stemmer med Euler, ingen punkter
+//mangler og hver indre kant er lokalt Delaunay (inCircleSymbolic, som trianguleringen selv bruker).
+//
+//Resultatene skrives som CSV, én linje per kjøring, slik at filer fra ulike versjoner kan legges etter hverandre
+//og sammenlignes. Finnes filen fra før legges linjene til på slutten. --label settes til f.eks commit-hashen.
+//Feiler en av sjekkene, skrives hvilke på konsollen og programmet avslutter med status 2.
+//
+//Bruk: TriangulationBenchmark [--sizes 1000,10000,...] [--distributions uniform,clustered,grid,collinear]
+//      [--triangulators serial,parallel,grid] [--threads n] [--repeat n] [--seed n] [--label tekst]
+//      [--output fil.csv] [--no-validate]
+//
+//Med --incircle måles i stedet inCircleBatch (InCircleBatch.h) med skalar, SSE2 og AVX2 kode: tester per sekund
+//og om alle nivåene gir samme svar som inCircleSymbolic. Resultatene går til incircle_benchmark.csv.
+
+#include "DelaunayTriangulator.h"
+#include "ParallelDelaunay.h"
+#include "GridDelaunay.h"
+#include "TriangleMesh.h"
+#include "Predicates.h"
+#include "Parallel.h"
+#include "InCircleBatch.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#ifdef _WIN32
+#define NOMINMAX
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace std;
+
+//Minnet som er allokert med new akkurat nå og det høyeste siden resetPeakHeap. Hver allokering får størrelsen
+//lagret foran seg, så delete vet hvor mye som frigjøres. Teller allokeringene på alle trådene.
+static atomic<size_t> heapCurrent{ 0 };
+static atomic<size_t> heapPeak{ 0 };
+static const size_t heapHeader = alignof(max_align_t);
+
+static void* trackedAllocate(size_t size)
+{
+    char* block = static_cast<char*>(malloc(size + heapHeader));
+    if (block == nullptr)
+    {
+        throw bad_alloc();
+    }
+    *reinterpret_cast<size_t*>(block) = size;
+    size_t current = heapCurrent.fetch_add(size, memory_order_relaxed) + size;
+    size_t peak = heapPeak.load(memory_order_relaxed);
+    while (current > peak && !heapPeak.compare_exchange_weak(peak, current, memory_order_relaxed))
+    {
+    }
+    return block + heapHeader;
+}
+
+static void trackedFree(void* pointer)
+{
+    if (pointer == nullptr)
+    {
+        return;
+    }
+    char* block = static_cast<char*>(pointer) - heapHeader;
+    heapCurrent.fetch_sub(*reinterpret_cast<size_t*>(block), memory_order_relaxed);
+    free(block);
+}
+
+void* operator new(size_t size) { return trackedAllocate(size); }
+void* operator new[](size_t size) { return trackedAllocate(size); }
+void operator delete(void* pointer) noexcept { trackedFree(pointer); }
+void operator delete[](void* pointer) noexcept { trackedFree(pointer); }
+void operator delete(void* pointer, size_t) noexcept { trackedFree(pointer); }
+void operator delete[](void* pointer, size_t) noexcept { trackedFree(pointer); }
+
+static void resetPeakHeap()
+{
+    heapPeak.store(heapCurrent.load());
+}
+
+//Høyeste minnebruk for hele prosessen så langt (working set på Windows, resident set ellers), i byte
+static size_t peakProcessMemory()
+{
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters;
+    if (GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters)))
+    {
+        return counters.PeakWorkingSetSize;
+    }
+    return 0;
+#else
+    rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    //ru_maxrss er i kilobyte på Linux
+    return static_cast<size_t>(usage.ru_maxrss) * 1024;
+#endif
+}
+
+//Punktsettene. Alle ligger i omtrent [0, sqrt(count)] i begge retninger, så tettheten er den samme for alle størrelser.
+
+static vector<glm::dvec2> uniformPoints(size_t count, mt19937_64& random)
+{
+    double side = sqrt(static_cast<double>(count));
+    uniform_real_distribution<double> coordinate(0.0, side);
+    vector<glm::dvec2> points(count);
+    for (auto& point : points)
+    {
+        point = glm::dvec2(coordinate(random), coordinate(random));
+    }
+    return points;
+}
+
+//Normalfordelte klynger av ulik størrelse, og 5% av punktene jevnt fordelt mellom dem
+static vector<glm::dvec2> clusteredPoints(size_t count, mt19937_64& random)
+{
+    double side = sqrt(static_cast<double>(count));
+    size_t clusterCount = max<size_t>(1, count / 5000);
+    uniform_real_distribution<double> coordinate(0.0, side);
+    uniform_real_distribution<double> spread(0.002 * side, 0.02 * side);
+
+    vector<glm::dvec2> centers(clusterCount);
+    vector<double> sizes(clusterCount);
+    for (size_t c = 0; c < clusterCount; ++c)
+    {
+        centers[c] = glm::dvec2(coordinate(random), coordinate(random));
+        sizes[c] = spread(random);
+    }
+
+    uniform_int_distribution<size_t> cluster(0, clusterCount - 1);
+    normal_distribution<double> offset(0.0, 1.0);
+    vector<glm::dvec2> points(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (i % 20 == 0)
+        {
+            points[i] = glm::dvec2(coordinate(random), coordinate(random));
+            continue;
+        }
+        size_t c = cluster(random);
+        points[i] = centers[c] + sizes[c] * glm::dvec2(offset(random), offset(random));
+    }
+    return points;
+}
+
+//Rad for rad i et kvadratisk rutenett med avstand 1, som fra reducePoints. Den siste raden er ikke full.
+//Alle rutene har fire punkter på samme sirkel, så dette tester inCircleSymbolic og gridDelaunayTriangulation.
+static vector<glm::dvec2> gridPoints(size_t count)
+{
+    size_t side = static_cast<size_t>(ceil(sqrt(static_cast<double>(count))));
+    vector<glm::dvec2> points(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        points[i] = glm::dvec2(static_cast<double>(i % side), static_cast<double>(i / side));
+    }
+    return points;
+}
+
+//Skannelinjer: 45% av punktene på vannrette linjer, 45% på loddrette og 10% jevnt fordelt. Punktene på en linje
+//har nøyaktig samme y (eller x), så mange av orient2d testene blir 0 og må avgjøres eksakt.
+static vector<glm::dvec2> collinearPoints(size_t count, mt19937_64& random)
+{
+    double side = sqrt(static_cast<double>(count));
+    size_t lineCount = max<size_t>(2, static_cast<size_t>(side / 4.0));
+    uniform_real_distribution<double> coordinate(0.0, side);
+    uniform_int_distribution<size_t> line(0, lineCount - 1);
+    double lineSpacing = side / static_cast<double>(lineCount);
+
+    vector<glm::dvec2> points(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        size_t kind = i % 20;
+        double position = (static_cast<double>(line(random)) + 0.5) * lineSpacing;
+        if (kind < 9)
+        {
+            points[i] = glm::dvec2(coordinate(random), position);
+        }
+        else if (kind < 18)
+        {
+            points[i] = glm::dvec2(position, coordinate(random));
+        }
+        else
+        {
+            points[i] = glm::dvec2(coordinate(random), coordinate(random));
+        }
+    }
+    return points;
+}
+
+static vector<glm::dvec2> generatePoints(const string& distribution, size_t count, uint64_t seed)
+{
+    mt19937_64 random(seed ^ (count * 0x9E3779B97F4A7C15ull));
+    if (distribution == "uniform")
+    {
+        return uniformPoints(count, random);
+    }
+    if (distribution == "clustered")
+    {
+        return clusteredPoints(count, random);
+    }
+    if (distribution == "grid")
+    {
+        return gridPoints(count);
+    }
+    return collinearPoints(count, random);
+}
+
+struct ValidationResult
+{
+    //Trekanter som ikke er mot klokka
+    size_t orientationErrors = 0;
+    //Indre kanter der punktet på andre siden ligger i den omskrevne sirkelen
+    size_t delaunayErrors = 0;
+    //Randkanter som ikke henger sammen til én lukket kurve
+    size_t boundaryErrors = 0;
+    //Hjørner på randen der randen svinger med klokka, dvs. randen er ikke det konvekse skallet
+    size_t convexityErrors = 0;
+    //Punkter som ikke er med i noen trekant, utenom punkter som ligger oppå et annet punkt
+    size_t missingPoints = 0;
+    //Antall trekanter er 2n - 2 - h for n punkter der h ligger på randen
+    bool eulerOk = true;
+
+    //Sjekkene som feilet, med antall feil, f.eks "konveks 3". Tom hvis alt er i orden.
+    string failures() const
+    {
+        string result;
+        auto add = [&](const char* name, size_t count)
+        {
+            if (count > 0)
+            {
+                result += (result.empty() ? "" : ", ") + string(name) + " " + to_string(count);
+            }
+        };
+        add("orientering", orientationErrors);
+        add("Delaunay", delaunayErrors);
+        add("rand", boundaryErrors);
+        add("konveks", convexityErrors);
+        add("mangler", missingPoints);
+        if (!eulerOk)
+        {
+            result += (result.empty() ? "" : ", ") + string("Euler");
+        }
+        return result;
+    }
+
+    bool valid() const
+    {
+        return orientationErrors == 0 && delaunayErrors == 0 && boundaryErrors == 0 && convexityErrors == 0 &&
+            missingPoints == 0 && eulerOk;
+    }
+};
+
+//Sjekker at trekantene er Delaunay trianguleringen av punktene. En triangulering som dekker det konvekse
+//skallet av punktene, og der alle kantene er lokalt Delaunay, er Delaunay trianguleringen. At skallet er dekket
+//følger av at randen er én konveks kurve og at Euler stemmer (ingen hull), og at alle punktene er med.
+static ValidationResult validateTriangulation(const vector<glm::dvec2>& points, const vector<glm::ivec3>& triangles,
+    unsigned int threadCount)
+{
+    ValidationResult result;
+    TriangleMesh mesh;
+    mesh.build(points.size(), triangles, threadCount);
+
+    //Trekantene og de indre kantene. Hver kant sjekkes fra trekanten med lavest indeks.
+    vector<size_t> orientationErrors(max(threadCount, 1u), 0);
+    vector<size_t> delaunayErrors(max(threadCount, 1u), 0);
+    parallelFor(triangles.size(), threadCount, [&](size_t begin, size_t end, unsigned int part)
+    {
+        for (size_t t = begin; t < end; ++t)
+        {
+            const glm::ivec3& v = triangles[t];
+            if (orient2d(points[v.x], points[v.y], points[v.z]) <= 0.0)
+            {
+                ++orientationErrors[part];
+            }
+            for (int i = 0; i < 3; ++i)
+            {
+                int across = mesh.neighbour(static_cast<int>(t), i);
+                if (across <= static_cast<int>(t))
+                {
+                    continue;
+                }
+                const glm::ivec3& other = triangles[across];
+                int opposite = other[0] + other[1] + other[2] - v[(i + 1) % 3] - v[(i + 2) % 3];
+                if (inCircleSymbolic(points[v.x], points[v.y], points[v.z], points[opposite]) > 0)
+                {
+                    ++delaunayErrors[part];
+                }
+            }
+        }
+    });
+    for (size_t part = 0; part < orientationErrors.size(); ++part)
+    {
+        result.orientationErrors += orientationErrors[part];
+        result.delaunayErrors += delaunayErrors[part];
+    }
+
+    //Randen går mot klokka, så for hver randkant a -> b er neste randkant den som starter i b
+    vector<int> nextOnBoundary(points.size(), -1);
+    size_t boundaryEdges = 0;
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            if (mesh.neighbour(static_cast<int>(t), i) >= 0)
+            {
+                continue;
+            }
+            int a = triangles[t][(i + 1) % 3];
+            int b = triangles[t][(i + 2) % 3];
+            if (nextOnBoundary[a] >= 0)
+            {
+                ++result.boundaryErrors;
+            }
+            nextOnBoundary[a] = b;
+            ++boundaryEdges;
+        }
+    }
+
+    size_t boundaryVertices = 0;
+    int firstBoundary = -1;
+    for (size_t a = 0; a < points.size(); ++a)
+    {
+        int b = nextOnBoundary[a];
+        if (b < 0)
+        {
+            continue;
+        }
+        ++boundaryVertices;
+        firstBoundary = static_cast<int>(a);
+        int c = nextOnBoundary[b];
+        if (c < 0)
+        {
+            ++result.boundaryErrors;
+        }
+        else if (orient2d(points[a], points[b], points[c]) < 0.0)
+        {
+            ++result.convexityErrors;
+        }
+    }
+
+    //Randen må være én lukket kurve gjennom alle randpunktene
+    if (firstBoundary >= 0)
+    {
+        size_t steps = 0;
+        int vertex = firstBoundary;
+        do
+        {
+            vertex = nextOnBoundary[vertex];
+            ++steps;
+        } while (vertex >= 0 && vertex != firstBoundary && steps <= boundaryEdges);
+        if (vertex != firstBoundary || steps != boundaryVertices)
+        {
+            ++result.boundaryErrors;
+        }
+    }
+
+    size_t usedVertices = 0;
+    for (size_t v = 0; v < points.size(); ++v)
+    {
+        usedVertices += mesh.vertexTriangle(static_cast<int>(v)) >= 0 ? 1 : 0;
+    }
+    result.eulerOk = triangles.empty() ? usedVertices == 0 : triangles.size() + 2 + boundaryVertices == 2 * usedVertices;
+
+    //Punkter som ligger oppå et annet punkt blir ikke med i trianguleringen
+    vector<glm::dvec2> sorted = points;
+    sort(sorted.begin(), sorted.end(), [](const glm::dvec2& a, const glm::dvec2& b)
+    {
+        return a.x < b.x || (a.x == b.x && a.y < b.y);
+    });
+    size_t distinct = sorted.empty() ? 0 : 1;
+    for (size_t i = 1; i < sorted.size(); ++i)
+    {
+        distinct += sorted[i] != sorted[i - 1] ? 1 : 0;
+    }
+    result.missingPoints = distinct > usedVertices ? distinct - usedVertices : 0;
+    if (usedVertices > distinct)
+    {
+        result.eulerOk = false;
+    }
+    return result;
+}
+
+struct BenchmarkOptions
+{
+    vector<size_t> sizes = { 1000, 10000, 100000, 1000000, 10000000 };
+    vector<string> distributions = { "uniform", "clustered", "grid", "collinear" };
+    vector<string> triangulators = { "serial", "parallel", "grid" };
+    unsigned int threads = workerCount();
+    unsigned int repeat = 1;
+    uint64_t seed = 1;
+    string label;
+    string output;
+    bool validate = true;
+    bool inCircle = false;
+};
+
+static vector<string> splitList(const string& text)
+{
+    vector<string> items;
+    stringstream stream(text);
+    string item;
+    while (getline(stream, item, ','))
+    {
+        if (!item.empty())
+        {
+            items.push_back(item);
+        }
+    }
+    return items;
+}
+
+static bool parseOptions(int argc, char** argv, BenchmarkOptions& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        string argument = argv[i];
+        if (argument == "--no-validate")
+        {
+            options.validate = false;
+            continue;
+        }
+        if (argument == "--incircle")
+        {
+            options.inCircle = true;
+            continue;
+        }
+        if (i + 1 >= argc)
+        {
+            cout << "Mangler verdi etter " << argument << endl;
+            return false;
+        }
+        string value = argv[++i];
+        if (argument == "--sizes")
+        {
+            options.sizes.clear();
+            for (const string& size : splitList(value))
+            {
+                options.sizes.push_back(static_cast<size_t>(stod(size)));
+            }
+        }
+        else if (argument == "--distributions")
+        {
+            options.distributions = splitList(value);
+        }
+        else if (argument == "--triangulators")
+        {
+            options.triangulators = splitList(value);
+        }
+        else if (argument == "--threads")
+        {
+            options.threads = max(stoi(value), 1);
+        }
+        else if (argument == "--repeat")
+        {
+            options.repeat = max(stoi(value), 1);
+        }
+        else if (argument == "--seed")
+        {
+            options.seed = stoull(value);
+        }
+        else if (argument == "--label")
+        {
+            options.label = value;
+        }
+        else if (argument == "--output")
+        {
+            options.output = value;
+        }
+        else
+        {
+            cout << "Ukjent argument " << argument << endl;
+            return false;
+        }
+    }
+
+    for (const string& distribution : options.distributions)
+    {
+        if (distribution != "uniform" && distribution != "clustered" && distribution != "grid" && distribution != "collinear")
+        {
+            cout << "Ukjent fordeling " << distribution << endl;
+            return false;
+        }
+    }
+    for (const string& triangulator : options.triangulators)
+    {
+        if (triangulator != "serial" && triangulator != "parallel" && triangulator != "grid")
+        {
+            cout << "Ukjent triangulering " << triangulator << endl;
+            return false;
+        }
+    }
+    if (options.output.empty())
+    {
+        options.output = options.inCircle ? "incircle_benchmark.csv" : "triangulation_benchmark.csv";
+    }
+    return true;
+}
+
+//Kjører én triangulering. Gir false hvis gridDelaunayTriangulation ikke ser et rutenett i punktene.
+static bool runTriangulator(const string& triangulator, const vector<glm::dvec2>& points, unsigned int threads,
+    vector<glm::ivec3>& triangles)
+{
+    if (triangulator == "serial")
+    {
+        triangles = parallelDelaunayTriangulation(points, 1);
+        return true;
+    }
+    if (triangulator == "parallel")
+    {
+        triangles = parallelDelaunayTriangulation(points, threads);
+        return true;
+    }
+    return gridDelaunayTriangulation(points, triangles, threads);
+}
+
+static const char* csvHeader = "label,distribution,points,triangulator,threads,seconds,triangles,triangles_per_second,"
+    "peak_heap_bytes,peak_process_bytes,exact_orient,exact_incircle,status,orientation_errors,delaunay_errors,"
+    "boundary_errors,missing_points,euler_ok,convexity_errors";
+
+//Måler inCircleBatch på trekantene fra en triangulering av jevnt fordelte punkter. Hvert kall tester ett punkt mot
+//64 trekanter som ligger etter hverandre ("batch"), eller mot 3 trekanter hentet med indekser ("gather", som
+//naboene i DelaunayTriangulator). Punktet ligger nær en av trekantene, så noen av testene treffer.
+static bool runInCircleBenchmark(const BenchmarkOptions& options, ofstream& csv)
+{
+    const size_t batchSize = 64;
+    size_t pointCount = options.sizes.empty() ? 100000 : min<size_t>(options.sizes.front(), 1000000);
+    vector<glm::dvec2> points = generatePoints("uniform", max<size_t>(pointCount, 1000), options.seed);
+    vector<glm::ivec3> triangles = parallelDelaunayTriangulation(points, 1);
+    TriangleSoA corners;
+    corners.resize(triangles.size());
+    for (size_t t = 0; t < triangles.size(); ++t)
+    {
+        corners.set(t, points[triangles[t].x], points[triangles[t].y], points[triangles[t].z]);
+    }
+
+    mt19937_64 random(options.seed);
+    uniform_int_distribution<size_t> window(0, triangles.size() - batchSize);
+    normal_distribution<double> noise(0.0, 0.5);
+    size_t queryCount = 1 << 16;
+    vector<size_t> firsts(queryCount);
+    vector<glm::ivec3> gathered(3 * queryCount);
+    vector<glm::dvec2> queries(queryCount);
+    for (size_t q = 0; q < queryCount; ++q)
+    {
+        firsts[q] = window(random);
+        const glm::ivec3& v = triangles[firsts[q] + q % batchSize];
+        queries[q] = (points[v.x] + points[v.y] + points[v.z]) / 3.0 + glm::dvec2(noise(random), noise(random));
+        for (int k = 0; k < 3; ++k)
+        {
+            gathered[3 * q + k] = triangles[window(random)];
+        }
+    }
+
+    //Svarene med skalar kode er fasit for de andre nivåene
+    SimdLevel best = supportedSimdLevel();
+    vector<SimdLevel> levels = { SimdLevel::Scalar };
+    if (best >= SimdLevel::SSE2)
+    {
+        levels.push_back(SimdLevel::SSE2);
+    }
+    if (best >= SimdLevel::AVX2)
+    {
+        levels.push_back(SimdLevel::AVX2);
+    }
+
+    bool allAgree = true;
+    for (const char* kernel : { "batch", "gather" })
+    {
+        bool gather = string(kernel) == "gather";
+        size_t testsPerCall = gather ? 3 : batchSize;
+        vector<uint64_t> reference;
+        double scalarSeconds = 0.0;
+        for (SimdLevel level : levels)
+        {
+            setInCircleBatchLevel(level);
+            vector<uint64_t> masks(queryCount);
+            double seconds = 0.0;
+            for (unsigned int run = 0; run < options.repeat; ++run)
+            {
+                auto start = chrono::steady_clock::now();
+                for (size_t q = 0; q < queryCount; ++q)
+                {
+                    masks[q] = gather ? inCircleGather(points, &gathered[3 * q], 3, queries[q])
+                        : inCircleBatch(corners, firsts[q], batchSize, queries[q]);
+                }
+                double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                seconds = run == 0 ? elapsed : min(seconds, elapsed);
+            }
+
+            size_t mismatches = 0;
+            if (level == SimdLevel::Scalar)
+            {
+                reference = masks;
+                scalarSeconds = seconds;
+            }
+            for (size_t q = 0; q < queryCount; ++q)
+            {
+                mismatches += masks[q] != reference[q] ? 1 : 0;
+            }
+            allAgree = allAgree && mismatches == 0;
+
+            double tests = static_cast<double>(queryCount * testsPerCall);
+            cout << "inCircle " << kernel << " " << simdLevelName(level) << ": " << fixed << setprecision(1)
+                << tests / seconds / 1.0e6 << " M tester/s, speed-up " << setprecision(2) << scalarSeconds / seconds
+                << (mismatches == 0 ? "" : ", ulike svar!") << endl;
+            cout.unsetf(ios::fixed);
+            cout << setprecision(6);
+            csv << options.label << "," << kernel << "," << simdLevelName(level) << "," << testsPerCall << ","
+                << queryCount * testsPerCall << "," << setprecision(9) << seconds << "," << setprecision(6)
+                << tests / seconds << "," << scalarSeconds / seconds << "," << mismatches << "\n";
+        }
+    }
+    setInCircleBatchLevel(supportedSimdLevel());
+    return allAgree;
+}
+
+int main(int argc, char** argv)
+{
+    BenchmarkOptions options;
+    if (!parseOptions(argc, argv, options))
+    {
+        return 1;
+    }
+
+    if (options.inCircle)
+    {
+        bool writeHeader = !ifstream(options.output).good();
+        ofstream csv(options.output, ios::app);
+        if (!csv)
+        {
+            cout << "Kan ikke skrive til " << options.output << endl;
+            return 1;
+        }
+        if (writeHeader)
+        {
+            csv << "label,kernel,level,triangles_per_call,tests,seconds,tests_per_second,speedup,mismatches\n";
+        }
+        return runInCircleBenchmark(options, csv) ? 0 : 2;
+    }
+
+    bool writeHeader = !ifstream(options.output).good();
+    ofstream csv(options.output, ios::app);
+    if (!csv)
+    {
+        cout << "Kan ikke skrive til " << options.output << endl;
+        return 1;
+    }
+    if (writeHeader)
+    {
+        csv << csvHeader << "\n";
+    }
+
+    bool allValid = true;
+    for (const string& distribution : options.distributions)
+    {
+        for (size_t size : options.sizes)
+        {
+            vector<glm::dvec2> points = generatePoints(distribution, size, options.seed);
+
+            for (const string& triangulator : options.triangulators)
+            {
+                unsigned int threads = triangulator == "serial" ? 1 : options.threads;
+                vector<glm::ivec3> triangles;
+                double seconds = 0.0;
+                size_t peakHeap = 0;
+                PredicateStatistics predicates;
+                bool accepted = true;
+
+                //Den raskeste av kjøringene teller. Minnet måles som det meste som var allokert i tillegg til
+                //punktene mens trianguleringen pågikk, inkludert resultatet.
+                for (unsigned int run = 0; run < options.repeat && accepted; ++run)
+                {
+                    triangles.clear();
+                    triangles.shrink_to_fit();
+                    size_t heapBefore = heapCurrent.load();
+                    resetPeakHeap();
+                    PredicateStatistics before = predicateStatistics();
+                    auto start = chrono::steady_clock::now();
+                    accepted = runTriangulator(triangulator, points, threads, triangles);
+                    double elapsed = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+                    PredicateStatistics after = predicateStatistics();
+                    size_t heap = heapPeak.load() - heapBefore;
+
+                    if (run == 0 || elapsed < seconds)
+                    {
+                        seconds = elapsed;
+                        predicates.orientExact = after.orientExact - before.orientExact;
+                        predicates.inCircleExact = after.inCircleExact - before.inCircleExact;
+                    }
+                    peakHeap = max(peakHeap, heap);
+                }
+
+                if (!accepted)
+                {
+                    cout << distribution << " " << size << " " << triangulator << ": ikke et rutenett" << endl;
+                    csv << options.label << "," << distribution << "," << size << "," << triangulator << "," << threads
+                        << ",,,,,,,,rejected,,,,,,\n";
+                    continue;
+                }
+
+                ValidationResult validation;
+                string status = "unchecked";
+                string failures;
+                if (options.validate)
+                {
+                    validation = validateTriangulation(points, triangles, options.threads);
+                    status = validation.valid() ? "ok" : "invalid";
+                    failures = validation.failures();
+                    allValid = allValid && validation.valid();
+                }
+
+                double trianglesPerSecond = seconds > 0.0 ? triangles.size() / seconds : 0.0;
+                cout << distribution << " " << size << " " << triangulator << " (" << threads << " tråder): "
+                    << fixed << setprecision(1) << seconds * 1000.0 << " ms, " << triangles.size() << " trekanter, "
+                    << setprecision(2) << trianglesPerSecond / 1.0e6 << " M trekanter/s, "
+                    << setprecision(1) << peakHeap / (1024.0 * 1024.0) << " MB, " << status
+                    << (failures.empty() ? "" : " (" + failures + ")") << endl;
+                cout.unsetf(ios::fixed);
+                cout << setprecision(6);
+
+                csv << options.label << "," << distribution << "," << size << "," << triangulator << "," << threads << ","
+                    << setprecision(9) << seconds << "," << triangles.size() << "," << setprecision(6)
+                    << trianglesPerSecond << "," << peakHeap << "," << peakProcessMemory() << ","
+                    << predicates.orientExact << "," << predicates.inCircleExact << "," << status << ","
+                    << validation.orientationErrors << "," << validation.delaunayErrors << ","
+                    << validation.boundaryErrors << "," << validation.missingPoints << ","
+                    << (validation.eulerOk ? 1 : 0) << "," << validation.convexityErrors << "\n";
+                csv.flush();
+            }
+        }
+    }
+
+    cout << "Resultatene er lagt til i " << options.output << endl;
+    return allValid ? 0 : 2;
+}